@@ -0,0 +1,103 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/AsyncFileReader.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Writes the file back and drops it from the page cache, so the next read comes from disk
+static void dropFromPageCache(const std::string& filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+static const char* backendName(AsyncFileReader::Backend backend)
+{
+    return backend == AsyncFileReader::Backend::IoUring ? "io_uring" : "read_ahead_thread";
+}
+
+// Cold-cache reads of a large order file with ifstream against the asynchronous reader's
+// backends, then full replays through the ifstream path and processOrdersAsync.
+// Usage: AsyncIngestBenchmark [commands]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 10000000;
+    const std::string filename = "async_ingest_benchmark.txt";
+    {
+        std::ofstream file(filename, std::ios::trunc);
+        for (const Command& command : generateCommands(numberOfCommands, 1, 42))
+        {
+            file << formatCommand(command) << "\n";
+        }
+    }
+    AsyncFileReader probe;
+    probe.open(filename);
+    double megabytes = probe.getFileSize() / 1e6;
+    std::cout << "file_mb: " << megabytes << ", io_uring: " << AsyncFileReader::isIoUringSupported()
+    << ", o_direct: " << probe.isDirect() << std::endl;
+    probe.close();
+
+    std::cout << "read,ms,mb_per_s" << std::endl;
+    dropFromPageCache(filename);
+    std::int64_t start = benchmarkNanoseconds();
+    {
+        std::ifstream file(filename, std::ios::binary);
+        std::vector<char> buffer(1 << 20);
+        while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+        {
+        }
+    }
+    std::int64_t elapsed = benchmarkNanoseconds() - start;
+    std::cout << "ifstream," << elapsed / 1e6 << "," << megabytes / (elapsed / 1e9) << std::endl;
+    for (AsyncFileReader::Backend backend : {AsyncFileReader::Backend::IoUring, AsyncFileReader::Backend::ReadAheadThread})
+    {
+        dropFromPageCache(filename);
+        start = benchmarkNanoseconds();
+        AsyncFileReader reader;
+        reader.open(filename, backend);
+        const char* data;
+        std::size_t size;
+        while (reader.next(data, size))
+        {
+        }
+        elapsed = benchmarkNanoseconds() - start;
+        std::cout << backendName(reader.getBackend()) << "," << elapsed / 1e6 << "," << megabytes / (elapsed / 1e9) << std::endl;
+    }
+
+    std::cout << "replay,ms,commands_per_s,matches_ifstream" << std::endl;
+    dropFromPageCache(filename);
+    Book* sequential = new Book();
+    start = benchmarkNanoseconds();
+    std::vector<Command> commands = OrderPipeline::loadCommandsFromFile(filename);
+    for (const Command& command : commands)
+    {
+        applyCommand(sequential, command);
+    }
+    elapsed = benchmarkNanoseconds() - start;
+    std::cout << "ifstream," << elapsed / 1e6 << "," << commands.size() / (elapsed / 1e9) << ",1" << std::endl;
+    for (AsyncFileReader::Backend backend : {AsyncFileReader::Backend::IoUring, AsyncFileReader::Backend::ReadAheadThread})
+    {
+        dropFromPageCache(filename);
+        Book* book = new Book();
+        OrderPipeline pipeline(book);
+        start = benchmarkNanoseconds();
+        std::size_t applied = pipeline.processOrdersAsync(filename, backend);
+        elapsed = benchmarkNanoseconds() - start;
+        std::cout << backendName(backend) << "," << elapsed / 1e6 << "," << applied / (elapsed / 1e9) << ","
+        << (book->getStateHash() == sequential->getStateHash()) << std::endl;
+        delete book;
+    }
+
+    delete sequential;
+    std::remove(filename.c_str());
+    return 0;
+}
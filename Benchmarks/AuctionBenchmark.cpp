@@ -0,0 +1,63 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Opening auction of 1M limit orders, half buys and half sells, priced over the same 201 ticks
+// so most of them cross. The auction times queueing the orders, finding the auction price and
+// the uncross, while continuous adds the same orders to a book that matches each on arrival.
+// Usage: AuctionBenchmark [orders] [trials]
+int main(int argc, char* argv[])
+{
+    int numberOfOrders = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int trials = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> priceDist(9900, 10100);
+    std::uniform_int_distribution<> sharesDist(1, 100);
+    std::vector<int> prices, shares;
+    for (int i = 0; i < numberOfOrders; i++)
+    {
+        prices.push_back(priceDist(gen));
+        shares.push_back(sharesDist(gen));
+    }
+
+    std::cout << "method,orders,trials,add_ms,price_us,uncross_ms,traded" << std::endl;
+    for (std::string method : {"auction", "continuous"})
+    {
+        std::vector<std::int64_t> addTimes, priceTimes, uncrossTimes;
+        int traded = 0;
+        for (int trial = 0; trial < trials; trial++)
+        {
+            Book* book = new Book();
+            if (method == "auction")
+            {
+                book->startAuction();
+            }
+            std::int64_t start = benchmarkNanoseconds();
+            for (int i = 0; i < numberOfOrders; i++)
+            {
+                book->addLimitOrder(i + 1, i % 2 == 0, shares[i], prices[i]);
+            }
+            addTimes.push_back(benchmarkNanoseconds() - start);
+
+            if (method == "auction")
+            {
+                int price, volume;
+                start = benchmarkNanoseconds();
+                book->getAuctionPrice(price, volume);
+                priceTimes.push_back(benchmarkNanoseconds() - start);
+                start = benchmarkNanoseconds();
+                traded = book->uncrossAuction();
+                uncrossTimes.push_back(benchmarkNanoseconds() - start);
+            }
+            delete book;
+        }
+        std::cout << method << "," << numberOfOrders << "," << trials << "," << percentile(addTimes, 50) / 1e6 << ","
+        << percentile(priceTimes, 50) / 1e3 << "," << percentile(uncrossTimes, 50) / 1e6 << "," << traded << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef BENCHMARKUTILS_HPP
+#define BENCHMARKUTILS_HPP
+
+#include "../Process_Orders/Command.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+inline std::int64_t benchmarkNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Value at the given percentile (0-100) of a set of latencies, sorts the input
+inline std::int64_t percentile(std::vector<std::int64_t>& values, double pct)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    std::size_t index = static_cast<std::size_t>(pct / 100.0 * (values.size() - 1));
+    return values[index];
+}
+
+// Generate a stream of limit order adds, cancels and modifies that never crosses the book,
+// so it can be interleaved with other streams on the same book using disjoint order ids.
+// Buys rest below 300 and sells above 300, following the generator's centre of book.
+inline std::vector<Command> generateCommands(int count, int firstOrderId, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> actionDist(0.0, 1.0);
+    std::uniform_int_distribution<> sharesDist(1, 1000);
+    std::uniform_int_distribution<> offsetDist(1, 50);
+    std::uniform_int_distribution<> buyOrSellDist(0, 1);
+
+    std::vector<Command> commands;
+    commands.reserve(count);
+    std::vector<Command> liveOrders;
+    int orderId = firstOrderId;
+
+    while (static_cast<int>(commands.size()) < count)
+    {
+        double action = actionDist(gen);
+        if (liveOrders.size() < 100 || action < 0.5)
+        {
+            bool buyOrSell = buyOrSellDist(gen);
+            int limitPrice = buyOrSell ? 300 - offsetDist(gen) : 300 + offsetDist(gen);
+            Command command{CommandType::AddLimit, buyOrSell, orderId++, sharesDist(gen), limitPrice, 0};
+            commands.push_back(command);
+            liveOrders.push_back(command);
+        } else {
+            std::uniform_int_distribution<std::size_t> liveDist(0, liveOrders.size() - 1);
+            std::size_t index = liveDist(gen);
+            Command& live = liveOrders[index];
+            if (action < 0.8)
+            {
+                commands.push_back(Command{CommandType::CancelLimit, live.buyOrSell, live.orderId, 0, 0, 0});
+                live = liveOrders.back();
+                liveOrders.pop_back();
+            } else {
+                live.limitPrice = live.buyOrSell ? 300 - offsetDist(gen) : 300 + offsetDist(gen);
+                live.shares = sharesDist(gen);
+                commands.push_back(Command{CommandType::ModifyLimit, live.buyOrSell, live.orderId, live.shares, live.limitPrice, 0});
+            }
+        }
+    }
+    return commands;
+}
+
+#endif
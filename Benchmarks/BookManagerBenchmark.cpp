@@ -0,0 +1,62 @@
+#include "BenchmarkUtils.hpp"
+#include "../Matching_Engine/BookManager.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of symbol sharded matching from 1 matching thread up to all cores.
+// Usage: BookManagerBenchmark [symbols] [commands per symbol]
+int main(int argc, char* argv[])
+{
+    int numberOfSymbols = argc > 1 ? std::stoi(argv[1]) : 256;
+    int commandsPerSymbol = argc > 2 ? std::stoi(argv[2]) : 20000;
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Interleave the per symbol streams so every shard is fed throughout the run
+    std::vector<std::vector<Command>> streams;
+    for (int symbolId = 0; symbolId < numberOfSymbols; symbolId++)
+    {
+        streams.push_back(generateCommands(commandsPerSymbol, 1, 42 + symbolId));
+    }
+    std::vector<Command> commands;
+    commands.reserve(static_cast<std::size_t>(numberOfSymbols) * commandsPerSymbol);
+    for (int i = 0; i < commandsPerSymbol; i++)
+    {
+        for (int symbolId = 0; symbolId < numberOfSymbols; symbolId++)
+        {
+            Command command = streams[symbolId][i];
+            command.symbolId = symbolId;
+            commands.push_back(command);
+        }
+    }
+
+    std::cout << "threads,symbols,commands,orders_per_second,p99_ns" << std::endl;
+    for (int threads = 1; threads <= maxThreads; threads++)
+    {
+        BookManager* manager = new BookManager(threads);
+        for (int symbolId = 0; symbolId < numberOfSymbols; symbolId++)
+        {
+            manager->addSymbol("SYM" + std::to_string(symbolId));
+        }
+        manager->setRecordLatencies(true);
+        manager->start();
+
+        std::int64_t start = benchmarkNanoseconds();
+        for (const Command& command : commands)
+        {
+            manager->submit(command);
+        }
+        manager->stop();
+        std::int64_t stop = benchmarkNanoseconds();
+
+        std::vector<std::int64_t> latencies = manager->getLatencies();
+        double ordersPerSecond = commands.size() * 1e9 / (stop - start);
+        std::cout << threads << "," << numberOfSymbols << "," << commands.size() << ","
+        << static_cast<long long>(ordersPerSecond) << "," << percentile(latencies, 99) << std::endl;
+
+        delete manager;
+    }
+    return 0;
+}
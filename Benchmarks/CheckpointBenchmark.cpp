@@ -0,0 +1,72 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Persistence/ForkCheckpointer.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Latency of the matching thread with and without a fork checkpoint running in the background.
+// Usage: CheckpointBenchmark [resting orders] [commands per phase]
+int main(int argc, char* argv[])
+{
+    int restingOrders = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int numberOfCommands = argc > 2 ? std::stoi(argv[2]) : 1000000;
+    const std::string filename = "checkpoint_benchmark.snapshot";
+
+    Book* book = new Book();
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 1000);
+    std::uniform_int_distribution<> levelDist(1, 200);
+    // Resting orders sit behind the prices used by the command stream and use later order ids
+    for (int orderId = 1; orderId <= restingOrders; orderId++)
+    {
+        bool buyOrSell = orderId % 2 == 0;
+        book->addLimitOrder(2 * numberOfCommands + orderId, buyOrSell, sharesDist(gen), buyOrSell ? 250 - levelDist(gen) : 350 + levelDist(gen));
+    }
+    std::vector<Command> commands = generateCommands(2 * numberOfCommands, 1, 7);
+
+    // Phase one runs with no checkpoint, phase two keeps a checkpoint running back to back
+    ForkCheckpointer checkpointer;
+    std::vector<std::int64_t> baseline, duringCheckpoint;
+    std::int64_t forkTotal = 0, durationTotal = 0;
+    baseline.reserve(numberOfCommands);
+    duringCheckpoint.reserve(numberOfCommands);
+    for (int i = 0; i < 2 * numberOfCommands; i++)
+    {
+        bool checkpointPhase = i >= numberOfCommands;
+        if (checkpointPhase && checkpointer.poll())
+        {
+            if (checkpointer.getCheckpointCount() > 0 && checkpointer.getLastSucceeded())
+            {
+                durationTotal += checkpointer.getLastDurationNanoseconds();
+            }
+            checkpointer.start(book, filename, i);
+            forkTotal += checkpointer.getLastForkNanoseconds();
+        }
+        std::int64_t start = benchmarkNanoseconds();
+        applyCommand(book, commands[i]);
+        std::int64_t latency = benchmarkNanoseconds() - start;
+        (checkpointPhase ? duringCheckpoint : baseline).push_back(latency);
+    }
+    checkpointer.wait();
+    durationTotal += checkpointer.getLastDurationNanoseconds();
+    int checkpoints = checkpointer.getCheckpointCount();
+
+    std::cout << "phase,p50_ns,p99_ns,p99.9_ns,max_ns" << std::endl;
+    for (auto* latencies : {&baseline, &duringCheckpoint})
+    {
+        std::cout << (latencies == &baseline ? "no_checkpoint" : "checkpoint_running") << ","
+        << percentile(*latencies, 50) << "," << percentile(*latencies, 99) << ","
+        << percentile(*latencies, 99.9) << "," << percentile(*latencies, 100) << std::endl;
+    }
+    std::cout << "resting_orders,checkpoints,avg_fork_us,avg_duration_ms,snapshot_bytes" << std::endl;
+    std::cout << restingOrders << "," << checkpoints << "," << forkTotal / 1000.0 / checkpoints << ","
+    << durationTotal / 1000000.0 / checkpoints << "," << checkpointer.getLastSize() << std::endl;
+
+    std::remove(filename.c_str());
+    delete book;
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Latency of commands while good till time orders expire. 100k orders rest away from the
+// inside, half of them expiring together at one tick and the rest spread over the run. The
+// clock moves one tick every 1000 commands and each command first cancels at most the expiry
+// budget of expired orders, so the budget decides how much of the burst one command pays for.
+// Usage: ExpiryBenchmark [commands]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int ticks = numberOfCommands / 1000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 100);
+    std::uniform_int_distribution<> depthDist(20, 120);
+    std::uniform_int_distribution<> tickDist(1, ticks);
+    std::vector<int> shares, depths, expiries;
+    for (int i = 0; i < numberOfCommands; i++)
+    {
+        shares.push_back(sharesDist(gen));
+        depths.push_back(depthDist(gen));
+    }
+    for (int i = 0; i < 100000; i++)
+    {
+        expiries.push_back(i % 2 == 0 ? ticks / 2 : tickDist(gen));
+    }
+
+    std::cout << "budget,commands,mean_ns,p50_ns,p99_ns,max_ns" << std::endl;
+    for (int budget : {INT_MAX, 256, 16})
+    {
+        Book* book = new Book();
+        int orderId = 1;
+        for (int level = 1; level <= 10; level++)
+        {
+            book->addLimitOrder(orderId++, true, 100, 1000 - level);
+            book->addLimitOrder(orderId++, false, 100, 1000 + level);
+        }
+        for (int i = 0; i < static_cast<int>(expiries.size()); i++)
+        {
+            bool buyOrSell = i % 2 == 0;
+            book->addGoodTillTimeOrder(orderId++, buyOrSell, 100, buyOrSell ? 1000 - depths[i] : 1000 + depths[i], expiries[i]);
+        }
+
+        std::vector<std::int64_t> latencies;
+        latencies.reserve(numberOfCommands);
+        int restingId = 0;
+        for (int i = 0; i < numberOfCommands; i++)
+        {
+            std::int64_t start = benchmarkNanoseconds();
+            book->advanceTime(i / 1000, budget);
+            if (i % 2 == 0)
+            {
+                restingId = orderId++;
+                book->addLimitOrder(restingId, i % 4 == 0, shares[i], i % 4 == 0 ? 1000 - depths[i] : 1000 + depths[i]);
+            } else {
+                book->cancelLimitOrder(restingId);
+            }
+            latencies.push_back(benchmarkNanoseconds() - start);
+        }
+
+        std::int64_t total = 0;
+        for (std::int64_t latency : latencies)
+        {
+            total += latency;
+        }
+        std::cout << (budget == INT_MAX ? std::string("unlimited") : std::to_string(budget)) << "," << numberOfCommands << ","
+        << total / numberOfCommands << "," << percentile(latencies, 50) << "," << percentile(latencies, 99) << ","
+        << *std::max_element(latencies.begin(), latencies.end()) << std::endl;
+        delete book;
+    }
+    return 0;
+}
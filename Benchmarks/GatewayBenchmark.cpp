@@ -0,0 +1,67 @@
+#include "BenchmarkUtils.hpp"
+#include "../Matching_Engine/OrderGateway.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput and submit to completion latency of the order gateway with 1 to 16 producers.
+// Usage: GatewayBenchmark [commands per producer]
+int main(int argc, char* argv[])
+{
+    int commandsPerProducer = argc > 1 ? std::stoi(argv[1]) : 200000;
+
+    std::cout << "producers,commands,orders_per_second,p50_ns,p99_ns" << std::endl;
+    for (int producers = 1; producers <= 16; producers *= 2)
+    {
+        std::vector<std::vector<Command>> streams;
+        for (int i = 0; i < producers; i++)
+        {
+            streams.push_back(generateCommands(commandsPerProducer, 1 + i * commandsPerProducer, 42 + i));
+        }
+
+        Book* book = new Book();
+        OrderGateway* gateway = new OrderGateway(book);
+        gateway->setRecordLatencies(true);
+        std::vector<ClientSession*> sessions;
+        for (int i = 0; i < producers; i++)
+        {
+            sessions.push_back(gateway->connect());
+        }
+        gateway->start();
+
+        std::int64_t start = benchmarkNanoseconds();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; i++)
+        {
+            threads.emplace_back([&, i]() {
+                std::uint64_t lastSequence = 0;
+                for (const Command& command : streams[i])
+                {
+                    lastSequence = sessions[i]->submit(command);
+                }
+                sessions[i]->waitFor(lastSequence);
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        std::int64_t stop = benchmarkNanoseconds();
+        gateway->stop();
+
+        std::vector<std::int64_t> latencies = gateway->getLatencies();
+        long long totalCommands = static_cast<long long>(producers) * commandsPerProducer;
+        double ordersPerSecond = totalCommands * 1e9 / (stop - start);
+        std::int64_t p50 = percentile(latencies, 50);
+        std::int64_t p99 = percentile(latencies, 99);
+        std::cout << producers << "," << totalCommands << "," << static_cast<long long>(ordersPerSecond)
+        << "," << p50 << "," << p99 << std::endl;
+
+        delete gateway;
+        delete book;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Cost of refilling a filled slice of displayed size: the book replenishing an iceberg from its
+// reserve, against a participant submitting a fresh limit order for the next slice after every fill.
+// Usage: IcebergBenchmark [slices]
+int main(int argc, char* argv[])
+{
+    int numberOfSlices = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    const int orderCount = 10;
+    const int displayShares = 100;
+
+    std::cout << "mode,slices,mean_ns,p50_ns,p99_ns" << std::endl;
+    for (bool iceberg : {true, false})
+    {
+        Book* book = new Book();
+        int orderId = 1;
+        for (int i = 0; i < orderCount; i++)
+        {
+            if (iceberg)
+            {
+                book->addIcebergOrder(orderId++, false, displayShares * (numberOfSlices / orderCount + 1), 101, displayShares);
+            } else {
+                book->addLimitOrder(orderId++, false, displayShares, 101);
+            }
+        }
+        // A level that never empties keeps the tree out of the measurement
+        book->addLimitOrder(orderId++, false, displayShares, 102);
+
+        std::vector<std::int64_t> latencies;
+        latencies.reserve(numberOfSlices);
+        for (int i = 0; i < numberOfSlices; i++)
+        {
+            std::int64_t start = benchmarkNanoseconds();
+            book->marketOrder(orderId++, true, displayShares);
+            if (!iceberg)
+            {
+                book->addLimitOrder(orderId++, false, displayShares, 101);
+            }
+            latencies.push_back(benchmarkNanoseconds() - start);
+        }
+
+        std::int64_t total = 0;
+        for (std::int64_t latency : latencies)
+        {
+            total += latency;
+        }
+        std::cout << (iceberg ? "iceberg_replenish" : "limit_resubmit") << "," << numberOfSlices << ","
+        << total / numberOfSlices << "," << percentile(latencies, 50) << "," << percentile(latencies, 99) << std::endl;
+        delete book;
+    }
+    return 0;
+}
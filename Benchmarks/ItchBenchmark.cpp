@@ -0,0 +1,114 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/ItchReader.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Live order in the synthetic feed
+struct SyntheticOrder {
+    std::uint64_t reference;
+    bool buyOrSell;
+    int shares;
+};
+
+// Writes an ITCH feed for two symbols where adds cluster near the touch and most orders are
+// cancelled rather than executed, roughly the message mix of a liquid NASDAQ stock
+static void writeSyntheticFeed(const std::string& filename, int numberOfMessages)
+{
+    ItchWriter writer;
+    writer.stockDirectory(1, "AAPL");
+    writer.stockDirectory(2, "MSFT");
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> actionDist(0.0, 1.0);
+    std::geometric_distribution<> depthDist(0.15);
+    std::uniform_int_distribution<> lotDist(1, 10);
+    std::vector<SyntheticOrder> live[2];
+    std::uint64_t nextReference = 1;
+
+    for (int i = 0; i < numberOfMessages; i++)
+    {
+        int symbol = i % 4 == 0 ? 1 : 0;
+        std::vector<SyntheticOrder>& orders = live[symbol];
+        double action = actionDist(gen);
+        if (orders.size() < 100 || action < 0.45)
+        {
+            bool buyOrSell = actionDist(gen) < 0.5;
+            int ticks = 1 + depthDist(gen);
+            int price = 1000000 + (buyOrSell ? -ticks : ticks) * 100;
+            int shares = lotDist(gen) * 100;
+            writer.addOrder(symbol + 1, nextReference, buyOrSell, shares, symbol == 0 ? "AAPL" : "MSFT", price);
+            orders.push_back(SyntheticOrder{nextReference++, buyOrSell, shares});
+            continue;
+        }
+        std::uniform_int_distribution<std::size_t> pick(0, orders.size() - 1);
+        std::size_t index = pick(gen);
+        SyntheticOrder& order = orders[index];
+        if (action < 0.80)
+        {
+            writer.orderDelete(symbol + 1, order.reference);
+            order = orders.back();
+            orders.pop_back();
+        } else if (action < 0.88 && order.shares > 100) {
+            writer.orderCancel(symbol + 1, order.reference, 100);
+            order.shares -= 100;
+        } else if (action < 0.95) {
+            int executed = order.shares > 100 ? 100 : order.shares;
+            writer.orderExecuted(symbol + 1, order.reference, executed);
+            order.shares -= executed;
+            if (order.shares == 0)
+            {
+                order = orders.back();
+                orders.pop_back();
+            }
+        } else {
+            int ticks = 1 + depthDist(gen);
+            writer.orderReplace(symbol + 1, order.reference, nextReference, order.shares, 1000000 + (order.buyOrSell ? -ticks : ticks) * 100);
+            order.reference = nextReference++;
+        }
+    }
+    writer.save(filename);
+}
+
+// Usage: ItchBenchmark [ITCH file] [symbol]
+// Without a file, a synthetic 10M message feed is generated and AAPL is replayed from it.
+int main(int argc, char* argv[])
+{
+    std::string filename = argc > 1 ? argv[1] : "itch_benchmark.bin";
+    std::string symbol = argc > 2 ? argv[2] : "AAPL";
+    if (argc <= 1)
+    {
+        writeSyntheticFeed(filename, 10000000);
+    }
+
+    ItchReader reader;
+    if (!reader.open(filename))
+    {
+        return 1;
+    }
+    reader.selectSymbol(symbol);
+
+    std::int64_t start = benchmarkNanoseconds();
+    std::vector<Command> commands = reader.readCommands();
+    std::int64_t parseTime = benchmarkNanoseconds() - start;
+
+    Book* book = new Book();
+    start = benchmarkNanoseconds();
+    reader.replay(book);
+    std::int64_t replayTime = benchmarkNanoseconds() - start;
+
+    std::cout << "messages,commands,parse_ms,parse_msgs_per_s,replay_ms,replay_cmds_per_s,buy_levels,sell_levels" << std::endl;
+    std::cout << reader.getMessageCount() << "," << commands.size() << "," << parseTime / 1000000.0 << ","
+    << reader.getMessageCount() * 1e9 / parseTime << "," << replayTime / 1000000.0 << "," << commands.size() * 1e9 / replayTime << ","
+    << book->inOrderTreeTraversal(book->getBuyTree()).size() << "," << book->inOrderTreeTraversal(book->getSellTree()).size() << std::endl;
+
+    delete book;
+    if (argc <= 1)
+    {
+        std::remove(filename.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Persistence/MappedBook.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Restart-to-ready time of a memory-mapped book against loading a snapshot of the same book.
+// Usage: MappedBookBenchmark [orders] [price levels per side]
+int main(int argc, char* argv[])
+{
+    int numberOfOrders = argc > 1 ? std::stoi(argv[1]) : 10000000;
+    int levelsPerSide = argc > 2 ? std::stoi(argv[2]) : 2000;
+    const std::string bookFile = "mapped_benchmark.book";
+    const std::string snapshotFile = "mapped_benchmark.snapshot";
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 1000);
+    std::uniform_int_distribution<> levelDist(1, levelsPerSide);
+    std::uniform_int_distribution<> buyOrSellDist(0, 1);
+
+    MappedBook mapped;
+    if (!mapped.create(bookFile, std::size_t(numberOfOrders) * 160 + (std::size_t(1) << 28)))
+    {
+        return 1;
+    }
+    Book* book = mapped.getBook();
+    std::int64_t start = benchmarkNanoseconds();
+    for (int orderId = 1; orderId <= numberOfOrders; orderId++)
+    {
+        bool buyOrSell = buyOrSellDist(gen);
+        int limitPrice = buyOrSell ? levelsPerSide + 1 - levelDist(gen) : levelsPerSide + levelDist(gen);
+        book->addLimitOrder(orderId, buyOrSell, sharesDist(gen), limitPrice);
+    }
+    std::int64_t buildTime = benchmarkNanoseconds() - start;
+    book->saveSnapshot(snapshotFile);
+    std::size_t usedBytes = mapped.getUsedBytes();
+
+    start = benchmarkNanoseconds();
+    mapped.close();
+    std::int64_t closeTime = benchmarkNanoseconds() - start;
+
+    // Restart: remap and serve the first request
+    start = benchmarkNanoseconds();
+    mapped.open(bookFile);
+    mapped.getBook()->cancelLimitOrder(numberOfOrders / 2);
+    std::int64_t openTime = benchmarkNanoseconds() - start;
+    mapped.close();
+
+    start = benchmarkNanoseconds();
+    bool consistent = mapped.open(bookFile, true);
+    std::int64_t checkedOpenTime = benchmarkNanoseconds() - start;
+    mapped.close();
+
+    Book* restored = new Book();
+    start = benchmarkNanoseconds();
+    restored->loadSnapshot(snapshotFile);
+    std::int64_t snapshotTime = benchmarkNanoseconds() - start;
+    delete restored;
+
+    std::remove(bookFile.c_str());
+    std::remove(snapshotFile.c_str());
+
+    std::cout << "orders,mapped_bytes,build_ms,close_ms,open_ms,open_full_check_ms,consistent,snapshot_load_ms" << std::endl;
+    std::cout << numberOfOrders << "," << usedBytes << "," << buildTime / 1000000.0 << "," << closeTime / 1000000.0 << ","
+    << openTime / 1000000.0 << "," << checkedOpenTime / 1000000.0 << "," << consistent << "," << snapshotTime / 1000000.0 << std::endl;
+    return 0;
+}
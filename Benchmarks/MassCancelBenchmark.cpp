@@ -0,0 +1,66 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Time to pull a block of orders out of a busy book. Each run rests orders of 50 owners over
+// 2000 levels a side, then removes either every order of owner 1 or every buy order priced
+// from 9000 to 9500, with one bulk call or with a cancelLimitOrder call per order.
+// Usage: MassCancelBenchmark [orders]
+int main(int argc, char* argv[])
+{
+    int numberOfOrders = argc > 1 ? std::stoi(argv[1]) : 100000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> depthDist(1, 2000);
+    std::uniform_int_distribution<> ownerDist(2, 50);
+    std::vector<int> depths, owners;
+    for (int i = 0; i < 2 * numberOfOrders; i++)
+    {
+        depths.push_back(depthDist(gen));
+        owners.push_back(ownerDist(gen));
+    }
+
+    std::cout << "method,cancelled,total_us,per_order_ns" << std::endl;
+    for (std::string method : {"cancelOwnerOrders", "cancelLimitOrder by owner", "massCancel", "cancelLimitOrder by range"})
+    {
+        Book* book = new Book();
+        std::vector<int> ownedIds, rangeIds;
+        for (int i = 0; i < 2 * numberOfOrders; i++)
+        {
+            // Every other order belongs to owner 1
+            bool buyOrSell = i % 4 < 2;
+            int owner = i % 2 == 0 ? 1 : owners[i];
+            book->addLimitOrder(i + 1, buyOrSell, 100, buyOrSell ? 10000 - depths[i] : 10000 + depths[i], owner);
+            if (owner == 1)
+            {
+                ownedIds.push_back(i + 1);
+            }
+            if (buyOrSell && depths[i] >= 500 && depths[i] <= 1000)
+            {
+                rangeIds.push_back(i + 1);
+            }
+        }
+
+        int cancelled = 0;
+        std::int64_t start = benchmarkNanoseconds();
+        if (method == "cancelOwnerOrders")
+        {
+            cancelled = book->cancelOwnerOrders(1);
+        } else if (method == "massCancel") {
+            cancelled = book->massCancel(true, 9000, 9500);
+        } else {
+            for (int orderId : method == "cancelLimitOrder by owner" ? ownedIds : rangeIds)
+            {
+                book->cancelLimitOrder(orderId);
+                cancelled += 1;
+            }
+        }
+        std::int64_t elapsed = benchmarkNanoseconds() - start;
+        std::cout << method << "," << cancelled << "," << elapsed / 1000 << "," << elapsed / cancelled << std::endl;
+        delete book;
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Latency of modifying resting limit orders. 10k or 100k orders rest over 200 levels a side and
+// each modify picks one at random. Reduce keeps the price and takes a share off, which is done
+// in place, while reprice moves the order one tick to the back of another level.
+// Usage: ModifyBenchmark [modifies]
+int main(int argc, char* argv[])
+{
+    int numberOfModifies = argc > 1 ? std::stoi(argv[1]) : 1000000;
+
+    std::cout << "orders,modify,modifies,mean_ns,p50_ns,p99_ns" << std::endl;
+    for (int numberOfOrders : {10000, 100000})
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<> depthDist(1, 200);
+        std::uniform_int_distribution<> orderDist(1, numberOfOrders);
+        std::vector<int> depths, targets;
+        for (int i = 0; i < numberOfOrders; i++)
+        {
+            depths.push_back(depthDist(gen));
+        }
+        for (int i = 0; i < numberOfModifies; i++)
+        {
+            targets.push_back(orderDist(gen));
+        }
+
+        for (std::string method : {"reduce", "reprice"})
+        {
+            Book* book = new Book();
+            std::vector<int> shares(numberOfOrders + 1, 1000000), prices(numberOfOrders + 1);
+            for (int orderId = 1; orderId <= numberOfOrders; orderId++)
+            {
+                bool buyOrSell = orderId % 2 == 0;
+                prices[orderId] = buyOrSell ? 10000 - depths[orderId - 1] : 10001 + depths[orderId - 1];
+                book->addLimitOrder(orderId, buyOrSell, shares[orderId], prices[orderId]);
+            }
+
+            std::vector<std::int64_t> latencies;
+            latencies.reserve(numberOfModifies);
+            for (int i = 0; i < numberOfModifies; i++)
+            {
+                int orderId = targets[i];
+                if (method == "reduce")
+                {
+                    shares[orderId] -= 1;
+                } else {
+                    // Step between two prices on the same side of the book
+                    prices[orderId] += (orderId % 2 == 0) == (prices[orderId] % 2 == 0) ? -1 : 1;
+                }
+                std::int64_t start = benchmarkNanoseconds();
+                book->modifyLimitOrder(orderId, shares[orderId], prices[orderId]);
+                latencies.push_back(benchmarkNanoseconds() - start);
+            }
+
+            std::int64_t total = 0;
+            for (std::int64_t latency : latencies)
+            {
+                total += latency;
+            }
+            std::cout << numberOfOrders << "," << method << "," << numberOfModifies << "," << total / numberOfModifies << ","
+            << percentile(latencies, 50) << "," << percentile(latencies, 99) << std::endl;
+            delete book;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Text file replay with sequential parsing against parallel chunked parsing for 1 to 8 workers.
+// Usage: ParallelParseBenchmark [commands]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 5000000;
+    const std::string filename = "parallel_parse_benchmark.txt";
+    {
+        std::ofstream file(filename, std::ios::trunc);
+        for (const Command& command : generateCommands(numberOfCommands, 1, 42))
+        {
+            file << formatCommand(command) << "\n";
+        }
+    }
+
+    Book* sequential = new Book();
+    std::int64_t start = benchmarkNanoseconds();
+    for (const Command& command : OrderPipeline::loadCommandsFromFile(filename))
+    {
+        applyCommand(sequential, command);
+    }
+    std::int64_t sequentialTime = benchmarkNanoseconds() - start;
+
+    std::cout << "hardware_threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << "mode,workers,ms,speedup,matches_sequential" << std::endl;
+    std::cout << "sequential,0," << sequentialTime / 1000000.0 << ",1,1" << std::endl;
+    for (int workers : {1, 2, 4, 8})
+    {
+        Book* book = new Book();
+        OrderPipeline pipeline(book);
+        start = benchmarkNanoseconds();
+        pipeline.processOrdersParallel(filename, workers);
+        std::int64_t parallelTime = benchmarkNanoseconds() - start;
+        std::cout << "parallel," << workers << "," << parallelTime / 1000000.0 << ","
+        << static_cast<double>(sequentialTime) / parallelTime << "," << (book->getStateHash() == sequential->getStateHash()) << std::endl;
+        delete book;
+    }
+
+    delete sequential;
+    std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "BenchmarkUtils.hpp"
+#include "../Process_Orders/ParallelReplay.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Replay K order files, or K generated streams, into K books while scaling the worker threads,
+// once with per book pools and once with every order and level on the global heap.
+// Usage: ParallelReplayBenchmark [--initial file] [--streams K] [--commands N] [--max-threads T] [files...]
+int main(int argc, char* argv[])
+{
+    int numberOfStreams = 16;
+    int commandsPerStream = 500000;
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::string initialFile;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--initial" && i + 1 < argc)
+        {
+            initialFile = argv[++i];
+        } else if (arg == "--streams" && i + 1 < argc)
+        {
+            numberOfStreams = std::stoi(argv[++i]);
+        } else if (arg == "--commands" && i + 1 < argc)
+        {
+            commandsPerStream = std::stoi(argv[++i]);
+        } else if (arg == "--max-threads" && i + 1 < argc)
+        {
+            maxThreads = std::stoi(argv[++i]);
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    ParallelReplay replay;
+    if (!initialFile.empty())
+    {
+        replay.setInitialCommands(OrderPipeline::loadCommandsFromFile(initialFile));
+    }
+    if (files.empty())
+    {
+        for (int i = 0; i < numberOfStreams; i++)
+        {
+            replay.addStream(generateCommands(commandsPerStream, 1000000, 42 + i));
+        }
+    } else {
+        for (const std::string& file : files)
+        {
+            replay.addStream(OrderPipeline::loadCommandsFromFile(file));
+        }
+    }
+
+    std::cout << "allocator,threads,books,commands,orders_per_second,thread,thread_books,thread_commands,p50_ns,p99_ns,p999_ns" << std::endl;
+    for (bool heapAllocation : {false, true})
+    {
+        replay.setHeapAllocation(heapAllocation);
+        for (int threads = 1; threads <= maxThreads; threads++)
+        {
+            ParallelReplay::Report report = replay.run(threads);
+            for (int i = 0; i < threads; i++)
+            {
+                const ParallelReplay::ThreadReport& threadReport = report.threadReports[i];
+                std::cout << (heapAllocation ? "heap" : "pool") << "," << threads << "," << replay.getNumberOfStreams() << ","
+                << report.commands << "," << static_cast<long long>(report.ordersPerSecond) << "," << i << ","
+                << threadReport.booksReplayed << "," << threadReport.commands << "," << threadReport.histogram.percentile(50) << ","
+                << threadReport.histogram.percentile(99) << "," << threadReport.histogram.percentile(99.9) << std::endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Latency of taking liquidity as the number of resting pegged orders grows. The pegs are
+// spread over every peg type and many offsets on both sides, so each taker goes through the
+// pegged matching path, and every fill moves the book edges they follow.
+// Usage: PeggedOrderBenchmark [takers]
+int main(int argc, char* argv[])
+{
+    int numberOfTakers = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 100);
+    std::uniform_int_distribution<> sideDist(0, 1);
+    std::uniform_int_distribution<> levelDist(1, 10);
+    std::vector<int> takerShares, takerSides, refillLevels;
+    for (int i = 0; i < numberOfTakers; i++)
+    {
+        takerShares.push_back(sharesDist(gen));
+        takerSides.push_back(sideDist(gen));
+        refillLevels.push_back(levelDist(gen));
+    }
+
+    std::cout << "pegged_orders,takers,mean_ns,p50_ns,p99_ns" << std::endl;
+    for (int peggedOrders : {0, 1000, 10000, 100000})
+    {
+        Book* book = new Book();
+        int orderId = 1;
+        for (int level = 1; level <= 10; level++)
+        {
+            for (int i = 0; i < 10; i++)
+            {
+                book->addLimitOrder(orderId++, true, 100, 1000 - level);
+                book->addLimitOrder(orderId++, false, 100, 1000 + level);
+            }
+        }
+        // Offsets keep the pegs behind the book, so they rest untouched while takers move the edges
+        std::uniform_int_distribution<> offsetDist(15, 500);
+        for (int i = 0; i < peggedOrders; i++)
+        {
+            bool buyOrSell = i % 2 == 0;
+            int offset = offsetDist(gen);
+            PegType pegType = static_cast<PegType>((i / 2) % 3);
+            if (pegType == PegType::Market)
+            {
+                offset += 10;
+            }
+            book->addPeggedOrder(orderId++, buyOrSell, 100, pegType, buyOrSell ? -offset : offset);
+        }
+
+        std::vector<std::int64_t> latencies;
+        latencies.reserve(numberOfTakers);
+        for (int i = 0; i < numberOfTakers; i++)
+        {
+            bool buyOrSell = takerSides[i] != 0;
+            std::int64_t start = benchmarkNanoseconds();
+            book->marketOrder(orderId++, buyOrSell, takerShares[i]);
+            latencies.push_back(benchmarkNanoseconds() - start);
+            book->addLimitOrder(orderId++, !buyOrSell, takerShares[i], buyOrSell ? 1000 + refillLevels[i] : 1000 - refillLevels[i]);
+        }
+
+        std::int64_t total = 0;
+        for (std::int64_t latency : latencies)
+        {
+            total += latency;
+        }
+        std::cout << peggedOrders << "," << numberOfTakers << "," << total / numberOfTakers << ","
+        << percentile(latencies, 50) << "," << percentile(latencies, 99) << std::endl;
+        delete book;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A fat finger buy in a thin book. 2000 sell levels hold 10 shares each, one tick apart, with
+// a 30 share buy stop every 10 ticks. A 5000 share market order sweeps 500 levels and sets off
+// a cascade of stops, while the same order with 5 ticks of protection stops short of the first
+// stop. Each trial rebuilds the book and times the single order.
+// Usage: ProtectedMarketBenchmark [trials]
+int main(int argc, char* argv[])
+{
+    int trials = argc > 1 ? std::stoi(argv[1]) : 50;
+
+    std::cout << "order,trials,p50_us,max_us,best_sell_after" << std::endl;
+    for (std::string method : {"marketOrder", "protectedMarketOrder"})
+    {
+        std::vector<std::int64_t> latencies;
+        int bestSellAfter = 0;
+        for (int trial = 0; trial < trials; trial++)
+        {
+            Book* book = new Book();
+            int orderId = 1;
+            for (int price = 10001; price <= 12000; price++)
+            {
+                book->addLimitOrder(orderId++, false, 10, price);
+                if (price % 10 == 0)
+                {
+                    book->addStopOrder(orderId++, true, 30, price);
+                }
+            }
+
+            std::int64_t start = benchmarkNanoseconds();
+            if (method == "marketOrder")
+            {
+                book->marketOrder(orderId, true, 5000);
+            } else {
+                book->protectedMarketOrder(orderId, true, 5000, 5);
+            }
+            latencies.push_back(benchmarkNanoseconds() - start);
+            bestSellAfter = book->getLowestSell() != nullptr ? book->getLowestSell()->getLimitPrice() : 0;
+            delete book;
+        }
+        std::cout << method << "," << trials << "," << percentile(latencies, 50) / 1000.0 << ","
+        << *std::max_element(latencies.begin(), latencies.end()) / 1000.0 << "," << bestSellAfter << std::endl;
+    }
+    return 0;
+}
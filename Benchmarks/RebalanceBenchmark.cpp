@@ -0,0 +1,78 @@
+#include "BenchmarkUtils.hpp"
+#include "../Matching_Engine/BookManager.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Skewed workload where one hot symbol takes a large share of the flow, run with static
+// round robin sharding and with dynamic rebalancing.
+// Usage: RebalanceBenchmark [symbols] [commands] [hot share] [threads]
+int main(int argc, char* argv[])
+{
+    int numberOfSymbols = argc > 1 ? std::stoi(argv[1]) : 32;
+    int numberOfCommands = argc > 2 ? std::stoi(argv[2]) : 2000000;
+    double hotShare = argc > 3 ? std::stod(argv[3]) : 0.5;
+    int threads = argc > 4 ? std::stoi(argv[4]) : std::max(2u, std::thread::hardware_concurrency());
+
+    // Pick the symbol of every command first, then give each symbol its own valid stream
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<> hotDist(0.0, 1.0);
+    std::uniform_int_distribution<> coldDist(1, numberOfSymbols - 1);
+    std::vector<int> symbolOfCommand(numberOfCommands);
+    std::vector<int> commandsPerSymbol(numberOfSymbols, 0);
+    for (int i = 0; i < numberOfCommands; i++)
+    {
+        symbolOfCommand[i] = hotDist(gen) < hotShare ? 0 : coldDist(gen);
+        commandsPerSymbol[symbolOfCommand[i]] += 1;
+    }
+    std::vector<std::vector<Command>> streams;
+    for (int symbolId = 0; symbolId < numberOfSymbols; symbolId++)
+    {
+        streams.push_back(generateCommands(commandsPerSymbol[symbolId], 1, 42 + symbolId));
+    }
+    std::vector<Command> commands;
+    commands.reserve(numberOfCommands);
+    std::vector<int> nextCommand(numberOfSymbols, 0);
+    for (int symbolId : symbolOfCommand)
+    {
+        Command command = streams[symbolId][nextCommand[symbolId]++];
+        command.symbolId = symbolId;
+        commands.push_back(command);
+    }
+
+    std::cout << "mode,threads,symbols,commands,orders_per_second,p99_ns,migrations" << std::endl;
+    for (int rebalancing = 0; rebalancing <= 1; rebalancing++)
+    {
+        BookManager* manager = new BookManager(threads);
+        for (int symbolId = 0; symbolId < numberOfSymbols; symbolId++)
+        {
+            manager->addSymbol("SYM" + std::to_string(symbolId));
+        }
+        if (rebalancing)
+        {
+            manager->setRebalanceInterval(50000);
+        }
+        manager->setRecordLatencies(true);
+        manager->start();
+
+        std::int64_t start = benchmarkNanoseconds();
+        for (const Command& command : commands)
+        {
+            manager->submit(command);
+        }
+        manager->stop();
+        std::int64_t stop = benchmarkNanoseconds();
+
+        std::vector<std::int64_t> latencies = manager->getLatencies();
+        double ordersPerSecond = commands.size() * 1e9 / (stop - start);
+        std::cout << (rebalancing ? "rebalancing" : "static") << "," << threads << "," << numberOfSymbols << ","
+        << commands.size() << "," << static_cast<long long>(ordersPerSecond) << ","
+        << percentile(latencies, 99) << "," << manager->getMigrationCount() << std::endl;
+
+        delete manager;
+    }
+    return 0;
+}
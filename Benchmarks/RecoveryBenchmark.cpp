@@ -0,0 +1,71 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Persistence/CommandJournal.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Journal N commands through the group commit writer, then time recovery from the journal
+// alone and from a snapshot taken at 90% of the stream plus the journal tail.
+// Usage: RecoveryBenchmark [command counts...]
+int main(int argc, char* argv[])
+{
+    std::vector<int> counts;
+    for (int i = 1; i < argc; i++)
+    {
+        counts.push_back(std::stoi(argv[i]));
+    }
+    if (counts.empty())
+    {
+        counts = {1000000, 10000000};
+    }
+    const std::string journalFile = "recovery_benchmark.journal";
+    const std::string snapshotFile = "recovery_benchmark.snapshot";
+
+    std::cout << "commands,journal_ms,group_commits,full_replay_ms,snapshot_tail_ms,recovered_sequence" << std::endl;
+    for (int count : counts)
+    {
+        std::vector<Command> commands = generateCommands(count, 1, 42);
+        std::remove(snapshotFile.c_str());
+
+        Book* book = new Book();
+        CommandJournal* journal = new CommandJournal();
+        journal->open(journalFile, true);
+        std::int64_t start = benchmarkNanoseconds();
+        for (int i = 0; i < count; i++)
+        {
+            std::uint64_t sequenceNumber = journal->append(commands[i]);
+            applyCommand(book, commands[i]);
+            if (i + 1 == count / 10 * 9)
+            {
+                book->saveSnapshot(snapshotFile, sequenceNumber);
+            }
+        }
+        journal->close();
+        std::int64_t journalTime = benchmarkNanoseconds() - start;
+        std::uint64_t groupCommits = journal->getGroupCommitCount();
+        delete journal;
+        delete book;
+
+        Book* fullReplay = new Book();
+        start = benchmarkNanoseconds();
+        recoverBook(fullReplay, "", journalFile);
+        std::int64_t fullReplayTime = benchmarkNanoseconds() - start;
+        delete fullReplay;
+
+        Book* recovered = new Book();
+        start = benchmarkNanoseconds();
+        std::uint64_t recoveredSequence = recoverBook(recovered, snapshotFile, journalFile);
+        std::int64_t snapshotTailTime = benchmarkNanoseconds() - start;
+        delete recovered;
+
+        std::cout << count << "," << journalTime / 1000000.0 << "," << groupCommits << ","
+        << fullReplayTime / 1000000.0 << "," << snapshotTailTime / 1000000.0 << "," << recoveredSequence << std::endl;
+
+        std::remove(journalFile.c_str());
+        std::remove(snapshotFile.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Matching_Engine/Replication.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Primary latency with and without a hot standby process consuming the replicated stream.
+// Usage: ReplicationBenchmark [commands] [hash interval]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int hashInterval = argc > 2 ? std::stoi(argv[2]) : 1024;
+    if (hashInterval < 1)
+    {
+        std::cerr << "Hash interval must be at least 1" << std::endl;
+        return 1;
+    }
+    const std::string ringName = "/lob_replication_benchmark";
+    std::vector<Command> commands = generateCommands(numberOfCommands, 1, 42);
+
+    ReplicationRing ring;
+    if (!ring.create(ringName, 1 << 16))
+    {
+        return 1;
+    }
+    pid_t child = fork();
+    if (child == 0)
+    {
+        ReplicationRing standbyRing;
+        standbyRing.attach(ringName);
+        Book* book = new Book();
+        StandbyReplica standby(book, &standbyRing);
+        std::atomic<bool> stop(false);
+        standby.run(stop);
+
+        std::int64_t start = benchmarkNanoseconds();
+        standby.promote();
+        std::int64_t failoverTime = benchmarkNanoseconds() - start;
+        std::cout << "standby_sequence,failover_us" << std::endl;
+        std::cout << standby.getSequenceNumber() << "," << failoverTime / 1000.0 << std::endl;
+        _exit(0);
+    }
+
+    // The same stream is applied twice from an empty book, first alone and then replicated
+    Book* baselineBook = new Book();
+    std::vector<std::int64_t> baseline, replicated;
+    baseline.reserve(numberOfCommands);
+    replicated.reserve(numberOfCommands);
+    for (const Command& command : commands)
+    {
+        std::int64_t start = benchmarkNanoseconds();
+        applyCommand(baselineBook, command);
+        baseline.push_back(benchmarkNanoseconds() - start);
+    }
+
+    Book* primaryBook = new Book();
+    ReplicationPrimary primary(primaryBook, &ring, hashInterval);
+    for (const Command& command : commands)
+    {
+        std::int64_t start = benchmarkNanoseconds();
+        primary.apply(command);
+        replicated.push_back(benchmarkNanoseconds() - start);
+    }
+    ring.finish();
+    waitpid(child, nullptr, 0);
+
+    std::cout << "phase,p50_ns,p99_ns,p99.9_ns" << std::endl;
+    std::cout << "no_replication," << percentile(baseline, 50) << "," << percentile(baseline, 99) << "," << percentile(baseline, 99.9) << std::endl;
+    std::cout << "replicated," << percentile(replicated, 50) << "," << percentile(replicated, 99) << "," << percentile(replicated, 99.9) << std::endl;
+    std::cout << "hash_checks,hash_mismatches" << std::endl;
+    std::cout << ring.getHashChecks() << "," << ring.getHashMismatches() << std::endl;
+    return 0;
+}
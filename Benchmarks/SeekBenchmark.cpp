@@ -0,0 +1,56 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/SeekableReplay.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Latency of seeking to random sequence numbers with periodic checkpoints against replaying from the start.
+// Usage: SeekBenchmark [commands] [checkpoint interval] [seeks]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 5000000;
+    int interval = argc > 2 ? std::stoi(argv[2]) : 100000;
+    int numberOfSeeks = argc > 3 ? std::stoi(argv[3]) : 200;
+    if (interval < 1)
+    {
+        std::cerr << "Checkpoint interval must be at least 1" << std::endl;
+        return 1;
+    }
+
+    std::vector<Command> commands = generateCommands(numberOfCommands, 1, 42);
+    std::uint64_t target = numberOfCommands * 0.7624;
+
+    Book* fullReplay = new Book();
+    std::int64_t start = benchmarkNanoseconds();
+    for (std::uint64_t i = 0; i < target; i++)
+    {
+        applyCommand(fullReplay, commands[i]);
+    }
+    std::int64_t fullReplayTime = benchmarkNanoseconds() - start;
+    delete fullReplay;
+
+    SeekableReplay replay(commands, interval);
+    start = benchmarkNanoseconds();
+    replay.buildCheckpoints();
+    std::int64_t buildTime = benchmarkNanoseconds() - start;
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<std::uint64_t> targetDist(0, numberOfCommands);
+    std::vector<std::int64_t> latencies;
+    for (int i = 0; i < numberOfSeeks; i++)
+    {
+        std::uint64_t seekTarget = targetDist(gen);
+        start = benchmarkNanoseconds();
+        replay.seek(seekTarget);
+        latencies.push_back(benchmarkNanoseconds() - start);
+    }
+
+    std::cout << "commands,interval,checkpoints,checkpoint_bytes,build_ms,replay_to_" << target << "_ms,seek_p50_ms,seek_p99_ms,seek_max_ms" << std::endl;
+    std::cout << numberOfCommands << "," << interval << "," << replay.getNumberOfCheckpoints() << "," << replay.getCheckpointBytes() << ","
+    << buildTime / 1000000.0 << "," << fullReplayTime / 1000000.0 << "," << percentile(latencies, 50) / 1000000.0 << ","
+    << percentile(latencies, 99) / 1000000.0 << "," << percentile(latencies, 100) / 1000000.0 << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Cost of self-trade prevention on the matching path. The same 1M commands, limit orders
+// around a moving midpoint of which a quarter cross and trade, run with prevention off and
+// with each mode on. Orders have one of 16 owners, so about one in 16 matches meets its own owner.
+// Usage: SelfTradeBenchmark [commands]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 100);
+    std::uniform_int_distribution<> offsetDist(-5, 20);
+    std::uniform_int_distribution<> ownerDist(1, 16);
+    std::vector<int> shares, offsets, owners;
+    for (int i = 0; i < numberOfCommands; i++)
+    {
+        shares.push_back(sharesDist(gen));
+        offsets.push_back(offsetDist(gen));
+        owners.push_back(ownerDist(gen));
+    }
+
+    std::cout << "mode,owners,commands,mean_ns,p50_ns,p99_ns,prevented" << std::endl;
+    std::vector<std::pair<std::string, SelfTradePrevention>> modes = {{"None", SelfTradePrevention::None},
+        {"CancelNewest", SelfTradePrevention::CancelNewest}, {"CancelOldest", SelfTradePrevention::CancelOldest},
+        {"CancelBoth", SelfTradePrevention::CancelBoth}, {"Decrement", SelfTradePrevention::Decrement}};
+    for (auto& [name, mode] : modes)
+    {
+        for (bool withOwners : {false, true})
+        {
+            if (mode != SelfTradePrevention::None && !withOwners)
+            {
+                continue;
+            }
+            Book* book = new Book();
+            book->setSelfTradePrevention(mode);
+            std::vector<std::int64_t> latencies;
+            latencies.reserve(numberOfCommands);
+            for (int i = 0; i < numberOfCommands; i++)
+            {
+                // Buys rest below 1000 and sells above it, less the crossing offsets
+                bool buyOrSell = i % 2 == 0;
+                int price = buyOrSell ? 1000 - offsets[i] : 1000 + offsets[i];
+                std::int64_t start = benchmarkNanoseconds();
+                book->addLimitOrder(i + 1, buyOrSell, shares[i], price, withOwners ? owners[i] : 0);
+                latencies.push_back(benchmarkNanoseconds() - start);
+            }
+
+            std::int64_t total = 0;
+            for (std::int64_t latency : latencies)
+            {
+                total += latency;
+            }
+            std::cout << name << "," << (withOwners ? "yes" : "no") << "," << numberOfCommands << "," << total / numberOfCommands << ","
+            << percentile(latencies, 50) << "," << percentile(latencies, 99) << "," << book->getPreventedSelfTradeCount() << std::endl;
+            delete book;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Startup time from replaying order commands against loading a binary snapshot of the same book.
+// Usage: SnapshotBenchmark [orders] [price levels per side]
+int main(int argc, char* argv[])
+{
+    int numberOfOrders = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int levelsPerSide = argc > 2 ? std::stoi(argv[2]) : 2000;
+    const std::string filename = "snapshot_benchmark.bin";
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 1000);
+    std::uniform_int_distribution<> levelDist(1, levelsPerSide);
+    std::uniform_int_distribution<> buyOrSellDist(0, 1);
+    std::vector<Command> commands;
+    commands.reserve(numberOfOrders);
+    for (int orderId = 1; orderId <= numberOfOrders; orderId++)
+    {
+        bool buyOrSell = buyOrSellDist(gen);
+        int limitPrice = buyOrSell ? levelsPerSide + 1 - levelDist(gen) : levelsPerSide + levelDist(gen);
+        commands.push_back(Command{CommandType::AddLimit, buyOrSell, orderId, sharesDist(gen), limitPrice, 0});
+    }
+
+    Book* book = new Book();
+    std::int64_t start = benchmarkNanoseconds();
+    for (const Command& command : commands)
+    {
+        applyCommand(book, command);
+    }
+    std::int64_t replayTime = benchmarkNanoseconds() - start;
+
+    start = benchmarkNanoseconds();
+    book->saveSnapshot(filename);
+    std::int64_t saveTime = benchmarkNanoseconds() - start;
+    std::vector<char> snapshot = book->serializeSnapshot();
+
+    Book* restored = new Book();
+    start = benchmarkNanoseconds();
+    restored->loadSnapshot(filename);
+    std::int64_t loadTime = benchmarkNanoseconds() - start;
+    std::remove(filename.c_str());
+
+    std::cout << "orders,levels,snapshot_bytes,replay_ms,save_ms,load_ms" << std::endl;
+    std::cout << numberOfOrders << "," << 2 * levelsPerSide << "," << snapshot.size() << ","
+    << replayTime / 1000000.0 << "," << saveTime / 1000000.0 << "," << loadTime / 1000000.0 << std::endl;
+
+    delete restored;
+    delete book;
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// A buy that takes liquidity up to a price limit, followed by a maker sell that puts the same
+// shares back so the book keeps its shape
+struct Taker {
+    int shares;
+    int limitPrice;
+    int refillPrice;
+};
+
+enum class TakerMode {
+    LimitThenCancel,
+    ImmediateOrCancel,
+    FillOrKill
+};
+
+// Latency of taking liquidity with a limit order that is cancelled if any of it rests, against
+// native immediate or cancel and fill or kill orders, on the same stream of takers.
+// Usage: TakerOrderBenchmark [takers]
+int main(int argc, char* argv[])
+{
+    int numberOfTakers = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 400);
+    std::uniform_int_distribution<> depthDist(0, 4);
+    std::uniform_int_distribution<> levelDist(101, 120);
+    std::vector<Taker> takers;
+    for (int i = 0; i < numberOfTakers; i++)
+    {
+        takers.push_back(Taker{sharesDist(gen), 101 + depthDist(gen), levelDist(gen)});
+    }
+
+    std::cout << "mode,takers,mean_ns,p50_ns,p99_ns,filled_shares" << std::endl;
+    for (TakerMode mode : {TakerMode::LimitThenCancel, TakerMode::ImmediateOrCancel, TakerMode::FillOrKill})
+    {
+        Book* book = new Book();
+        int orderId = 1;
+        for (int price = 101; price <= 120; price++)
+        {
+            for (int i = 0; i < 5; i++)
+            {
+                book->addLimitOrder(orderId++, false, 40, price);
+            }
+        }
+
+        std::vector<std::int64_t> latencies;
+        latencies.reserve(takers.size());
+        long long filledShares = 0;
+        for (const Taker& taker : takers)
+        {
+            int id = orderId++;
+            std::int64_t start = benchmarkNanoseconds();
+            if (mode == TakerMode::LimitThenCancel)
+            {
+                book->addLimitOrder(id, true, taker.shares, taker.limitPrice);
+                // Anything left rests alone at the top of the otherwise empty buy side
+                Limit* rested = book->getHighestBuy();
+                if (rested != nullptr && rested->getHeadOrder()->getOrderId() == id)
+                {
+                    filledShares -= rested->getTotalVolume();
+                    book->cancelLimitOrder(id);
+                }
+                filledShares += taker.shares;
+            } else if (mode == TakerMode::ImmediateOrCancel)
+            {
+                filledShares += book->immediateOrCancelOrder(id, true, taker.shares, taker.limitPrice);
+            } else {
+                filledShares += book->fillOrKillOrder(id, true, taker.shares, taker.limitPrice) ? taker.shares : 0;
+            }
+            latencies.push_back(benchmarkNanoseconds() - start);
+            book->addLimitOrder(orderId++, false, taker.shares, taker.refillPrice);
+        }
+
+        std::int64_t total = 0;
+        for (std::int64_t latency : latencies)
+        {
+            total += latency;
+        }
+        const char* name = mode == TakerMode::LimitThenCancel ? "limit_then_cancel"
+            : mode == TakerMode::ImmediateOrCancel ? "immediate_or_cancel" : "fill_or_kill";
+        std::cout << name << "," << takers.size() << "," << total / static_cast<std::int64_t>(latencies.size()) << ","
+        << percentile(latencies, 50) << "," << percentile(latencies, 99) << "," << filledShares << std::endl;
+        delete book;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "BenchmarkUtils.hpp"
+#include "../Process_Orders/Command.hpp"
+#include "../Process_Orders/CommandTokenizer.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Parse throughput of the old getline and parseCommand loop against each tokenizer kind.
+// Usage: TokenizerBenchmark [commands]
+int main(int argc, char* argv[])
+{
+    int numberOfCommands = argc > 1 ? std::stoi(argv[1]) : 5000000;
+    std::string text;
+    for (const Command& command : generateCommands(numberOfCommands, 1, 42))
+    {
+        text += formatCommand(command) + "\n";
+    }
+    double gigabytes = text.size() / 1e9;
+
+    std::cout << "bytes: " << text.size() << std::endl;
+    std::cout << "tokenizer,ms,gb_per_s,commands" << std::endl;
+
+    // Touch the output once so no run pays for its page faults, then keep the best of three runs
+    std::vector<Command> commands(numberOfCommands);
+    auto bestOfThree = [&](auto&& parse) {
+        std::int64_t best = 0;
+        for (int run = 0; run < 3; run++)
+        {
+            commands.clear();
+            std::int64_t start = benchmarkNanoseconds();
+            parse();
+            std::int64_t elapsed = benchmarkNanoseconds() - start;
+            best = run == 0 || elapsed < best ? elapsed : best;
+        }
+        return best;
+    };
+    auto report = [&](const char* name, std::int64_t elapsed) {
+        std::cout << name << "," << elapsed / 1e6 << "," << gigabytes / (elapsed / 1e9) << "," << commands.size() << std::endl;
+    };
+
+    report("getline", bestOfThree([&]() {
+        std::istringstream stream(text);
+        std::string line;
+        Command command;
+        while (std::getline(stream, line))
+        {
+            if (parseCommand(line, command))
+            {
+                commands.push_back(command);
+            }
+        }
+    }));
+    for (TokenizerKind kind : {TokenizerKind::Scalar, TokenizerKind::SSE42, TokenizerKind::AVX2})
+    {
+        if (isTokenizerSupported(kind))
+        {
+            report(getTokenizerName(kind), bestOfThree([&]() { tokenizeCommands(text.data(), text.data() + text.size(), commands, kind); }));
+        }
+    }
+    return 0;
+}
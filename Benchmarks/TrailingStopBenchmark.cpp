@@ -0,0 +1,79 @@
+#include "BenchmarkUtils.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Latency of moving the book edges as the number of resting trailing stops grows. Each round
+// a market order takes from one side and a refill at a random depth puts the volume back,
+// which moves the best prices the stops follow up and down. One stop is replaced every round,
+// so stops keep arriving at lower prices and being merged by later highs.
+// Usage: TrailingStopBenchmark [rounds]
+int main(int argc, char* argv[])
+{
+    int numberOfRounds = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> sharesDist(1, 100);
+    std::uniform_int_distribution<> sideDist(0, 1);
+    std::uniform_int_distribution<> levelDist(1, 10);
+    std::vector<int> takerShares, takerSides, refillLevels;
+    for (int i = 0; i < numberOfRounds; i++)
+    {
+        takerShares.push_back(sharesDist(gen));
+        takerSides.push_back(sideDist(gen));
+        refillLevels.push_back(levelDist(gen));
+    }
+
+    std::cout << "trailing_stops,rounds,mean_ns,p50_ns,p99_ns" << std::endl;
+    for (int trailingStops : {0, 1000, 10000, 100000})
+    {
+        Book* book = new Book();
+        int orderId = 1;
+        for (int level = 1; level <= 10; level++)
+        {
+            for (int i = 0; i < 10; i++)
+            {
+                book->addLimitOrder(orderId++, true, 100, 1000 - level);
+                book->addLimitOrder(orderId++, false, 100, 1000 + level);
+            }
+        }
+        // Offsets are wider than the range the best prices move in, so no stop triggers
+        std::uniform_int_distribution<> offsetDist(50, 500);
+        std::vector<int> stopIds;
+        for (int i = 0; i < trailingStops; i++)
+        {
+            stopIds.push_back(orderId);
+            book->addTrailingStopOrder(orderId++, i % 2 == 0, 100, offsetDist(gen));
+        }
+
+        std::vector<std::int64_t> latencies;
+        latencies.reserve(numberOfRounds);
+        for (int i = 0; i < numberOfRounds; i++)
+        {
+            bool buyOrSell = takerSides[i] != 0;
+            std::int64_t start = benchmarkNanoseconds();
+            book->marketOrder(orderId++, buyOrSell, takerShares[i]);
+            book->addLimitOrder(orderId++, !buyOrSell, takerShares[i], buyOrSell ? 1000 + refillLevels[i] : 1000 - refillLevels[i]);
+            latencies.push_back(benchmarkNanoseconds() - start);
+            if (trailingStops != 0)
+            {
+                int slot = i % trailingStops;
+                book->cancelTrailingStopOrder(stopIds[slot]);
+                stopIds[slot] = orderId;
+                book->addTrailingStopOrder(orderId++, slot % 2 == 0, 100, offsetDist(gen));
+            }
+        }
+
+        std::int64_t total = 0;
+        for (std::int64_t latency : latencies)
+        {
+            total += latency;
+        }
+        std::cout << trailingStops << "," << numberOfRounds << "," << total / numberOfRounds << ","
+        << percentile(latencies, 50) << "," << percentile(latencies, 99) << std::endl;
+        delete book;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// Bump allocator over a caller supplied region with size-class free lists. The arena keeps
+// all of its state inside itself, so when it is placed at the start of a memory-mapped file
+// that is mapped at the same address again, everything allocated from it is still valid.
+class Arena {
+private:
+    static constexpr std::size_t alignment = 16;
+    static constexpr std::size_t smallClassLimit = 1024;
+    static constexpr int smallClassCount = smallClassLimit / alignment;
+    static constexpr int classCount = smallClassCount + 48;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    char* begin;
+    std::size_t capacity;
+    std::size_t used;
+    FreeBlock* freeLists[classCount];
+
+    // Small requests are rounded up to a multiple of 16 bytes, larger ones to a power of two
+    static int sizeClass(std::size_t bytes)
+    {
+        if (bytes <= smallClassLimit)
+        {
+            return static_cast<int>((bytes + alignment - 1) / alignment) - 1;
+        }
+        int shift = 11;
+        while ((std::size_t(1) << shift) < bytes)
+        {
+            shift += 1;
+        }
+        return smallClassCount + shift - 11;
+    }
+
+    static std::size_t classSize(int sizeClass)
+    {
+        if (sizeClass < smallClassCount)
+        {
+            return (sizeClass + 1) * alignment;
+        }
+        return std::size_t(1) << (sizeClass - smallClassCount + 11);
+    }
+
+public:
+    Arena(void* _begin, std::size_t _capacity) : begin(static_cast<char*>(_begin)), capacity(_capacity), used(0)
+    {
+        for (int i = 0; i < classCount; i++)
+        {
+            freeLists[i] = nullptr;
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes)
+    {
+        int index = sizeClass(bytes == 0 ? 1 : bytes);
+        if (freeLists[index] != nullptr)
+        {
+            FreeBlock* block = freeLists[index];
+            freeLists[index] = block->next;
+            return block;
+        }
+        std::size_t size = classSize(index);
+        if (size > capacity - used)
+        {
+            throw std::bad_alloc();
+        }
+        void* block = begin + used;
+        used += size;
+        return block;
+    }
+
+    void deallocate(void* pointer, std::size_t bytes)
+    {
+        int index = sizeClass(bytes == 0 ? 1 : bytes);
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = freeLists[index];
+        freeLists[index] = block;
+    }
+
+    bool contains(const void* pointer) const
+    {
+        const char* address = static_cast<const char*>(pointer);
+        return address >= begin && address < begin + used;
+    }
+
+    std::size_t getUsed() const
+    {
+        return used;
+    }
+
+    std::size_t getCapacity() const
+    {
+        return capacity;
+    }
+};
+
+// Standard allocator that draws from an arena, or from the global heap when it has none
+template <typename T>
+class ArenaAllocator {
+private:
+    Arena* arena;
+
+    template <typename U>
+    friend class ArenaAllocator;
+
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena* _arena=nullptr) : arena(_arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t count)
+    {
+        if (arena == nullptr)
+        {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+        return static_cast<T*>(arena->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count)
+    {
+        if (arena == nullptr)
+        {
+            ::operator delete(pointer);
+        } else {
+            arena->deallocate(pointer, count * sizeof(T));
+        }
+    }
+
+    Arena* getArena() const
+    {
+        return arena;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const
+    {
+        return arena == other.arena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const
+    {
+        return arena != other.arena;
+    }
+};
+
+template <typename Key, typename Value>
+using ArenaMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, ArenaAllocator<std::pair<const Key, Value>>>;
+
+template <typename Key, typename Value>
+using ArenaOrderedMap = std::map<Key, Value, std::less<Key>, ArenaAllocator<std::pair<const Key, Value>>>;
+
+template <typename Key, typename Value>
+using ArenaOrderedMultimap = std::multimap<Key, Value, std::less<Key>, ArenaAllocator<std::pair<const Key, Value>>>;
+
+template <typename Key>
+using ArenaOrderedSet = std::set<Key, std::less<Key>, ArenaAllocator<Key>>;
+
+template <typename Key>
+using ArenaSet = std::unordered_set<Key, std::hash<Key>, std::equal_to<Key>, ArenaAllocator<Key>>;
+
+#endif
@@ -3,34 +3,47 @@
 #include "Limit.hpp"
 #include <iostream>
 #include <algorithm>
+#include <bit>
+#include <climits>
 #include <random>
 #include <iterator>
-
-Book::Book() : buyTree(nullptr), sellTree(nullptr), lowestSell(nullptr), highestBuy(nullptr), 
-            stopBuyTree(nullptr), stopSellTree(nullptr), highestStopSell(nullptr), lowestStopBuy(nullptr){}
-
-// When deleting the book need to ensure all used memory is freed
+#include <fstream>
+#include <cstring>
+
+Book::Book(Arena* arena, bool heapAllocation) : buyTree(nullptr), sellTree(nullptr), lowestSell(nullptr), highestBuy(nullptr), 
+            stopBuyTree(nullptr), stopSellTree(nullptr), highestStopSell(nullptr), lowestStopBuy(nullptr),
+            orderMap(arena), limitBuyMap(arena), limitSellMap(arena), stopMap(arena), ownerOrders(arena),
+            pegGroups{{ArenaOrderedMap<int, Limit*>(arena), ArenaOrderedMap<int, Limit*>(arena), ArenaOrderedMap<int, Limit*>(arena)},
+                {ArenaOrderedMap<int, Limit*>(arena), ArenaOrderedMap<int, Limit*>(arena), ArenaOrderedMap<int, Limit*>(arena)}},
+            pegOrderMap(arena), pegCounts{0, 0},
+            trailingEpochs{std::vector<TrailingEpoch, ArenaAllocator<TrailingEpoch>>(arena), std::vector<TrailingEpoch, ArenaAllocator<TrailingEpoch>>(arena)},
+            trailingTriggers{ArenaOrderedSet<std::pair<int, int>>(arena), ArenaOrderedSet<std::pair<int, int>>(arena)},
+            trailingOrderMap(arena), triggeredTrailingStops(arena), trailingCounts{0, 0}, expiryWheel(arena),
+            selfTradePrevention(SelfTradePrevention::None), preventedSelfTrades(0), auctionMode(false),
+            orderPool(4096, arena, heapAllocation && arena == nullptr), limitPool(4096, arena, heapAllocation && arena == nullptr), stateHash(0), limitOrders(arena), stopOrders(arena), stopLimitOrders(arena){}
+
+// Orders and limits live in the book's pools, which free all their memory when the book is deleted
 Book::~Book()
 {
-    for (auto& [id, order] : orderMap) {
-        delete order;
-    }
     orderMap.clear();
-
-    for (auto& [limitPrice, limit] : limitBuyMap) {
-        delete limit;
-    }
     limitBuyMap.clear();
-
-    for (auto& [limitPrice, limit] : limitSellMap) {
-        delete limit;
-    }
     limitSellMap.clear();
-
-    for (auto& [stopPrice, stopLevel] : stopMap) {
-        delete stopLevel;
-    }
     stopMap.clear();
+    ownerOrders.clear();
+    pegOrderMap.clear();
+    for (auto& sideGroups : pegGroups)
+    {
+        for (auto& groups : sideGroups)
+        {
+            groups.clear();
+        }
+    }
+    trailingOrderMap.clear();
+    for (int side = 0; side < 2; side++)
+    {
+        trailingEpochs[side].clear();
+        trailingTriggers[side].clear();
+    }
 }
 
 Limit* Book::getBuyTree() const
@@ -74,40 +87,61 @@ Limit* Book::getLowestStopBuy() const
 }
 
 // Execute a market order
-void Book::marketOrder(int orderId, bool buyOrSell, int shares)
+void Book::marketOrder(int orderId, bool buyOrSell, int shares, int ownerId)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    marketOrderHelper(orderId, buyOrSell, shares);
+    if (auctionMode)
+    {
+        std::cerr << "Order " << orderId << " cannot trade during an auction" << std::endl;
+        return;
+    }
+    if (ownerId != 0 && selfTradePrevention != SelfTradePrevention::None)
+    {
+        matchOwnedOrder(buyOrSell, shares, buyOrSell ? INT_MAX : INT_MIN, ownerId);
+    } else {
+        marketOrderHelper(orderId, buyOrSell, shares);
+    }
 
     executeStopOrders(buyOrSell);
 }
 
 // Add a new limit order to the book
-void Book::addLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice)
+void Book::addLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int ownerId)
 {
     AVLTreeBalanceCount = 0;
     // Account for order being executed immediately
-    shares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice);
+    shares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
     
     if (shares != 0)
     {
-        Order* newOrder = new Order(orderId, buyOrSell, shares, limitPrice);
-        orderMap.emplace(orderId, newOrder);
-
-        auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
-
-        if (limitMap.find(limitPrice) == limitMap.end())
-        {
-            addLimit(limitPrice, newOrder->getBuyOrSell());
-        }
-        limitMap.at(limitPrice)->append(newOrder);
-        // limitOrders.insert(newOrder);
+        restLimitOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
     } else {
         executeStopOrders(buyOrSell);
     }
 }
 
+// Add the part of a limit order that did not trade to its level
+void Book::restLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int ownerId)
+{
+    Order* newOrder = orderPool.create(orderId, buyOrSell, shares, limitPrice, 0, 0, 0, ownerId);
+    orderMap.emplace(orderId, newOrder);
+    if (ownerId != 0)
+    {
+        linkOwnerOrder(newOrder);
+    }
+
+    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+
+    if (limitMap.find(limitPrice) == limitMap.end())
+    {
+        addLimit(limitPrice, newOrder->getBuyOrSell());
+    }
+    limitMap.at(limitPrice)->append(newOrder);
+    toggleOrderHash(newOrder);
+    // limitOrders.insert(newOrder);
+}
+
 // Delete a limit order from the book
 void Book::cancelLimitOrder(int orderId)
 {
@@ -117,6 +151,7 @@ void Book::cancelLimitOrder(int orderId)
 
     if (order != nullptr)
     {
+        toggleOrderHash(order);
         order->cancel();
             if (order->getParentLimit()->getSize() == 0)
             {   
@@ -124,18 +159,25 @@ void Book::cancelLimitOrder(int orderId)
             }
         deleteFromOrderMap(orderId);
         // limitOrders.erase(order);
-        delete order;
+        orderPool.destroy(order);
     }
 }
 
-// Modify an existing limit order
+// Modify an existing limit order. Reducing the size at the same price keeps the order's place in
+// its queue, while a new price or a larger size sends it to the back of its new level.
 void Book::modifyLimitOrder(int orderId, int newShares, int newLimit)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
     Order* order = searchOrderMap(orderId);
-    if (order != nullptr)
+    if (order != nullptr && newLimit == order->getLimit() && newShares > 0 && newShares < order->getShares() + order->getHiddenShares())
     {
+        toggleOrderHash(order);
+        order->reduceShares(newShares);
+        toggleOrderHash(order);
+    } else if (order != nullptr)
+    {
+        toggleOrderHash(order);
         order->cancel();
             if (order->getParentLimit()->getSize() == 0)
             {
@@ -150,6 +192,7 @@ void Book::modifyLimitOrder(int orderId, int newShares, int newLimit)
             addLimit(newLimit, order->getBuyOrSell());
         }
         limitMap.at(newLimit)->append(order);
+        toggleOrderHash(order);
     }
 }
 
@@ -163,7 +206,7 @@ void Book::addStopOrder(int orderId, bool buyOrSell, int shares, int stopPrice)
     
     if (shares != 0)
     {
-        Order* newOrder = new Order(orderId, buyOrSell, shares, 0);
+        Order* newOrder = orderPool.create(orderId, buyOrSell, shares, 0);
         orderMap.emplace(orderId, newOrder);
 
         if (stopMap.find(stopPrice) == stopMap.end())
@@ -171,6 +214,7 @@ void Book::addStopOrder(int orderId, bool buyOrSell, int shares, int stopPrice)
             addStop(stopPrice, newOrder->getBuyOrSell());
         }
         stopMap.at(stopPrice)->append(newOrder);
+        toggleOrderHash(newOrder);
         // stopOrders.insert(newOrder);
     }
 }
@@ -184,6 +228,7 @@ void Book::cancelStopOrder(int orderId)
 
     if (order != nullptr)
     {
+        toggleOrderHash(order);
         order->cancel();
             if (order->getParentLimit()->getSize() == 0)
             {   
@@ -191,7 +236,7 @@ void Book::cancelStopOrder(int orderId)
             }
         deleteFromOrderMap(orderId);
         // stopOrders.erase(order);
-        delete order;
+        orderPool.destroy(order);
     }
 }
 
@@ -203,6 +248,7 @@ void Book::modifyStopOrder(int orderId, int newShares, int newStopPrice)
     Order* order = searchOrderMap(orderId);
     if (order != nullptr)
     {
+        toggleOrderHash(order);
         order->cancel();
             if (order->getParentLimit()->getSize() == 0)
             {
@@ -216,6 +262,7 @@ void Book::modifyStopOrder(int orderId, int newShares, int newStopPrice)
             addStop(newStopPrice, order->getBuyOrSell());
         }
         stopMap.at(newStopPrice)->append(order);
+        toggleOrderHash(order);
     }
 }
 
@@ -229,7 +276,7 @@ void Book::addStopLimitOrder(int orderId, bool buyOrSell, int shares, int limitP
     
     if (shares != 0)
     {
-        Order* newOrder = new Order(orderId, buyOrSell, shares, limitPrice);
+        Order* newOrder = orderPool.create(orderId, buyOrSell, shares, limitPrice);
         orderMap.emplace(orderId, newOrder);
 
         if (stopMap.find(stopPrice) == stopMap.end())
@@ -237,6 +284,7 @@ void Book::addStopLimitOrder(int orderId, bool buyOrSell, int shares, int limitP
             addStop(stopPrice, newOrder->getBuyOrSell());
         }
         stopMap.at(stopPrice)->append(newOrder);
+        toggleOrderHash(newOrder);
         // stopLimitOrders.insert(newOrder);
     }
 }
@@ -249,6 +297,7 @@ void Book::cancelStopLimitOrder(int orderId)
 
     if (order != nullptr)
     {
+        toggleOrderHash(order);
         order->cancel();
             if (order->getParentLimit()->getSize() == 0)
             {   
@@ -256,7 +305,7 @@ void Book::cancelStopLimitOrder(int orderId)
             }
         deleteFromOrderMap(orderId);
         // stopLimitOrders.erase(order);
-        delete order;
+        orderPool.destroy(order);
     }
 }
 
@@ -268,6 +317,7 @@ void Book::modifyStopLimitOrder(int orderId, int newShares, int newLimitPrice, i
     Order* order = searchOrderMap(orderId);
     if (order != nullptr)
     {
+        toggleOrderHash(order);
         order->cancel();
             if (order->getParentLimit()->getSize() == 0)
             {
@@ -281,163 +331,1391 @@ void Book::modifyStopLimitOrder(int orderId, int newShares, int newLimitPrice, i
             addStop(newStopPrice, order->getBuyOrSell());
         }
         stopMap.at(newStopPrice)->append(order);
+        toggleOrderHash(order);
     }
 }
 
-// Get the height of a limit in a binary tree
-int Book::getLimitHeight(Limit* limit) const {
-    if (limit == nullptr) {
-        return 0; // Height of an empty tree is 0
-    } else {
-        int l_height = getLimitHeight(limit->getLeftChild());
-        int r_height = getLimitHeight(limit->getRightChild());
-        int max = std::max(l_height, r_height) + 1;
-        return max;
+// Fill up to limitPrice and discard whatever is left, so no order or level is ever created
+int Book::immediateOrCancelOrder(int orderId, bool buyOrSell, int shares, int limitPrice)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    if (auctionMode)
+    {
+        std::cerr << "Order " << orderId << " cannot trade during an auction" << std::endl;
+        return 0;
+    }
+    if (shares <= 0)
+    {
+        return 0;
+    }
+    int filledShares = shares - limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice);
+    if (filledShares != 0)
+    {
+        executeStopOrders(buyOrSell);
     }
+    return filledShares;
 }
 
-// Search the order map to find an order
-Order* Book::searchOrderMap(int orderId) const
+// Check the volume up to limitPrice first without touching the book, then either fill every
+// share or leave the book exactly as it was
+bool Book::fillOrKillOrder(int orderId, bool buyOrSell, int shares, int limitPrice)
 {
-    auto it = orderMap.find(orderId);
-    if (it != orderMap.end())
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    if (auctionMode)
     {
-        return it->second;
-    } else
+        std::cerr << "Order " << orderId << " cannot trade during an auction" << std::endl;
+        return false;
+    }
+    if (shares <= 0 || !hasVolume(buyOrSell, shares, limitPrice))
     {
-        std::cout << "No order number " << orderId << std::endl;
-        return nullptr;
+        return false;
     }
+    limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice);
+    executeStopOrders(buyOrSell);
+    return true;
 }
 
-// Search the limit maps to find a limit
-Limit* Book::searchLimitMaps(int limitPrice, bool buyOrSell) const
+// The protection price is fixed from the book edge on arrival, so the sweep stops there using the
+// same edge check as a limit order and never searches the tree for the bound
+int Book::protectedMarketOrder(int orderId, bool buyOrSell, int shares, int protection, bool restRemainder, int ownerId)
 {
-    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    if (shares <= 0)
+    {
+        return 0;
+    }
+    if (protection < 0)
+    {
+        std::cerr << "Invalid market order protection: " << protection << std::endl;
+        return shares;
+    }
+    if (auctionMode)
+    {
+        std::cerr << "Order " << orderId << " cannot trade during an auction" << std::endl;
+        return shares;
+    }
+    Limit* bookEdge = buyOrSell ? lowestSell : highestBuy;
+    if (bookEdge == nullptr)
+    {
+        std::cerr << "No price to protect market order " << orderId << std::endl;
+        return shares;
+    }
+    int bestPrice = bookEdge->getLimitPrice();
+    int limitPrice = buyOrSell ? (bestPrice > INT_MAX - protection ? INT_MAX : bestPrice + protection)
+        : (bestPrice < INT_MIN + protection ? INT_MIN : bestPrice - protection);
+    shares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
+    if (shares != 0 && restRemainder)
+    {
+        restLimitOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
+    }
+    executeStopOrders(buyOrSell);
+    return shares;
+}
 
-    auto it = limitMap.find(limitPrice);
-    if (it != limitMap.end())
+// Take liquidity with the full size first, then rest the remainder with only one slice showing
+void Book::addIcebergOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int displayShares)
+{
+    if (displayShares <= 0)
     {
-        return it->second;
-    } else
+        std::cerr << "Invalid iceberg display size: " << displayShares << std::endl;
+        return;
+    }
+    AVLTreeBalanceCount = 0;
+    shares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice);
+
+    if (shares != 0)
     {
-        std::cout << "No "<< (buyOrSell ? "buy " : "sell ") << "limit at " << limitPrice << std::endl;
-        return nullptr;
+        int visibleShares = shares < displayShares ? shares : displayShares;
+        Order* newOrder = orderPool.create(orderId, buyOrSell, visibleShares, limitPrice, displayShares, shares - visibleShares);
+        orderMap.emplace(orderId, newOrder);
+
+        auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+
+        if (limitMap.find(limitPrice) == limitMap.end())
+        {
+            addLimit(limitPrice, buyOrSell);
+        }
+        limitMap.at(limitPrice)->append(newOrder);
+        toggleOrderHash(newOrder);
+    } else {
+        executeStopOrders(buyOrSell);
     }
 }
 
-// Search the stop map to find a stop level
-Limit* Book::searchStopMap(int stopPrice) const
+// Good till time orders take liquidity and rest like limit orders, with an entry in the expiry wheel
+void Book::addGoodTillTimeOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int expiryTime)
 {
-    auto it = stopMap.find(stopPrice);
-    if (it != stopMap.end())
+    if (expiryTime <= expiryWheel.getTime())
     {
-        return it->second;
-    } else
+        std::cerr << "Good till time order " << orderId << " expires at " << expiryTime << ", which has passed" << std::endl;
+        return;
+    }
+    AVLTreeBalanceCount = 0;
+    shares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice);
+
+    if (shares != 0)
     {
-        std::cout << "No stop level at " << stopPrice << std::endl;
-        return nullptr;
+        Order* newOrder = orderPool.create(orderId, buyOrSell, shares, limitPrice, 0, 0, expiryTime);
+        orderMap.emplace(orderId, newOrder);
+
+        auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+
+        if (limitMap.find(limitPrice) == limitMap.end())
+        {
+            addLimit(limitPrice, buyOrSell);
+        }
+        limitMap.at(limitPrice)->append(newOrder);
+        toggleOrderHash(newOrder);
+        expiryWheel.schedule(orderId, expiryTime);
+    } else {
+        executeStopOrders(buyOrSell);
     }
 }
 
-void Book::printLimit(int limitPrice, bool buyOrSell) const
+int Book::advanceTime(int now, int budget)
 {
-    searchLimitMaps(limitPrice, buyOrSell)->print();
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    expiryWheel.advance(now);
+    int expired = 0;
+    TimingWheel::Entry entry;
+    while (expired < budget && expiryWheel.popDue(entry))
+    {
+        // The order id may have been reused since, so it has to be the same expiry as well
+        auto indexed = orderMap.find(entry.orderId);
+        if (indexed != orderMap.end() && indexed->second->getExpiryTime() == entry.expiryTime)
+        {
+            cancelLimitOrder(entry.orderId);
+            expired += 1;
+        }
+    }
+    return expired;
 }
 
-void Book::printOrder(int orderId) const
+void Book::setSelfTradePrevention(SelfTradePrevention mode)
 {
-    searchOrderMap(orderId)->print();
+    selfTradePrevention = mode;
 }
 
-void Book::printBookEdges() const
+SelfTradePrevention Book::getSelfTradePrevention() const
 {
-    std::cout << "Buy edge: " << highestBuy->getLimitPrice() 
-    << "Sell edge: " << lowestSell->getLimitPrice() << std::endl;
+    return selfTradePrevention;
 }
 
-// Print out all the limit and stop levels and their liquidity
-void Book::printOrderBook() const
+std::size_t Book::getPreventedSelfTradeCount() const
 {
-    std::vector<int> vec = inOrderTreeTraversal(getStopBuyTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchStopMap(vec[i])->getTotalVolume();
-        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
-            throw std::runtime_error("Error: vector is error");
-        }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
-        }
+    return preventedSelfTrades;
+}
+
+void Book::startAuction()
+{
+    auctionMode = true;
+}
+
+bool Book::inAuction() const
+{
+    return auctionMode;
+}
+
+// Only levels priced between the best sell and the best buy can trade, so the candidate prices
+// are theirs. Both sides' crossed levels are merged into ascending order, then one pass each way
+// sums the shares offered at or below and bid at or above every price, iceberg reserves included.
+bool Book::getAuctionPrice(int& price, int& volume, int referencePrice) const
+{
+    if (highestBuy == nullptr || lowestSell == nullptr || highestBuy->getLimitPrice() < lowestSell->getLimitPrice())
+    {
+        return false;
+    }
+    std::vector<Limit*> buyLevels, sellLevels;
+    for (Limit* level = highestBuy; level != nullptr && level->getLimitPrice() >= lowestSell->getLimitPrice(); level = nextLevel(level, false))
+    {
+        buyLevels.push_back(level);
+    }
+    for (Limit* level = lowestSell; level != nullptr && level->getLimitPrice() <= highestBuy->getLimitPrice(); level = nextLevel(level, true))
+    {
+        sellLevels.push_back(level);
     }
-    std::cout << "]" << std::endl;
 
-    vec = inOrderTreeTraversal(getStopSellTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchStopMap(vec[i])->getTotalVolume();
-        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
-            throw std::runtime_error("Error: Vector is error");
+    std::size_t candidateCount = buyLevels.size() + sellLevels.size();
+    std::vector<int> prices;
+    std::vector<std::int64_t> demand, supply;
+    prices.reserve(candidateCount);
+    demand.reserve(candidateCount);
+    supply.reserve(candidateCount);
+    auto nextBuy = buyLevels.rbegin();
+    auto nextSell = sellLevels.begin();
+    while (nextBuy != buyLevels.rend() || nextSell != sellLevels.end())
+    {
+        int candidate = nextSell == sellLevels.end() || (nextBuy != buyLevels.rend() && (*nextBuy)->getLimitPrice() < (*nextSell)->getLimitPrice())
+            ? (*nextBuy)->getLimitPrice() : (*nextSell)->getLimitPrice();
+        std::int64_t bid = 0, offer = 0;
+        if (nextBuy != buyLevels.rend() && (*nextBuy)->getLimitPrice() == candidate)
+        {
+            bid = (*nextBuy)->getTotalVolume() + (*nextBuy)->getHiddenVolume();
+            ++nextBuy;
         }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
+        if (nextSell != sellLevels.end() && (*nextSell)->getLimitPrice() == candidate)
+        {
+            offer = (*nextSell)->getTotalVolume() + (*nextSell)->getHiddenVolume();
+            ++nextSell;
         }
+        prices.push_back(candidate);
+        supply.push_back(offer + (supply.empty() ? 0 : supply.back()));
+        demand.push_back(bid);
+    }
+    for (std::size_t i = prices.size() - 1; i-- > 0;)
+    {
+        demand[i] += demand[i + 1];
     }
-    std::cout << "]" << std::endl;
 
-    vec = inOrderTreeTraversal(getBuyTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchLimitMaps(vec[i], true)->getTotalVolume();
-        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
-            throw std::runtime_error("Error: vector is error");
+    // Most volume first, then the smallest imbalance, keeping every price tied on both
+    std::int64_t bestVolume = -1, bestImbalance = 0;
+    std::vector<std::size_t> tied;
+    for (std::size_t i = 0; i < prices.size(); i++)
+    {
+        std::int64_t executable = std::min(demand[i], supply[i]);
+        std::int64_t imbalance = demand[i] > supply[i] ? demand[i] - supply[i] : supply[i] - demand[i];
+        if (executable > bestVolume || (executable == bestVolume && imbalance < bestImbalance))
+        {
+            bestVolume = executable;
+            bestImbalance = imbalance;
+            tied.clear();
         }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
+        if (executable == bestVolume && imbalance == bestImbalance)
+        {
+            tied.push_back(i);
         }
     }
-    std::cout << "]" << std::endl;
 
-    vec = inOrderTreeTraversal(getSellTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchLimitMaps(vec[i], false)->getTotalVolume();
-        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
-            throw std::runtime_error("Error: Vector is error");
-        }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
+    bool buyersLeft = true, sellersLeft = true;
+    for (std::size_t i : tied)
+    {
+        buyersLeft &= demand[i] > supply[i];
+        sellersLeft &= supply[i] > demand[i];
+    }
+    std::size_t chosen = tied[(tied.size() - 1) / 2];
+    if (buyersLeft)
+    {
+        chosen = tied.back();
+    } else if (sellersLeft)
+    {
+        chosen = tied.front();
+    } else if (referencePrice != INT_MIN)
+    {
+        auto distance = [referencePrice](int candidate) {
+            std::int64_t difference = std::int64_t(candidate) - referencePrice;
+            return difference < 0 ? -difference : difference;
+        };
+        for (std::size_t i : tied)
+        {
+            if (distance(prices[i]) < distance(prices[chosen]))
+            {
+                chosen = i;
+            }
         }
     }
-    std::cout << "]" << std::endl;
+    price = prices[chosen];
+    volume = static_cast<int>(bestVolume);
+    return true;
 }
 
-// In order traversal of the binary search tree
-std::vector<int> Book::inOrderTreeTraversal(Limit* root) const
+int Book::uncrossAuction(int referencePrice)
 {
-    std::vector<int> result;
-    if (root == nullptr)
-        return result;
-
-    std::vector<int> leftSubtree = inOrderTreeTraversal(root->getLeftChild());
-    result.insert(result.end(), leftSubtree.begin(), leftSubtree.end());
-    
-    result.push_back(root->getLimitPrice());
-
-    std::vector<int> rightSubtree = inOrderTreeTraversal(root->getRightChild());
-    result.insert(result.end(), rightSubtree.begin(), rightSubtree.end());
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    if (!auctionMode)
+    {
+        std::cerr << "No auction to uncross" << std::endl;
+        return 0;
+    }
+    int price, volume = 0;
+    if (getAuctionPrice(price, volume, referencePrice))
+    {
+        fillAuctionSide(true, volume);
+        fillAuctionSide(false, volume);
+    }
+    auctionMode = false;
+    executeStopOrders(true);
+    executeStopOrders(false);
+    return volume;
+}
 
-    return result;
+int Book::getTime() const
+{
+    return expiryWheel.getTime();
 }
 
-// Pre order traversal of the binary search tree
-std::vector<int> Book::preOrderTreeTraversal(Limit* root) const
+std::size_t Book::getPendingExpiryCount() const
 {
-    std::vector<int> result;
-    if (root == nullptr)
-        return result;
+    return expiryWheel.getDueCount();
+}
 
-    result.push_back(root->getLimitPrice());
+int Book::cancelOwnerOrders(int ownerId)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    auto indexed = ownerOrders.find(ownerId);
+    if (indexed == ownerOrders.end())
+    {
+        std::cout << "No orders for owner " << ownerId << std::endl;
+        return 0;
+    }
+    Order* order = indexed->second;
+    ownerOrders.erase(indexed);
+
+    std::vector<Limit*> emptied[2];
+    int cancelled = 0;
+    while (order != nullptr)
+    {
+        Order* nextOrder = order->nextOwnerOrder;
+        Limit* level = order->getParentLimit();
+        toggleOrderHash(order);
+        order->cancel();
+        if (level->getSize() == 0)
+        {
+            emptied[level->getBuyOrSell()].push_back(level);
+        }
+        orderMap.erase(order->getOrderId());
+        orderPool.destroy(order);
+        cancelled += 1;
+        order = nextOrder;
+    }
+    removeEmptiedLevels(emptied[0], false);
+    removeEmptiedLevels(emptied[1], true);
+    return cancelled;
+}
+
+int Book::massCancel(bool buyOrSell, int lowPrice, int highPrice)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    std::vector<Limit*> emptied;
+    int cancelled = cancelLevelsInRange(buyOrSell ? buyTree : sellTree, lowPrice, highPrice, emptied);
+    removeEmptiedLevels(emptied, buyOrSell);
+    return cancelled;
+}
+
+// Pegged orders never take liquidity when they arrive, they only rest in their group
+void Book::addPeggedOrder(int orderId, bool buyOrSell, int shares, PegType pegType, int offset)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    if (pegType != PegType::Primary && pegType != PegType::Midpoint && pegType != PegType::Market)
+    {
+        std::cerr << "Invalid peg type: " << static_cast<int>(pegType) << std::endl;
+        return;
+    }
+    auto& groups = pegGroups[buyOrSell][static_cast<int>(pegType)];
+    auto group = groups.find(offset);
+    if (group == groups.end())
+    {
+        group = groups.emplace(offset, limitPool.create(offset, buyOrSell)).first;
+        togglePegGroupHash(group->second, pegType);
+    }
+    Order* newOrder = orderPool.create(orderId, buyOrSell, shares, offset);
+    pegOrderMap.emplace(orderId, newOrder);
+    group->second->append(newOrder);
+    toggleOrderHash(newOrder);
+    pegCounts[buyOrSell] += 1;
+}
+
+void Book::cancelPeggedOrder(int orderId)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    auto indexed = pegOrderMap.find(orderId);
+    if (indexed == pegOrderMap.end())
+    {
+        std::cout << "No pegged order number " << orderId << std::endl;
+        return;
+    }
+    Order* order = indexed->second;
+    Limit* group = order->getParentLimit();
+    PegType pegType = findPegType(order);
+    toggleOrderHash(order);
+    order->cancel();
+    if (group->getSize() == 0)
+    {
+        togglePegGroupHash(group, pegType);
+        pegGroups[order->getBuyOrSell()][static_cast<int>(pegType)].erase(group->getLimitPrice());
+        limitPool.destroy(group);
+    }
+    pegCounts[order->getBuyOrSell()] -= 1;
+    pegOrderMap.erase(indexed);
+    orderPool.destroy(order);
+}
+
+bool Book::getPeggedPrice(int orderId, int& price) const
+{
+    auto indexed = pegOrderMap.find(orderId);
+    if (indexed == pegOrderMap.end())
+    {
+        return false;
+    }
+    const Order* order = indexed->second;
+    return pegPrice(order->getBuyOrSell(), findPegType(order), order->getLimit(), highestBuy != nullptr ? highestBuy->getLimitPrice() : INT_MIN,
+        lowestSell != nullptr ? lowestSell->getLimitPrice() : INT_MAX, price);
+}
+
+// The stop joins the newest epoch, which always holds the current reference price as its high water mark
+void Book::addTrailingStopOrder(int orderId, bool buyOrSell, int shares, int offset)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    if (offset <= 0)
+    {
+        std::cerr << "Invalid trailing stop offset: " << offset << std::endl;
+        return;
+    }
+    int reference = trailingReference(buyOrSell);
+    if (reference == INT_MIN)
+    {
+        std::cerr << "No price for trailing stop " << orderId << " to follow" << std::endl;
+        return;
+    }
+    auto& epochs = trailingEpochs[buyOrSell];
+    raiseTrailingWatermark(buyOrSell);
+    if (epochs.empty() || epochs.back().highWaterMark != reference)
+    {
+        epochs.emplace_back(reference, orderMap.get_allocator().getArena());
+        toggleTrailingEpochHash(buyOrSell, reference);
+    }
+    TrailingEpoch& epoch = epochs.back();
+
+    // Stops merged in from older epochs come first among equal offsets, so join the last group
+    auto group = epoch.groups.upper_bound(offset);
+    if (group == epoch.groups.begin() || std::prev(group)->first != offset)
+    {
+        group = epoch.groups.emplace_hint(group, offset, limitPool.create(offset, buyOrSell));
+    } else {
+        group = std::prev(group);
+    }
+    Order* newOrder = orderPool.create(orderId, buyOrSell, shares, offset);
+    trailingOrderMap.emplace(orderId, newOrder);
+    group->second->append(newOrder);
+    toggleOrderHash(newOrder);
+    trailingCounts[buyOrSell] += 1;
+    updateTrailingTrigger(buyOrSell, static_cast<int>(epochs.size()) - 1);
+}
+
+// Emptied groups are left in their epoch and dropped when they next trigger
+void Book::cancelTrailingStopOrder(int orderId)
+{
+    executedOrdersCount = 0;
+    AVLTreeBalanceCount = 0;
+    auto indexed = trailingOrderMap.find(orderId);
+    if (indexed == trailingOrderMap.end())
+    {
+        std::cout << "No trailing stop number " << orderId << std::endl;
+        return;
+    }
+    Order* order = indexed->second;
+    toggleOrderHash(order);
+    order->cancel();
+    trailingCounts[order->getBuyOrSell()] -= 1;
+    trailingOrderMap.erase(indexed);
+    orderPool.destroy(order);
+}
+
+bool Book::getTrailingStopPrice(int orderId, int& stopPrice) const
+{
+    auto indexed = trailingOrderMap.find(orderId);
+    if (indexed == trailingOrderMap.end())
+    {
+        return false;
+    }
+    const Order* order = indexed->second;
+    for (const TrailingEpoch& epoch : trailingEpochs[order->getBuyOrSell()])
+    {
+        auto [first, last] = epoch.groups.equal_range(order->getLimit());
+        for (auto group = first; group != last; ++group)
+        {
+            if (group->second == order->getParentLimit())
+            {
+                int trigger = epoch.highWaterMark - order->getLimit();
+                stopPrice = order->getBuyOrSell() ? -trigger : trigger;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Snapshot layout: header with the sequence number, order count, clock and auction flag, then the buy, sell, stop buy and stop sell trees. Each tree is a
+// level count followed by its levels in ascending price order, and each level is its price,
+// its order count, its append count and its orders from head to tail. Each order is its id, shares, limit,
+// iceberg display size, hidden shares, expiry time, owner and queue position. The trees are followed by the pegged groups of each
+// side and peg type, in the same form with the offset in place of the price, and then by the
+// trailing stop epochs of each side, oldest first, as a high water mark and its offset groups.
+static const char snapshotMagic[8] = {'L', 'O', 'B', 'S', 'N', 'A', 'P', '8'};
+
+template <typename T>
+static void writeToBuffer(char*& cursor, T value)
+{
+    std::memcpy(cursor, &value, sizeof(T));
+    cursor += sizeof(T);
+}
+
+template <typename T>
+static bool readFromBuffer(const char* data, std::size_t size, std::size_t& position, T& value)
+{
+    if (size - position < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, data + position, sizeof(T));
+    position += sizeof(T);
+    return true;
+}
+
+static void writeLevel(const Limit* level, char*& cursor)
+{
+    writeToBuffer<std::int32_t>(cursor, level->getLimitPrice());
+    writeToBuffer<std::uint32_t>(cursor, level->getSize());
+    writeToBuffer<std::uint32_t>(cursor, level->getAppendCount());
+    for (Order* order = level->getHeadOrder(); order != nullptr; order = order->getNextOrder())
+    {
+        writeToBuffer<std::int32_t>(cursor, order->getOrderId());
+        writeToBuffer<std::int32_t>(cursor, order->getShares());
+        writeToBuffer<std::int32_t>(cursor, order->getLimit());
+        writeToBuffer<std::int32_t>(cursor, order->getDisplayShares());
+        writeToBuffer<std::int32_t>(cursor, order->getHiddenShares());
+        writeToBuffer<std::int32_t>(cursor, order->getExpiryTime());
+        writeToBuffer<std::int32_t>(cursor, order->getOwnerId());
+        writeToBuffer<std::uint32_t>(cursor, order->getQueuePosition());
+    }
+}
+
+// Serialize the whole book into a compact binary snapshot
+std::vector<char> Book::serializeSnapshot(std::uint64_t sequenceNumber) const
+{
+    std::size_t levelCount = limitBuyMap.size() + limitSellMap.size() + stopMap.size();
+    for (const auto& sideGroups : pegGroups)
+    {
+        for (const auto& groups : sideGroups)
+        {
+            levelCount += groups.size();
+        }
+    }
+    std::size_t epochCount = trailingEpochs[0].size() + trailingEpochs[1].size();
+    for (const auto& epochs : trailingEpochs)
+    {
+        for (const TrailingEpoch& epoch : epochs)
+        {
+            for (const auto& group : epoch.groups)
+            {
+                levelCount += group.second->getSize() != 0;
+            }
+        }
+    }
+    std::vector<char> buffer(sizeof(snapshotMagic) + 2 * sizeof(std::uint64_t) + sizeof(std::int32_t) + sizeof(std::uint8_t) + 12 * sizeof(std::uint32_t)
+        + levelCount * (sizeof(std::int32_t) + 2 * sizeof(std::uint32_t)) + epochCount * (sizeof(std::int32_t) + sizeof(std::uint32_t))
+        + (orderMap.size() + pegOrderMap.size() + trailingOrderMap.size()) * (7 * sizeof(std::int32_t) + sizeof(std::uint32_t)));
+    char* cursor = buffer.data();
+    std::memcpy(cursor, snapshotMagic, sizeof(snapshotMagic));
+    cursor += sizeof(snapshotMagic);
+    writeToBuffer<std::uint64_t>(cursor, sequenceNumber);
+    writeToBuffer<std::uint64_t>(cursor, orderMap.size());
+    writeToBuffer<std::int32_t>(cursor, expiryWheel.getTime());
+    writeToBuffer<std::uint8_t>(cursor, auctionMode);
+
+    for (Limit* tree : {buyTree, sellTree, stopBuyTree, stopSellTree})
+    {
+        char* countPosition = cursor;
+        cursor += sizeof(std::uint32_t);
+        std::uint32_t treeLevelCount = serializeLevels(tree, cursor);
+        std::memcpy(countPosition, &treeLevelCount, sizeof(treeLevelCount));
+    }
+    for (const auto& sideGroups : pegGroups)
+    {
+        for (const auto& groups : sideGroups)
+        {
+            writeToBuffer<std::uint32_t>(cursor, groups.size());
+            for (const auto& group : groups)
+            {
+                writeLevel(group.second, cursor);
+            }
+        }
+    }
+    for (const auto& epochs : trailingEpochs)
+    {
+        writeToBuffer<std::uint32_t>(cursor, epochs.size());
+        for (const TrailingEpoch& epoch : epochs)
+        {
+            std::uint32_t groupCount = 0;
+            for (const auto& group : epoch.groups)
+            {
+                groupCount += group.second->getSize() != 0;
+            }
+            writeToBuffer<std::int32_t>(cursor, epoch.highWaterMark);
+            writeToBuffer<std::uint32_t>(cursor, groupCount);
+            for (const auto& group : epoch.groups)
+            {
+                if (group.second->getSize() != 0)
+                {
+                    writeLevel(group.second, cursor);
+                }
+            }
+        }
+    }
+    return buffer;
+}
+
+// Write the levels of a tree in ascending price order, returning how many were written
+std::uint32_t Book::serializeLevels(Limit* root, char*& cursor) const
+{
+    if (root == nullptr)
+    {
+        return 0;
+    }
+    std::uint32_t levelCount = serializeLevels(root->getLeftChild(), cursor);
+    writeLevel(root, cursor);
+    return levelCount + 1 + serializeLevels(root->getRightChild(), cursor);
+}
+
+// Replace the contents of the book with a snapshot. Levels arrive sorted, so each tree is
+// built balanced directly from its level array in O(n) instead of through rebalancing inserts.
+bool Book::restoreSnapshot(const char* data, std::size_t size, std::uint64_t* sequenceNumber)
+{
+    std::size_t position = sizeof(snapshotMagic);
+    std::uint64_t snapshotSequence, orderCount;
+    std::int32_t time;
+    std::uint8_t auction;
+    if (size < sizeof(snapshotMagic) || std::memcmp(data, snapshotMagic, sizeof(snapshotMagic)) != 0
+        || !readFromBuffer(data, size, position, snapshotSequence) || !readFromBuffer(data, size, position, orderCount)
+        || !readFromBuffer(data, size, position, time) || !readFromBuffer(data, size, position, auction))
+    {
+        std::cerr << "Invalid snapshot header" << std::endl;
+        return false;
+    }
+
+    clear();
+    // Expired orders the snapshot still holds are due again straight away
+    expiryWheel.clear(time);
+    auctionMode = auction != 0;
+    orderMap.reserve(orderCount);
+    Limit** trees[4] = {&buyTree, &sellTree, &stopBuyTree, &stopSellTree};
+    for (int treeIndex = 0; treeIndex < 4; treeIndex++)
+    {
+        bool buyOrSell = treeIndex % 2 == 0;
+        bool stopTree = treeIndex >= 2;
+        auto& levelMap = stopTree ? stopMap : (buyOrSell ? limitBuyMap : limitSellMap);
+
+        std::uint32_t levelCount;
+        if (!readFromBuffer(data, size, position, levelCount))
+        {
+            std::cerr << "Truncated snapshot" << std::endl;
+            clear();
+            return false;
+        }
+        std::vector<Limit*> levels;
+        levels.reserve(levelCount);
+        levelMap.reserve(levelMap.size() + levelCount);
+
+        for (std::uint32_t i = 0; i < levelCount; i++)
+        {
+            std::int32_t price;
+            std::uint32_t levelSize;
+            if (!readFromBuffer(data, size, position, price) || !readFromBuffer(data, size, position, levelSize))
+            {
+                std::cerr << "Truncated snapshot" << std::endl;
+                clear();
+                return false;
+            }
+            Limit* level = limitPool.create(price, buyOrSell);
+            levels.push_back(level);
+            levelMap.emplace(price, level);
+            toggleLevelHash(level, stopTree);
+            if (!restoreOrders(data, size, position, level, levelSize, orderMap))
+            {
+                std::cerr << "Truncated snapshot" << std::endl;
+                clear();
+                return false;
+            }
+        }
+
+        *trees[treeIndex] = buildTree(levels, 0, static_cast<int>(levels.size()) - 1, nullptr);
+        if (!levels.empty())
+        {
+            if (stopTree)
+            {
+                (buyOrSell ? lowestStopBuy : highestStopSell) = buyOrSell ? levels.front() : levels.back();
+            } else {
+                (buyOrSell ? highestBuy : lowestSell) = buyOrSell ? levels.back() : levels.front();
+            }
+        }
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        for (int type = 0; type < 3; type++)
+        {
+            std::uint32_t groupCount;
+            if (!readFromBuffer(data, size, position, groupCount))
+            {
+                std::cerr << "Truncated snapshot" << std::endl;
+                clear();
+                return false;
+            }
+            for (std::uint32_t i = 0; i < groupCount; i++)
+            {
+                std::int32_t offset;
+                std::uint32_t groupSize;
+                if (!readFromBuffer(data, size, position, offset) || !readFromBuffer(data, size, position, groupSize))
+                {
+                    std::cerr << "Truncated snapshot" << std::endl;
+                    clear();
+                    return false;
+                }
+                Limit* group = limitPool.create(offset, side == 1);
+                pegGroups[side][type].emplace_hint(pegGroups[side][type].end(), offset, group);
+                togglePegGroupHash(group, static_cast<PegType>(type));
+                if (!restoreOrders(data, size, position, group, groupSize, pegOrderMap))
+                {
+                    std::cerr << "Truncated snapshot" << std::endl;
+                    clear();
+                    return false;
+                }
+                pegCounts[side] += groupSize;
+            }
+        }
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        std::uint32_t epochCount;
+        if (!readFromBuffer(data, size, position, epochCount))
+        {
+            std::cerr << "Truncated snapshot" << std::endl;
+            clear();
+            return false;
+        }
+        for (std::uint32_t i = 0; i < epochCount; i++)
+        {
+            std::int32_t highWaterMark;
+            std::uint32_t groupCount;
+            if (!readFromBuffer(data, size, position, highWaterMark) || !readFromBuffer(data, size, position, groupCount))
+            {
+                std::cerr << "Truncated snapshot" << std::endl;
+                clear();
+                return false;
+            }
+            TrailingEpoch& epoch = trailingEpochs[side].emplace_back(highWaterMark, orderMap.get_allocator().getArena());
+            toggleTrailingEpochHash(side == 1, highWaterMark);
+            for (std::uint32_t j = 0; j < groupCount; j++)
+            {
+                std::int32_t offset;
+                std::uint32_t groupSize;
+                if (!readFromBuffer(data, size, position, offset) || !readFromBuffer(data, size, position, groupSize))
+                {
+                    std::cerr << "Truncated snapshot" << std::endl;
+                    clear();
+                    return false;
+                }
+                Limit* group = limitPool.create(offset, side == 1);
+                epoch.groups.emplace_hint(epoch.groups.end(), offset, group);
+                if (!restoreOrders(data, size, position, group, groupSize, trailingOrderMap))
+                {
+                    std::cerr << "Truncated snapshot" << std::endl;
+                    clear();
+                    return false;
+                }
+                trailingCounts[side] += groupSize;
+            }
+            updateTrailingTrigger(side == 1, static_cast<int>(i));
+        }
+    }
+    if (position != size)
+    {
+        std::cerr << "Snapshot has " << size - position << " unread bytes" << std::endl;
+        clear();
+        return false;
+    }
+
+    if (sequenceNumber != nullptr)
+    {
+        *sequenceNumber = snapshotSequence;
+    }
+    return true;
+}
+
+// Read a level's append count and orders from a snapshot into the back of its queue and an
+// order index, keeping each order's original queue position
+bool Book::restoreOrders(const char* data, std::size_t size, std::size_t& position, Limit* level, std::uint32_t levelSize, ArenaMap<int, Order*>& index)
+{
+    std::uint32_t appendCount;
+    if (!readFromBuffer(data, size, position, appendCount))
+    {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < levelSize; i++)
+    {
+        std::int32_t orderId, shares, limit, displayShares, hiddenShares, expiryTime, ownerId;
+        std::uint32_t queuePosition;
+        if (!readFromBuffer(data, size, position, orderId) || !readFromBuffer(data, size, position, shares)
+            || !readFromBuffer(data, size, position, limit) || !readFromBuffer(data, size, position, displayShares)
+            || !readFromBuffer(data, size, position, hiddenShares) || !readFromBuffer(data, size, position, expiryTime)
+            || !readFromBuffer(data, size, position, ownerId) || !readFromBuffer(data, size, position, queuePosition))
+        {
+            return false;
+        }
+        Order* order = orderPool.create(orderId, level->getBuyOrSell(), shares, limit, displayShares, hiddenShares, expiryTime, ownerId);
+        index.emplace(orderId, order);
+        level->append(order);
+        order->queuePosition = queuePosition;
+        toggleOrderHash(order);
+        if (ownerId != 0)
+        {
+            linkOwnerOrder(order);
+        }
+        if (expiryTime != 0)
+        {
+            expiryWheel.schedule(orderId, expiryTime);
+        }
+    }
+    level->appendCount = appendCount;
+    return true;
+}
+
+bool Book::saveSnapshot(const std::string& filename, std::uint64_t sequenceNumber) const
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening snapshot file: " << filename << std::endl;
+        return false;
+    }
+    std::vector<char> buffer = serializeSnapshot(sequenceNumber);
+    file.write(buffer.data(), buffer.size());
+    return file.good();
+}
+
+bool Book::loadSnapshot(const std::string& filename, std::uint64_t* sequenceNumber)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening snapshot file: " << filename << std::endl;
+        return false;
+    }
+    std::vector<char> buffer(file.tellg());
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+    return restoreSnapshot(buffer.data(), buffer.size(), sequenceNumber);
+}
+
+// Build a balanced tree from levels sorted by price, returning its root
+Limit* Book::buildTree(std::vector<Limit*>& levels, int start, int end, Limit* parent)
+{
+    if (start > end)
+    {
+        return nullptr;
+    }
+    int middle = start + (end - start) / 2;
+    Limit* root = levels[middle];
+    root->setParent(parent);
+    root->setLeftChild(buildTree(levels, start, middle - 1, root));
+    root->setRightChild(buildTree(levels, middle + 1, end, root));
+    updateLimitHeight(root);
+    return root;
+}
+
+// splitmix64 finalizer
+static inline std::uint64_t mixHash(std::uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+static std::uint64_t orderStateHash(const Order* order)
+{
+    std::uint64_t identity = (std::uint64_t(std::uint32_t(order->getOrderId())) << 32) | std::uint32_t(order->getShares());
+    std::uint64_t placement = (std::uint64_t(std::uint32_t(order->getLimit())) << 32) | std::uint32_t(order->getParentLimit()->getLimitPrice());
+    // The reserve, expiry and owner terms are 0 for ordinary orders, since mixHash(0) is 0. All are
+    // nested inside the identity term, so equal values on two orders cannot cancel each other out.
+    std::uint64_t reserve = (std::uint64_t(std::uint32_t(order->getHiddenShares())) << 32) | std::uint32_t(order->getDisplayShares());
+    std::uint64_t expiry = std::uint64_t(std::uint32_t(order->getExpiryTime())) * 0x9e3779b97f4a7c15ULL;
+    std::uint64_t owner = std::uint64_t(std::uint32_t(order->getOwnerId())) * 0xc2b2ae3d27d4eb4fULL;
+    // The queue position makes the hash see FIFO priority, not just which orders rest where
+    std::uint64_t queue = std::uint64_t(order->getQueuePosition()) * 0xd1b54a32d192ed03ULL;
+    return mixHash(identity ^ mixHash((placement + order->getBuyOrSell()) ^ mixHash(queue ^ mixHash(reserve ^ mixHash(expiry ^ mixHash(owner))))));
+}
+
+static std::uint64_t levelStateHash(const Limit* level, bool stopLevel)
+{
+    std::uint64_t key = (std::uint64_t(std::uint32_t(level->getLimitPrice())) << 2) | (level->getBuyOrSell() << 1) | stopLevel;
+    return mixHash(key ^ 0x9e3779b97f4a7c15ULL);
+}
+
+static std::uint64_t trailingEpochStateHash(bool buyOrSell, int highWaterMark)
+{
+    std::uint64_t key = (std::uint64_t(std::uint32_t(highWaterMark)) << 1) | buyOrSell;
+    return mixHash(key ^ 0x2545f4914f6cdd1dULL);
+}
+
+static std::uint64_t pegGroupStateHash(const Limit* group, PegType pegType)
+{
+    std::uint64_t key = (std::uint64_t(std::uint32_t(group->getLimitPrice())) << 3) | (static_cast<int>(pegType) << 1) | group->getBuyOrSell();
+    return mixHash(key ^ 0xd6e8feb86659fd93ULL);
+}
+
+// Toggling the same state twice cancels out, so each change XORs out the old state and in the new
+void Book::toggleOrderHash(const Order* order)
+{
+    stateHash ^= orderStateHash(order);
+}
+
+void Book::toggleLevelHash(const Limit* level, bool stopLevel)
+{
+    stateHash ^= levelStateHash(level, stopLevel);
+}
+
+void Book::toggleTrailingEpochHash(bool buyOrSell, int highWaterMark)
+{
+    stateHash ^= trailingEpochStateHash(buyOrSell, highWaterMark);
+}
+
+void Book::togglePegGroupHash(const Limit* group, PegType pegType)
+{
+    stateHash ^= pegGroupStateHash(group, pegType);
+}
+
+std::uint64_t Book::getStateHash() const
+{
+    return stateHash;
+}
+
+// Verify the structure of the whole book, reporting the first problem found
+bool Book::checkConsistency() const
+{
+    std::size_t buyLevels = 0, sellLevels = 0, stopLevels = 0, orderCount = 0;
+    std::uint64_t hash = 0;
+    if (!checkLevels(buyTree, nullptr, false, buyLevels, orderCount, hash) || !checkLevels(sellTree, nullptr, false, sellLevels, orderCount, hash)
+        || !checkLevels(stopBuyTree, nullptr, true, stopLevels, orderCount, hash) || !checkLevels(stopSellTree, nullptr, true, stopLevels, orderCount, hash)
+        || !checkPegGroups(hash) || !checkTrailingStops(hash))
+    {
+        return false;
+    }
+    if (hash != stateHash)
+    {
+        std::cerr << "State hash does not match the book" << std::endl;
+        return false;
+    }
+    if (buyLevels != limitBuyMap.size() || sellLevels != limitSellMap.size() || stopLevels != stopMap.size() || orderCount != orderMap.size())
+    {
+        std::cerr << "Level or order index does not match the trees" << std::endl;
+        return false;
+    }
+
+    std::unordered_set<std::uint64_t> scheduled;
+    expiryWheel.forEach([&scheduled](const TimingWheel::Entry& entry) {
+        scheduled.insert((std::uint64_t(std::uint32_t(entry.orderId)) << 32) | std::uint32_t(entry.expiryTime));
+    });
+    std::size_t ownedCount = 0;
+    for (const auto& [orderId, order] : orderMap)
+    {
+        if (order->getExpiryTime() != 0 && scheduled.count((std::uint64_t(std::uint32_t(orderId)) << 32) | std::uint32_t(order->getExpiryTime())) == 0)
+        {
+            std::cerr << "Good till time order " << orderId << " is not in the expiry wheel" << std::endl;
+            return false;
+        }
+        ownedCount += order->getOwnerId() != 0;
+    }
+    for (const auto& [ownerId, head] : ownerOrders)
+    {
+        Order* previous = nullptr;
+        for (Order* order = head; order != nullptr; order = order->nextOwnerOrder)
+        {
+            auto indexed = orderMap.find(order->getOrderId());
+            if (order->getOwnerId() != ownerId || order->prevOwnerOrder != previous || indexed == orderMap.end() || indexed->second != order
+                || ownedCount == 0)
+            {
+                std::cerr << "Inconsistent order list for owner " << ownerId << std::endl;
+                return false;
+            }
+            ownedCount -= 1;
+            previous = order;
+        }
+    }
+    if (ownedCount != 0)
+    {
+        std::cerr << "Owner order lists do not match the order index" << std::endl;
+        return false;
+    }
+
+    Limit* edges[4] = {buyTree, sellTree, stopBuyTree, stopSellTree};
+    for (int i = 0; i < 4; i++)
+    {
+        // Buy edges are the highest price and sell edges the lowest, the other way round for stops
+        bool rightmost = (i == 0 || i == 3);
+        Limit* edge = edges[i];
+        while (edge != nullptr && (rightmost ? edge->getRightChild() : edge->getLeftChild()) != nullptr)
+        {
+            edge = rightmost ? edge->getRightChild() : edge->getLeftChild();
+        }
+        edges[i] = edge;
+    }
+    if (edges[0] != highestBuy || edges[1] != lowestSell || edges[2] != lowestStopBuy || edges[3] != highestStopSell)
+    {
+        std::cerr << "Book edges do not match the trees" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Book::checkLevels(Limit* root, Limit* parent, bool stopTree, std::size_t& levelCount, std::size_t& orderCount, std::uint64_t& hash) const
+{
+    if (root == nullptr)
+    {
+        return true;
+    }
+    int price = root->getLimitPrice();
+    const auto& levelMap = stopTree ? stopMap : (root->getBuyOrSell() ? limitBuyMap : limitSellMap);
+    auto level = levelMap.find(price);
+    if (root->getParent() != parent || level == levelMap.end() || level->second != root
+        || (root->getLeftChild() != nullptr && root->getLeftChild()->getLimitPrice() >= price)
+        || (root->getRightChild() != nullptr && root->getRightChild()->getLimitPrice() <= price)
+        || root->height != std::max(getLimitHeight(root->getLeftChild()), getLimitHeight(root->getRightChild())) + 1)
+    {
+        std::cerr << "Inconsistent level at price " << price << std::endl;
+        return false;
+    }
+
+    int size = 0;
+    int totalVolume = 0;
+    int hiddenVolume = 0;
+    for (Order* order = root->getHeadOrder(); order != nullptr; order = order->getNextOrder())
+    {
+        auto indexed = orderMap.find(order->getOrderId());
+        if (order->getParentLimit() != root || indexed == orderMap.end() || indexed->second != order || size > root->getSize())
+        {
+            std::cerr << "Inconsistent order queue at price " << price << std::endl;
+            return false;
+        }
+        size += 1;
+        totalVolume += order->getShares();
+        hiddenVolume += order->getHiddenShares();
+        hash ^= orderStateHash(order);
+    }
+    if (size != root->getSize() || totalVolume != root->getTotalVolume() || hiddenVolume != root->getHiddenVolume())
+    {
+        std::cerr << "Inconsistent size or volume at price " << price << std::endl;
+        return false;
+    }
+    levelCount += 1;
+    orderCount += size;
+    hash ^= levelStateHash(root, stopTree);
+
+    return checkLevels(root->getLeftChild(), root, stopTree, levelCount, orderCount, hash)
+        && checkLevels(root->getRightChild(), root, stopTree, levelCount, orderCount, hash);
+}
+
+bool Book::checkPegGroups(std::uint64_t& hash) const
+{
+    std::size_t pegCount = 0;
+    for (int side = 0; side < 2; side++)
+    {
+        int sideCount = 0;
+        for (int type = 0; type < 3; type++)
+        {
+            for (const auto& [offset, group] : pegGroups[side][type])
+            {
+                int size = 0;
+                int totalVolume = 0;
+                for (Order* order = group->getHeadOrder(); order != nullptr; order = order->getNextOrder())
+                {
+                    auto indexed = pegOrderMap.find(order->getOrderId());
+                    if (order->getParentLimit() != group || order->getLimit() != offset || indexed == pegOrderMap.end()
+                        || indexed->second != order || size > group->getSize())
+                    {
+                        std::cerr << "Inconsistent pegged group at offset " << offset << std::endl;
+                        return false;
+                    }
+                    size += 1;
+                    totalVolume += order->getShares();
+                    hash ^= orderStateHash(order);
+                }
+                if (group->getLimitPrice() != offset || group->getBuyOrSell() != (side == 1) || size == 0
+                    || size != group->getSize() || totalVolume != group->getTotalVolume())
+                {
+                    std::cerr << "Inconsistent pegged group at offset " << offset << std::endl;
+                    return false;
+                }
+                sideCount += size;
+                hash ^= pegGroupStateHash(group, static_cast<PegType>(type));
+            }
+        }
+        if (sideCount != pegCounts[side])
+        {
+            std::cerr << "Pegged order count does not match the groups" << std::endl;
+            return false;
+        }
+        pegCount += sideCount;
+    }
+    if (pegCount != pegOrderMap.size())
+    {
+        std::cerr << "Pegged order index does not match the groups" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Book::checkTrailingStops(std::uint64_t& hash) const
+{
+    std::size_t trailingCount = 0;
+    for (int side = 0; side < 2; side++)
+    {
+        const auto& epochs = trailingEpochs[side];
+        int sideCount = 0;
+        std::size_t indexedCount = 0;
+        for (std::size_t i = 0; i < epochs.size(); i++)
+        {
+            const TrailingEpoch& epoch = epochs[i];
+            // Older epochs hold the higher water marks
+            if (i != 0 && epoch.highWaterMark >= epochs[i - 1].highWaterMark)
+            {
+                std::cerr << "Trailing stop epochs out of order at " << epoch.highWaterMark << std::endl;
+                return false;
+            }
+            for (const auto& [offset, group] : epoch.groups)
+            {
+                int size = 0;
+                int totalVolume = 0;
+                for (Order* order = group->getHeadOrder(); order != nullptr; order = order->getNextOrder())
+                {
+                    auto indexed = trailingOrderMap.find(order->getOrderId());
+                    if (order->getParentLimit() != group || order->getLimit() != offset || indexed == trailingOrderMap.end()
+                        || indexed->second != order || size > group->getSize())
+                    {
+                        std::cerr << "Inconsistent trailing stop group at offset " << offset << std::endl;
+                        return false;
+                    }
+                    size += 1;
+                    totalVolume += order->getShares();
+                    hash ^= orderStateHash(order);
+                }
+                if (group->getLimitPrice() != offset || group->getBuyOrSell() != (side == 1) || size != group->getSize()
+                    || totalVolume != group->getTotalVolume())
+                {
+                    std::cerr << "Inconsistent trailing stop group at offset " << offset << std::endl;
+                    return false;
+                }
+                sideCount += size;
+            }
+            bool indexed = !epoch.groups.empty();
+            if (epoch.indexed != indexed || (indexed && (epoch.triggerPrice != epoch.highWaterMark - epoch.groups.begin()->first
+                || trailingTriggers[side].count({epoch.triggerPrice, static_cast<int>(i)}) == 0)))
+            {
+                std::cerr << "Trailing stop trigger index does not match epoch " << i << std::endl;
+                return false;
+            }
+            indexedCount += indexed;
+            hash ^= trailingEpochStateHash(side == 1, epoch.highWaterMark);
+        }
+        if (indexedCount != trailingTriggers[side].size() || sideCount != trailingCounts[side])
+        {
+            std::cerr << "Trailing stop count does not match the epochs" << std::endl;
+            return false;
+        }
+        trailingCount += sideCount;
+    }
+    if (trailingCount != trailingOrderMap.size())
+    {
+        std::cerr << "Trailing stop index does not match the epochs" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Remove every order and level from the book
+void Book::clear()
+{
+    orderMap.clear();
+    limitBuyMap.clear();
+    limitSellMap.clear();
+    stopMap.clear();
+    ownerOrders.clear();
+    pegOrderMap.clear();
+    for (auto& sideGroups : pegGroups)
+    {
+        for (auto& groups : sideGroups)
+        {
+            groups.clear();
+        }
+    }
+    pegCounts[0] = pegCounts[1] = 0;
+    trailingOrderMap.clear();
+    for (int side = 0; side < 2; side++)
+    {
+        trailingEpochs[side].clear();
+        trailingTriggers[side].clear();
+    }
+    trailingCounts[0] = trailingCounts[1] = 0;
+    expiryWheel.clear(expiryWheel.getTime());
+    auctionMode = false;
+    orderPool.reset();
+    limitPool.reset();
+    stateHash = 0;
+    buyTree = sellTree = lowestSell = highestBuy = nullptr;
+    stopBuyTree = stopSellTree = highestStopSell = lowestStopBuy = nullptr;
+}
+
+// Get the height of a limit in a binary tree
+int Book::getLimitHeight(Limit* limit) const {
+    if (limit == nullptr) {
+        return 0; // Height of an empty tree is 0
+    }
+    return limit->height;
+}
+
+// Search the order map to find an order
+Order* Book::searchOrderMap(int orderId) const
+{
+    auto it = orderMap.find(orderId);
+    if (it != orderMap.end())
+    {
+        return it->second;
+    } else
+    {
+        std::cout << "No order number " << orderId << std::endl;
+        return nullptr;
+    }
+}
+
+// Search the limit maps to find a limit
+Limit* Book::searchLimitMaps(int limitPrice, bool buyOrSell) const
+{
+    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+
+    auto it = limitMap.find(limitPrice);
+    if (it != limitMap.end())
+    {
+        return it->second;
+    } else
+    {
+        std::cout << "No "<< (buyOrSell ? "buy " : "sell ") << "limit at " << limitPrice << std::endl;
+        return nullptr;
+    }
+}
+
+// Search the stop map to find a stop level
+Limit* Book::searchStopMap(int stopPrice) const
+{
+    auto it = stopMap.find(stopPrice);
+    if (it != stopMap.end())
+    {
+        return it->second;
+    } else
+    {
+        std::cout << "No stop level at " << stopPrice << std::endl;
+        return nullptr;
+    }
+}
+
+void Book::printLimit(int limitPrice, bool buyOrSell) const
+{
+    searchLimitMaps(limitPrice, buyOrSell)->print();
+}
+
+void Book::printOrder(int orderId) const
+{
+    searchOrderMap(orderId)->print();
+}
+
+void Book::printBookEdges() const
+{
+    std::cout << "Buy edge: " << highestBuy->getLimitPrice() 
+    << "Sell edge: " << lowestSell->getLimitPrice() << std::endl;
+}
+
+// Print out all the limit and stop levels and their liquidity
+void Book::printOrderBook() const
+{
+    std::vector<int> vec = inOrderTreeTraversal(getStopBuyTree());
+    std::cout << "[";
+    for (size_t i = 0; i < vec.size(); ++i) {
+        std::cout << vec[i] << "-" << searchStopMap(vec[i])->getTotalVolume();
+        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
+            throw std::runtime_error("Error: vector is error");
+        }
+        if (i != vec.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << "]" << std::endl;
+
+    vec = inOrderTreeTraversal(getStopSellTree());
+    std::cout << "[";
+    for (size_t i = 0; i < vec.size(); ++i) {
+        std::cout << vec[i] << "-" << searchStopMap(vec[i])->getTotalVolume();
+        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
+            throw std::runtime_error("Error: Vector is error");
+        }
+        if (i != vec.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << "]" << std::endl;
+
+    vec = inOrderTreeTraversal(getBuyTree());
+    std::cout << "[";
+    for (size_t i = 0; i < vec.size(); ++i) {
+        std::cout << vec[i] << "-" << searchLimitMaps(vec[i], true)->getTotalVolume();
+        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
+            throw std::runtime_error("Error: vector is error");
+        }
+        if (i != vec.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << "]" << std::endl;
+
+    vec = inOrderTreeTraversal(getSellTree());
+    std::cout << "[";
+    for (size_t i = 0; i < vec.size(); ++i) {
+        std::cout << vec[i] << "-" << searchLimitMaps(vec[i], false)->getTotalVolume();
+        if (i != 0 && i != vec.size()-1 && vec[i] < vec[i-1]) {
+            throw std::runtime_error("Error: Vector is error");
+        }
+        if (i != vec.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << "]" << std::endl;
+}
+
+// In order traversal of the binary search tree
+std::vector<int> Book::inOrderTreeTraversal(Limit* root) const
+{
+    std::vector<int> result;
+    if (root == nullptr)
+        return result;
+
+    std::vector<int> leftSubtree = inOrderTreeTraversal(root->getLeftChild());
+    result.insert(result.end(), leftSubtree.begin(), leftSubtree.end());
+    
+    result.push_back(root->getLimitPrice());
+
+    std::vector<int> rightSubtree = inOrderTreeTraversal(root->getRightChild());
+    result.insert(result.end(), rightSubtree.begin(), rightSubtree.end());
+
+    return result;
+}
+
+// Pre order traversal of the binary search tree
+std::vector<int> Book::preOrderTreeTraversal(Limit* root) const
+{
+    std::vector<int> result;
+    if (root == nullptr)
+        return result;
+
+    result.push_back(root->getLimitPrice());
 
     std::vector<int> leftSubtree = preOrderTreeTraversal(root->getLeftChild());
     result.insert(result.end(), leftSubtree.begin(), leftSubtree.end());
@@ -523,8 +1801,9 @@ void Book::addLimit(int limitPrice, bool buyOrSell)
     auto& tree = buyOrSell ? buyTree : sellTree;
     auto& bookEdge = buyOrSell ? highestBuy : lowestSell;
 
-    Limit* newLimit = new Limit(limitPrice, buyOrSell);
+    Limit* newLimit = limitPool.create(limitPrice, buyOrSell);
     limitMap.emplace(limitPrice, newLimit);
+    toggleLevelHash(newLimit, false);
 
     if (tree == nullptr)
     {
@@ -535,6 +1814,10 @@ void Book::addLimit(int limitPrice, bool buyOrSell)
         Limit* root = insert(tree, newLimit);
         updateBookEdgeInsert(newLimit);
     }
+    if (bookEdge == newLimit && !trailingEpochs[!buyOrSell].empty())
+    {
+        raiseTrailingWatermark(!buyOrSell);
+    }
 }
 
 // Add a new stop level to the book
@@ -543,8 +1826,9 @@ void Book::addStop(int stopPrice, bool buyOrSell)
     auto& tree = buyOrSell ? stopBuyTree : stopSellTree;
     auto& bookEdge = buyOrSell ? lowestStopBuy : highestStopSell;
 
-    Limit* newStop = new Limit(stopPrice, buyOrSell);
+    Limit* newStop = limitPool.create(stopPrice, buyOrSell);
     stopMap.emplace(stopPrice, newStop);
+    toggleLevelHash(newStop, true);
 
     if (tree == nullptr)
     {
@@ -738,22 +2022,38 @@ void Book::changeStopBookRoots(Limit* stopLevel){
     }
 }
 
+// Deepest level whose subtree changes when a level is unlinked. With two children the in order
+// successor moves into its place, so heights change from the successor's old parent upwards.
+static Limit* lowestChangedLevel(Limit* level)
+{
+    if (level->getLeftChild() == nullptr || level->getRightChild() == nullptr)
+    {
+        return level->getParent();
+    }
+    Limit* successor = level->getRightChild();
+    while (successor->getLeftChild() != nullptr)
+    {
+        successor = successor->getLeftChild();
+    }
+    return successor->getParent() == level ? successor : successor->getParent();
+}
+
 // Delete a limit after it has been emptied
 void Book::deleteLimit(Limit* limit)
 {
+    toggleLevelHash(limit, false);
     updateBookEdgeRemove(limit);
     deleteFromLimitMaps(limit->getLimitPrice(), limit->getBuyOrSell());
     changeBookRoots(limit);
 
-    Limit* parent = limit->getParent();
-    int limitPrice = limit->getLimitPrice();
-    delete limit;
+    Limit* parent = lowestChangedLevel(limit);
+    limitPool.destroy(limit);
     while (parent != nullptr)
     {
         parent = balance(parent);
         if (parent->getParent() != nullptr)
         {
-            if (parent->getParent()->getLimitPrice() > limitPrice)
+            if (parent->getParent()->getLimitPrice() > parent->getLimitPrice())
             {
                 parent->getParent()->setLeftChild(parent);
             } else {
@@ -767,19 +2067,19 @@ void Book::deleteLimit(Limit* limit)
 // Delete a stop level after it has been emptied
 void Book::deleteStopLevel(Limit* stopLevel)
 {
+    toggleLevelHash(stopLevel, true);
     updateStopBookEdgeRemove(stopLevel);
     deleteFromStopMap(stopLevel->getLimitPrice());
     changeStopBookRoots(stopLevel);
 
-    Limit* parent = stopLevel->getParent();
-    int stopPrice = stopLevel->getLimitPrice();
-    delete stopLevel;
+    Limit* parent = lowestChangedLevel(stopLevel);
+    limitPool.destroy(stopLevel);
     while (parent != nullptr)
     {
         parent = balanceStop(parent);
         if (parent->getParent() != nullptr)
         {
-            if (parent->getParent()->getLimitPrice() > stopPrice)
+            if (parent->getParent()->getLimitPrice() > parent->getLimitPrice())
             {
                 parent->getParent()->setLeftChild(parent);
             } else {
@@ -793,7 +2093,138 @@ void Book::deleteStopLevel(Limit* stopLevel)
 // Delete an order from the order map
 void Book::deleteFromOrderMap(int orderId)
 {
-    orderMap.erase(orderId);
+    auto indexed = orderMap.find(orderId);
+    if (indexed == orderMap.end())
+    {
+        return;
+    }
+    if (indexed->second->getOwnerId() != 0)
+    {
+        unlinkOwnerOrder(indexed->second);
+    }
+    orderMap.erase(indexed);
+}
+
+// New orders go to the front of their owner's list
+void Book::linkOwnerOrder(Order* order)
+{
+    auto [head, inserted] = ownerOrders.try_emplace(order->ownerId, order);
+    if (!inserted)
+    {
+        order->nextOwnerOrder = head->second;
+        head->second->prevOwnerOrder = order;
+        head->second = order;
+    }
+}
+
+// Only removing the newest order of an owner touches the owner index
+void Book::unlinkOwnerOrder(Order* order)
+{
+    if (order->prevOwnerOrder != nullptr)
+    {
+        order->prevOwnerOrder->nextOwnerOrder = order->nextOwnerOrder;
+    } else if (order->nextOwnerOrder != nullptr)
+    {
+        ownerOrders.find(order->ownerId)->second = order->nextOwnerOrder;
+    } else {
+        ownerOrders.erase(order->ownerId);
+    }
+    if (order->nextOwnerOrder != nullptr)
+    {
+        order->nextOwnerOrder->prevOwnerOrder = order->prevOwnerOrder;
+    }
+    order->nextOwnerOrder = order->prevOwnerOrder = nullptr;
+}
+
+// Cancel every order on the levels of a subtree priced from lowPrice to highPrice, skipping the
+// subtrees that are out of range. Whole levels go, so their queues are not unlinked order by order.
+int Book::cancelLevelsInRange(Limit* root, int lowPrice, int highPrice, std::vector<Limit*>& emptied)
+{
+    if (root == nullptr)
+    {
+        return 0;
+    }
+    int cancelled = 0;
+    if (root->getLimitPrice() > lowPrice)
+    {
+        cancelled += cancelLevelsInRange(root->getLeftChild(), lowPrice, highPrice, emptied);
+    }
+    if (root->getLimitPrice() >= lowPrice && root->getLimitPrice() <= highPrice)
+    {
+        Order* order = root->getHeadOrder();
+        while (order != nullptr)
+        {
+            Order* nextOrder = order->getNextOrder();
+            toggleOrderHash(order);
+            if (order->getOwnerId() != 0)
+            {
+                unlinkOwnerOrder(order);
+            }
+            orderMap.erase(order->getOrderId());
+            orderPool.destroy(order);
+            cancelled += 1;
+            order = nextOrder;
+        }
+        emptied.push_back(root);
+    }
+    if (root->getLimitPrice() < highPrice)
+    {
+        cancelled += cancelLevelsInRange(root->getRightChild(), lowPrice, highPrice, emptied);
+    }
+    return cancelled;
+}
+
+// Take the levels emptied by a mass cancel out of their tree. While the k emptied levels are few
+// next to the n levels in the tree, each goes through the usual O(log n) delete. Past that, the
+// tree is rebuilt balanced from the levels left in O(n) rather than k deletes and rebalances.
+void Book::removeEmptiedLevels(std::vector<Limit*>& emptied, bool buyOrSell)
+{
+    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+    if (emptied.size() * std::bit_width(limitMap.size()) < limitMap.size())
+    {
+        for (Limit* level : emptied)
+        {
+            deleteLimit(level);
+        }
+        return;
+    }
+    std::sort(emptied.begin(), emptied.end(), [](const Limit* a, const Limit* b) { return a->getLimitPrice() < b->getLimitPrice(); });
+    Limit*& tree = buyOrSell ? buyTree : sellTree;
+    std::vector<Limit*> levels;
+    levels.reserve(limitMap.size() - emptied.size());
+    std::size_t nextRemoved = 0;
+    collectRemainingLevels(tree, emptied, nextRemoved, levels);
+
+    for (Limit* level : emptied)
+    {
+        toggleLevelHash(level, false);
+        limitMap.erase(level->getLimitPrice());
+        limitPool.destroy(level);
+    }
+    tree = buildTree(levels, 0, static_cast<int>(levels.size()) - 1, nullptr);
+    if (buyOrSell)
+    {
+        highestBuy = levels.empty() ? nullptr : levels.back();
+    } else {
+        lowestSell = levels.empty() ? nullptr : levels.front();
+    }
+}
+
+// In order walk of a tree, leaving out the levels in removed, which is sorted by price
+void Book::collectRemainingLevels(Limit* root, const std::vector<Limit*>& removed, std::size_t& nextRemoved, std::vector<Limit*>& levels) const
+{
+    if (root == nullptr)
+    {
+        return;
+    }
+    collectRemainingLevels(root->getLeftChild(), removed, nextRemoved, levels);
+    if (nextRemoved < removed.size() && removed[nextRemoved] == root)
+    {
+        nextRemoved += 1;
+    } else {
+        levels.push_back(root);
+    }
+    collectRemainingLevels(root->getRightChild(), removed, nextRemoved, levels);
 }
 
 // Delete a limit from the limit maps
@@ -811,8 +2242,21 @@ void Book::deleteFromStopMap(int stopPrice)
 
 // When a limit order overlaps with the highest buy or lowest sell, immediately
 // execute it as if it were a market order
-int Book::limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int limitPrice)
+int Book::limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int ownerId)
 {
+    // During an auction every order rests, crossed or not
+    if (auctionMode)
+    {
+        return shares;
+    }
+    if (ownerId != 0 && selfTradePrevention != SelfTradePrevention::None)
+    {
+        return matchOwnedOrder(buyOrSell, shares, limitPrice, ownerId);
+    }
+    if (pegCounts[!buyOrSell] != 0)
+    {
+        return matchPeggedOrders(buyOrSell, shares, limitPrice);
+    }
     if (buyOrSell)
     {
         while (lowestSell != nullptr && shares != 0 && lowestSell->getLimitPrice() <= limitPrice)
@@ -847,6 +2291,10 @@ int Book::limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int l
 // execute it as if it were a market order
 int Book::stopOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int stopPrice)
 {
+    if (auctionMode)
+    {
+        return shares;
+    }
     if (buyOrSell && lowestSell != nullptr && stopPrice <= lowestSell->getLimitPrice())
     {
         marketOrder(orderId, true, shares);
@@ -866,7 +2314,17 @@ int Book::existingOrderAsMarketOrder(Order* headOrder, bool buyOrSell)
     int shares = headOrder->getShares();
     int orderId = headOrder->getOrderId();
     int limitPrice = headOrder->getLimit();
-    
+
+    if (pegCounts[!buyOrSell] != 0)
+    {
+        shares = matchPeggedOrders(buyOrSell, shares, limitPrice);
+        if (shares == 0)
+        {
+            deleteFromOrderMap(orderId);
+            orderPool.destroy(headOrder);
+        }
+        return shares;
+    }
     if (buyOrSell)
     {
         while (lowestSell != nullptr && lowestSell->getLimitPrice() <= limitPrice)
@@ -874,7 +2332,7 @@ int Book::existingOrderAsMarketOrder(Order* headOrder, bool buyOrSell)
             if (shares <= lowestSell->getTotalVolume())
             {
                 deleteFromOrderMap(orderId);
-                delete headOrder;
+                orderPool.destroy(headOrder);
                 marketOrderHelper(orderId, buyOrSell, shares);
                 return 0;
             } else {
@@ -889,7 +2347,7 @@ int Book::existingOrderAsMarketOrder(Order* headOrder, bool buyOrSell)
             if (shares <= highestBuy->getTotalVolume())
             {
                 deleteFromOrderMap(orderId);
-                delete headOrder;
+                orderPool.destroy(headOrder);
                 marketOrderHelper(orderId, buyOrSell, shares);
                 return 0;
             } else {
@@ -905,6 +2363,10 @@ int Book::existingOrderAsMarketOrder(Order* headOrder, bool buyOrSell)
 // execute it as if it were a limit order
 int Book::stopLimitOrderAsLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice)
 {
+    if (auctionMode)
+    {
+        return shares;
+    }
     if (buyOrSell && lowestSell != nullptr && stopPrice <= lowestSell->getLimitPrice())
     {
         addLimitOrder(orderId, true, shares, limitPrice);
@@ -917,8 +2379,23 @@ int Book::stopLimitOrderAsLimitOrder(int orderId, bool buyOrSell, int shares, in
     return shares;
 }
 
-// Executes any stop orders which need to be executed
+// Executes any stop orders which need to be executed. A triggered trailing stop trades as a
+// market order, which can trigger more stops of either kind.
 void Book::executeStopOrders(bool buyOrSell)
+{
+    // Stops triggered by a crossed auction book wait for the uncross
+    if (auctionMode)
+    {
+        return;
+    }
+    executeFixedStopOrders(buyOrSell);
+    while (trailingCounts[buyOrSell] != 0 && executeTrailingStops(buyOrSell))
+    {
+        executeFixedStopOrders(buyOrSell);
+    }
+}
+
+void Book::executeFixedStopOrders(bool buyOrSell)
 {
     if (buyOrSell)
     {
@@ -930,6 +2407,7 @@ void Book::executeStopOrders(bool buyOrSell)
             if (headOrder->getLimit() == 0)
             {
                 int shares = headOrder->getShares();
+                toggleOrderHash(headOrder);
                 headOrder->execute();
                 if (lowestStopBuy->getSize() == 0)
                 {
@@ -937,7 +2415,7 @@ void Book::executeStopOrders(bool buyOrSell)
                 }
                 deleteFromOrderMap(headOrder->getOrderId());
                 // stopOrders.erase(headOrder);
-                delete headOrder;
+                orderPool.destroy(headOrder);
                 marketOrderHelper(0, true, shares);
             } else {
                 // stopLimitOrders.erase(headOrder);
@@ -953,6 +2431,7 @@ void Book::executeStopOrders(bool buyOrSell)
             if (headOrder->getLimit() == 0)
             {
                 int shares = headOrder->getShares();
+                toggleOrderHash(headOrder);
                 headOrder->execute();
                 if (highestStopSell->getSize() == 0)
                 {
@@ -960,7 +2439,7 @@ void Book::executeStopOrders(bool buyOrSell)
                 }
                 deleteFromOrderMap(headOrder->getOrderId());
                 // stopOrders.erase(headOrder);
-                delete headOrder;
+                orderPool.destroy(headOrder);
                 marketOrderHelper(0, false, shares);
             } else {
                 // stopLimitOrders.erase(headOrder);
@@ -970,10 +2449,146 @@ void Book::executeStopOrders(bool buyOrSell)
     }
 }
 
+// Take every trailing stop at or past its trigger price off the book, highest trigger first,
+// then send them in as market orders. Returns whether any triggered.
+bool Book::executeTrailingStops(bool buyOrSell)
+{
+    int reference = trailingReference(buyOrSell);
+    auto& epochs = trailingEpochs[buyOrSell];
+    auto& triggers = trailingTriggers[buyOrSell];
+    triggeredTrailingStops.clear();
+    while (!triggers.empty() && triggers.rbegin()->first >= reference)
+    {
+        int epochIndex = triggers.rbegin()->second;
+        TrailingEpoch& epoch = epochs[epochIndex];
+        auto group = epoch.groups.begin();
+        Limit* level = group->second;
+        while (level->getHeadOrder() != nullptr)
+        {
+            Order* headOrder = level->getHeadOrder();
+            toggleOrderHash(headOrder);
+            headOrder->execute();
+            trailingOrderMap.erase(headOrder->getOrderId());
+            triggeredTrailingStops.push_back(headOrder);
+        }
+        epoch.groups.erase(group);
+        limitPool.destroy(level);
+        updateTrailingTrigger(buyOrSell, epochIndex);
+    }
+    while (!epochs.empty() && epochs.back().groups.empty())
+    {
+        toggleTrailingEpochHash(buyOrSell, epochs.back().highWaterMark);
+        epochs.pop_back();
+    }
+
+    trailingCounts[buyOrSell] -= static_cast<int>(triggeredTrailingStops.size());
+    for (Order* order : triggeredTrailingStops)
+    {
+        int shares = order->getShares();
+        orderPool.destroy(order);
+        marketOrderHelper(0, buyOrSell, shares);
+    }
+    return !triggeredTrailingStops.empty();
+}
+
+// Price trailing stops on a side follow, negated for buy stops so both sides trail a high water
+// mark. INT_MIN while the other side of the book is empty.
+int Book::trailingReference(bool buyOrSell) const
+{
+    if (buyOrSell)
+    {
+        return lowestSell != nullptr ? -lowestSell->getLimitPrice() : INT_MIN;
+    }
+    return highestBuy != nullptr ? highestBuy->getLimitPrice() : INT_MIN;
+}
+
+// A new high reference price lifts the high water mark of every epoch below it, so those
+// epochs merge into the oldest of them, which keeps its place in the stack
+void Book::raiseTrailingWatermark(bool buyOrSell)
+{
+    auto& epochs = trailingEpochs[buyOrSell];
+    int reference = trailingReference(buyOrSell);
+    if (epochs.empty() || epochs.back().highWaterMark >= reference)
+    {
+        return;
+    }
+    std::size_t survivor = epochs.size() - 1;
+    while (survivor > 0 && epochs[survivor - 1].highWaterMark < reference)
+    {
+        survivor -= 1;
+    }
+    for (std::size_t i = survivor + 1; i < epochs.size(); i++)
+    {
+        if (epochs[i].indexed)
+        {
+            trailingTriggers[buyOrSell].erase({epochs[i].triggerPrice, static_cast<int>(i)});
+        }
+        toggleTrailingEpochHash(buyOrSell, epochs[i].highWaterMark);
+        mergeTrailingEpoch(epochs[survivor], epochs[i]);
+    }
+    while (epochs.size() > survivor + 1)
+    {
+        epochs.pop_back();
+    }
+    toggleTrailingEpochHash(buyOrSell, epochs[survivor].highWaterMark);
+    epochs[survivor].highWaterMark = reference;
+    toggleTrailingEpochHash(buyOrSell, reference);
+    updateTrailingTrigger(buyOrSell, static_cast<int>(survivor));
+}
+
+// Move the smaller epoch's groups into the larger one without touching their orders. Among
+// equal offsets the older epoch's groups stay first. Groups emptied by cancels are dropped.
+void Book::mergeTrailingEpoch(TrailingEpoch& older, TrailingEpoch& newer)
+{
+    if (newer.groups.size() > older.groups.size())
+    {
+        std::swap(older.groups, newer.groups);
+        while (!newer.groups.empty())
+        {
+            auto node = newer.groups.extract(std::prev(newer.groups.end()));
+            if (node.mapped()->getSize() == 0)
+            {
+                limitPool.destroy(node.mapped());
+                continue;
+            }
+            older.groups.insert(older.groups.lower_bound(node.key()), std::move(node));
+        }
+    } else {
+        while (!newer.groups.empty())
+        {
+            auto node = newer.groups.extract(newer.groups.begin());
+            if (node.mapped()->getSize() == 0)
+            {
+                limitPool.destroy(node.mapped());
+                continue;
+            }
+            older.groups.insert(older.groups.upper_bound(node.key()), std::move(node));
+        }
+    }
+}
+
+// Re-index an epoch under the trigger price of its smallest offset
+void Book::updateTrailingTrigger(bool buyOrSell, int epochIndex)
+{
+    TrailingEpoch& epoch = trailingEpochs[buyOrSell][epochIndex];
+    auto& triggers = trailingTriggers[buyOrSell];
+    if (epoch.indexed)
+    {
+        triggers.erase({epoch.triggerPrice, epochIndex});
+    }
+    epoch.indexed = !epoch.groups.empty();
+    if (epoch.indexed)
+    {
+        epoch.triggerPrice = epoch.highWaterMark - epoch.groups.begin()->first;
+        triggers.emplace(epoch.triggerPrice, epochIndex);
+    }
+}
+
 // Turn stop limit order into limit order
 void Book::stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell)
 {
     auto& bookEdge = buyOrSell ? lowestStopBuy : highestStopSell;
+    toggleOrderHash(headOrder);
     headOrder->execute();
     if (bookEdge->getSize() == 0)
     {
@@ -993,6 +2608,7 @@ void Book::stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell)
             addLimit(headOrder->getLimit(), buyOrSell);
         }
         limitMap.at(headOrder->getLimit())->append(headOrder);
+        toggleOrderHash(headOrder);
         // limitOrders.insert(headOrder);
     }
 }
@@ -1000,28 +2616,475 @@ void Book::stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell)
 // Function which actually executes the market order.
 // If the book is empty and can't complete market order then market order just doesn't execute and is forgotten
 void Book::marketOrderHelper(int orderId, bool buyOrSell, int shares)
+{
+    if (pegCounts[!buyOrSell] != 0)
+    {
+        matchPeggedOrders(buyOrSell, shares, buyOrSell ? INT_MAX : INT_MIN);
+        return;
+    }
+    fillBookEdge<false>(buyOrSell, shares);
+}
+
+// Fill shares from the front of the book edge, moving on to the next level as each one empties.
+// With self-trade prevention each resting order's owner is compared with ownerId first, and
+// filling stops where the level does, because prevented trades can leave shares over. The shares
+// not filled are left in shares. Returns false once the incoming order has been cancelled.
+template <bool preventSelfTrade>
+bool Book::fillBookEdge(bool buyOrSell, int& shares, int ownerId)
 {
     auto& bookEdge = buyOrSell ? lowestSell : highestBuy;
 
-    while (bookEdge != nullptr && bookEdge->getHeadOrder()->getShares() <= shares)
+    while (bookEdge != nullptr && shares != 0)
     {
         Order* headOrder = bookEdge->getHeadOrder();
+        if constexpr (preventSelfTrade)
+        {
+            if (headOrder->getOwnerId() == ownerId)
+            {
+                Limit* level = bookEdge;
+                if (!applySelfTradePrevention(headOrder, shares))
+                {
+                    return false;
+                }
+                if (bookEdge != level)
+                {
+                    return true;
+                }
+                continue;
+            }
+        }
+        if (headOrder->getShares() > shares)
+        {
+            break;
+        }
         shares -= headOrder->getShares();
+        toggleOrderHash(headOrder);
+        executedOrdersCount += 1;
+        if (headOrder->getHiddenShares() != 0)
+        {
+            // Iceberg slice filled, show the next one at the back of the level
+            headOrder->replenish();
+            toggleOrderHash(headOrder);
+            continue;
+        }
         headOrder->execute();
-        if (bookEdge->getSize() == 0)
+        bool levelEmptied = bookEdge->getSize() == 0;
+        if (levelEmptied)
         {
             deleteLimit(bookEdge);
         }
         deleteFromOrderMap(headOrder->getOrderId());
         // limitOrders.erase(headOrder);
-        delete headOrder;
-        executedOrdersCount += 1;
+        orderPool.destroy(headOrder);
+        if (preventSelfTrade && levelEmptied)
+        {
+            return true;
+        }
     }
     if (bookEdge != nullptr && shares != 0)
     {
-        bookEdge->getHeadOrder()->partiallyFillOrder(shares);
+        Order* headOrder = bookEdge->getHeadOrder();
+        toggleOrderHash(headOrder);
+        headOrder->partiallyFillOrder(shares);
+        toggleOrderHash(headOrder);
+        executedOrdersCount += 1;
+        shares = 0;
+    }
+    return true;
+}
+
+// Match an incoming order whose owner is checked against each resting order, up to limitPrice,
+// a level at a time since preventing a self-trade changes how much of a level the order takes.
+// Returns the shares left to rest, 0 once the incoming order has been cancelled.
+int Book::matchOwnedOrder(bool buyOrSell, int shares, int limitPrice, int ownerId)
+{
+    if (pegCounts[!buyOrSell] != 0)
+    {
+        return matchPeggedOrders(buyOrSell, shares, limitPrice, ownerId);
+    }
+    auto& bookEdge = buyOrSell ? lowestSell : highestBuy;
+    while (shares != 0 && bookEdge != nullptr && (buyOrSell ? bookEdge->getLimitPrice() <= limitPrice : bookEdge->getLimitPrice() >= limitPrice))
+    {
+        int fillShares = std::min(shares, bookEdge->getTotalVolume());
+        shares -= fillShares;
+        if (!fillBookEdge<true>(buyOrSell, fillShares, ownerId))
+        {
+            return 0;
+        }
+        shares += fillShares;
+    }
+    return shares;
+}
+
+// Apply the self-trade prevention mode to a resting order at the front of the book edge that
+// has the incoming order's owner. Decrement takes shares off the resting order like a fill,
+// without counting a trade. Returns false if the incoming order is cancelled.
+bool Book::applySelfTradePrevention(Order* restingOrder, int& shares)
+{
+    preventedSelfTrades += 1;
+    if (selfTradePrevention == SelfTradePrevention::CancelNewest)
+    {
+        return false;
+    }
+    Limit* level = restingOrder->getParentLimit();
+    toggleOrderHash(restingOrder);
+    if (selfTradePrevention == SelfTradePrevention::Decrement)
+    {
+        if (restingOrder->getShares() > shares)
+        {
+            restingOrder->partiallyFillOrder(shares);
+            toggleOrderHash(restingOrder);
+            shares = 0;
+            return true;
+        }
+        shares -= restingOrder->getShares();
+        if (restingOrder->getHiddenShares() != 0)
+        {
+            restingOrder->replenish();
+            toggleOrderHash(restingOrder);
+            return true;
+        }
+    }
+    restingOrder->cancel();
+    if (level->getSize() == 0)
+    {
+        deleteLimit(level);
+    }
+    deleteFromOrderMap(restingOrder->getOrderId());
+    orderPool.destroy(restingOrder);
+    return selfTradePrevention != SelfTradePrevention::CancelBoth;
+}
+
+// Match against limit levels and pegged groups together, best price first, with limit levels
+// ahead of pegged orders at the same price. Pegs are priced from the book edges as they were
+// when the incoming order arrived, so a peg keeps its price while the level it follows is
+// taken, and the best group only needs finding again once a group is used up. Returns the
+// shares left unfilled.
+int Book::matchPeggedOrders(bool buyOrSell, int shares, int limitPrice, int ownerId)
+{
+    auto& bookEdge = buyOrSell ? lowestSell : highestBuy;
+    int bestBuy = highestBuy != nullptr ? highestBuy->getLimitPrice() : INT_MIN;
+    int bestSell = lowestSell != nullptr ? lowestSell->getLimitPrice() : INT_MAX;
+    PegType pegType;
+    int groupPrice;
+    Limit* group = bestPegGroup(!buyOrSell, bestBuy, bestSell, pegType, groupPrice);
+    while (shares != 0)
+    {
+        if (bookEdge != nullptr && (group == nullptr || (buyOrSell ? bookEdge->getLimitPrice() <= groupPrice : bookEdge->getLimitPrice() >= groupPrice)))
+        {
+            if (buyOrSell ? bookEdge->getLimitPrice() > limitPrice : bookEdge->getLimitPrice() < limitPrice)
+            {
+                break;
+            }
+            int fillShares = std::min(shares, bookEdge->getTotalVolume());
+            shares -= fillShares;
+            if (ownerId == 0)
+            {
+                fillBookEdge<false>(buyOrSell, fillShares);
+            } else if (!fillBookEdge<true>(buyOrSell, fillShares, ownerId))
+            {
+                return 0;
+            }
+            shares += fillShares;
+        } else if (group != nullptr && (buyOrSell ? groupPrice <= limitPrice : groupPrice >= limitPrice))
+        {
+            int fillShares = std::min(shares, group->getTotalVolume());
+            shares -= fillShares;
+            fillPegGroup(group, pegType, fillShares);
+            group = bestPegGroup(!buyOrSell, bestBuy, bestSell, pegType, groupPrice);
+        } else {
+            break;
+        }
+    }
+    return shares;
+}
+
+// Price of a pegged order given the best buy and sell prices, INT_MIN and INT_MAX when a side
+// is empty. False while the prices it follows are missing.
+bool Book::pegPrice(bool buyOrSell, PegType pegType, int offset, int bestBuy, int bestSell, int& price)
+{
+    bool hasBuy = bestBuy != INT_MIN;
+    bool hasSell = bestSell != INT_MAX;
+    if (pegType == PegType::Primary)
+    {
+        if (!(buyOrSell ? hasBuy : hasSell))
+        {
+            return false;
+        }
+        price = (buyOrSell ? bestBuy : bestSell) + offset;
+    } else if (pegType == PegType::Market)
+    {
+        if (!(buyOrSell ? hasSell : hasBuy))
+        {
+            return false;
+        }
+        price = (buyOrSell ? bestSell : bestBuy) + offset;
+    } else {
+        if (!hasBuy || !hasSell)
+        {
+            return false;
+        }
+        // Round towards the pegged order's own side
+        int sum = bestBuy + bestSell;
+        price = (buyOrSell ? sum - (sum & 1) : sum + (sum & 1)) / 2 + offset;
+    }
+    if (buyOrSell && hasSell)
+    {
+        price = std::min(price, bestSell - 1);
+    } else if (!buyOrSell && hasBuy)
+    {
+        price = std::max(price, bestBuy + 1);
+    }
+    return true;
+}
+
+// Best priced group on a side across the peg types. Within one peg type the price only
+// moves with the offset, so each type's best group is the first or last in its map.
+Limit* Book::bestPegGroup(bool buyOrSell, int bestBuy, int bestSell, PegType& pegType, int& price) const
+{
+    Limit* best = nullptr;
+    for (int type = 0; type < 3; type++)
+    {
+        const auto& groups = pegGroups[buyOrSell][type];
+        if (groups.empty())
+        {
+            continue;
+        }
+        Limit* group = buyOrSell ? groups.rbegin()->second : groups.begin()->second;
+        int groupPrice;
+        if (pegPrice(buyOrSell, static_cast<PegType>(type), group->getLimitPrice(), bestBuy, bestSell, groupPrice)
+            && (best == nullptr || (buyOrSell ? groupPrice > price : groupPrice < price)))
+        {
+            best = group;
+            pegType = static_cast<PegType>(type);
+            price = groupPrice;
+        }
+    }
+    return best;
+}
+
+// Fill shares, at most the group's volume, from the front of a pegged group
+void Book::fillPegGroup(Limit* group, PegType pegType, int shares)
+{
+    bool buyOrSell = group->getBuyOrSell();
+    while (shares != 0)
+    {
+        Order* headOrder = group->getHeadOrder();
+        toggleOrderHash(headOrder);
+        executedOrdersCount += 1;
+        if (headOrder->getShares() > shares)
+        {
+            headOrder->partiallyFillOrder(shares);
+            toggleOrderHash(headOrder);
+            return;
+        }
+        shares -= headOrder->getShares();
+        headOrder->execute();
+        pegOrderMap.erase(headOrder->getOrderId());
+        orderPool.destroy(headOrder);
+        pegCounts[buyOrSell] -= 1;
+    }
+    if (group->getSize() == 0)
+    {
+        togglePegGroupHash(group, pegType);
+        pegGroups[buyOrSell][static_cast<int>(pegType)].erase(group->getLimitPrice());
+        limitPool.destroy(group);
+    }
+}
+
+// Pegged orders do not record their peg type, so look for their group in the primary and
+// midpoint maps, and anything else is market pegged
+PegType Book::findPegType(const Order* order) const
+{
+    for (int type = 0; type < 2; type++)
+    {
+        const auto& groups = pegGroups[order->getBuyOrSell()][type];
+        auto group = groups.find(order->getLimit());
+        if (group != groups.end() && group->second == order->getParentLimit())
+        {
+            return static_cast<PegType>(type);
+        }
+    }
+    return PegType::Market;
+}
+
+// Whether the opposite side holds at least shares at prices up to limitPrice, walking levels
+// outwards from the book edge and stopping as soon as enough volume is found. Iceberg
+// reserves count, since matching replenishes them. Pegged groups count too, priced from the
+// book edges as matchPeggedOrders prices them.
+bool Book::hasVolume(bool buyOrSell, int shares, int limitPrice) const
+{
+    Limit* level = buyOrSell ? lowestSell : highestBuy;
+    while (level != nullptr && (buyOrSell ? level->getLimitPrice() <= limitPrice : level->getLimitPrice() >= limitPrice))
+    {
+        shares -= level->getTotalVolume() + level->getHiddenVolume();
+        if (shares <= 0)
+        {
+            return true;
+        }
+        level = nextLevel(level, buyOrSell);
+    }
+    if (pegCounts[!buyOrSell] == 0)
+    {
+        return false;
+    }
+
+    // Within one peg type the price only moves with the offset, so each type's groups are walked
+    // from the best end until one is priced past the limit
+    int bestBuy = highestBuy != nullptr ? highestBuy->getLimitPrice() : INT_MIN;
+    int bestSell = lowestSell != nullptr ? lowestSell->getLimitPrice() : INT_MAX;
+    for (int type = 0; type < 3; type++)
+    {
+        auto countGroup = [&](const Limit* group) {
+            int price;
+            if (!pegPrice(!buyOrSell, static_cast<PegType>(type), group->getLimitPrice(), bestBuy, bestSell, price)
+                || (buyOrSell ? price > limitPrice : price < limitPrice))
+            {
+                return false;
+            }
+            shares -= group->getTotalVolume();
+            return true;
+        };
+        const auto& groups = pegGroups[!buyOrSell][type];
+        if (buyOrSell)
+        {
+            for (auto group = groups.begin(); group != groups.end() && countGroup(group->second); ++group) {}
+        } else {
+            for (auto group = groups.rbegin(); group != groups.rend() && countGroup(group->second); ++group) {}
+        }
+        if (shares <= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Radix sort on the two halves of each id, with the sign bit flipped so negative ids come first
+static void sortOrderIds(std::vector<int>& orderIds)
+{
+    std::vector<int> sorted(orderIds.size());
+    std::vector<std::uint32_t> counts(65537);
+    for (int shift : {0, 16})
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (int orderId : orderIds)
+        {
+            counts[((std::uint32_t(orderId) ^ 0x80000000u) >> shift & 0xffff) + 1] += 1;
+        }
+        for (std::size_t i = 1; i < counts.size(); i++)
+        {
+            counts[i] += counts[i - 1];
+        }
+        for (int orderId : orderIds)
+        {
+            sorted[counts[(std::uint32_t(orderId) ^ 0x80000000u) >> shift & 0xffff]++] = orderId;
+        }
+        orderIds.swap(sorted);
+    }
+}
+
+// Fill shares of one side in price then time priority, from the book edge. Levels the fill
+// drains are cleared without unlinking their orders one at a time, and their queues are walked
+// side by side so the cache misses of each overlap with the others. Filled orders then leave the
+// order index in id order, which visits its buckets in sequence, and the drained levels leave
+// the tree together.
+void Book::fillAuctionSide(bool buyOrSell, int shares)
+{
+    std::vector<Limit*> drained;
+    Limit* level = buyOrSell ? highestBuy : lowestSell;
+    while (level != nullptr && shares >= level->getTotalVolume() + level->getHiddenVolume())
+    {
+        shares -= level->getTotalVolume() + level->getHiddenVolume();
+        drained.push_back(level);
+        level = nextLevel(level, !buyOrSell);
+    }
+
+    std::vector<int> filledIds;
+    std::vector<Order*> queues;
+    for (Limit* drainedLevel : drained)
+    {
+        queues.push_back(drainedLevel->getHeadOrder());
+    }
+    while (!queues.empty())
+    {
+        for (std::size_t i = 0; i < queues.size();)
+        {
+            Order* order = queues[i];
+            queues[i] = order->getNextOrder();
+            toggleOrderHash(order);
+            executedOrdersCount += 1;
+            if (order->getOwnerId() != 0)
+            {
+                unlinkOwnerOrder(order);
+            }
+            filledIds.push_back(order->getOrderId());
+            orderPool.destroy(order);
+            if (queues[i] == nullptr)
+            {
+                queues[i] = queues.back();
+                queues.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // The rest fills part of the next level, where icebergs may show new slices
+    while (shares != 0)
+    {
+        Order* headOrder = level->getHeadOrder();
+        toggleOrderHash(headOrder);
         executedOrdersCount += 1;
+        if (headOrder->getShares() > shares)
+        {
+            headOrder->partiallyFillOrder(shares);
+            toggleOrderHash(headOrder);
+            break;
+        }
+        shares -= headOrder->getShares();
+        if (headOrder->getHiddenShares() != 0)
+        {
+            headOrder->replenish();
+            toggleOrderHash(headOrder);
+            continue;
+        }
+        headOrder->execute();
+        if (headOrder->getOwnerId() != 0)
+        {
+            unlinkOwnerOrder(headOrder);
+        }
+        filledIds.push_back(headOrder->getOrderId());
+        orderPool.destroy(headOrder);
+    }
+
+    sortOrderIds(filledIds);
+    for (int orderId : filledIds)
+    {
+        orderMap.erase(orderId);
+    }
+    removeEmptiedLevels(drained, buyOrSell);
+}
+
+// In order successor of a level when ascending, predecessor otherwise, using parent links
+Limit* Book::nextLevel(Limit* level, bool ascending)
+{
+    Limit* child = ascending ? level->getRightChild() : level->getLeftChild();
+    if (child != nullptr)
+    {
+        while ((ascending ? child->getLeftChild() : child->getRightChild()) != nullptr)
+        {
+            child = ascending ? child->getLeftChild() : child->getRightChild();
+        }
+        return child;
+    }
+    Limit* parent = level->getParent();
+    while (parent != nullptr && level == (ascending ? parent->getRightChild() : parent->getLeftChild()))
+    {
+        level = parent;
+        parent = parent->getParent();
     }
+    return parent;
 }
 
 // Get height difference between a limits children
@@ -1032,6 +3095,11 @@ int Book::limitHeightDifference(Limit* limit) {
     return b_factor;
 }
 
+// Recompute a level's height from its children's cached heights
+void Book::updateLimitHeight(Limit* limit) {
+    limit->height = static_cast<std::uint8_t>(std::max(getLimitHeight(limit->getLeftChild()), getLimitHeight(limit->getRightChild())) + 1);
+}
+
 // RR rotation for AVL restructure
 Limit* Book::rr_rotate(Limit* parent) {
     Limit* newParent = parent->getRightChild();
@@ -1050,6 +3118,8 @@ Limit* Book::rr_rotate(Limit* parent) {
         tree = newParent;
     }
     parent->setParent(newParent);
+    updateLimitHeight(parent);
+    updateLimitHeight(newParent);
     return newParent;
 }
 
@@ -1071,6 +3141,8 @@ Limit* Book::ll_rotate(Limit* parent) {
         tree = newParent;
     }
     parent->setParent(newParent);
+    updateLimitHeight(parent);
+    updateLimitHeight(newParent);
     return newParent;
 }
 
@@ -1090,6 +3162,7 @@ Limit* Book::rl_rotate(Limit* parent) {
 
 // Check if the AVL tree needs to be restructured
 Limit* Book::balance(Limit* limit) {
+    updateLimitHeight(limit);
     int bal_factor = limitHeightDifference(limit);
     if (bal_factor > 1) {
         if (limitHeightDifference(limit->getLeftChild()) >= 0)
@@ -1125,6 +3198,8 @@ Limit* Book::rr_rotateStop(Limit* parent) {
         tree = newParent;
     }
     parent->setParent(newParent);
+    updateLimitHeight(parent);
+    updateLimitHeight(newParent);
     return newParent;
 }
 
@@ -1146,6 +3221,8 @@ Limit* Book::ll_rotateStop(Limit* parent) {
         tree = newParent;
     }
     parent->setParent(newParent);
+    updateLimitHeight(parent);
+    updateLimitHeight(newParent);
     return newParent;
 }
 
@@ -1165,6 +3242,7 @@ Limit* Book::rl_rotateStop(Limit* parent) {
 
 // Check if the AVL stop tree needs to be restructured
 Limit* Book::balanceStop(Limit* limit) {
+    updateLimitHeight(limit);
     int bal_factor = limitHeightDifference(limit);
     if (bal_factor > 1) {
         if (limitHeightDifference(limit->getLeftChild()) >= 0)
@@ -1,13 +1,37 @@
 #ifndef BOOK_HPP
 #define BOOK_HPP
 
+#include <climits>
+#include <cstdint>
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include <random>
 #include <unordered_set>
+#include "Arena.hpp"
+#include "ObjectPool.hpp"
+#include "TimingWheel.hpp"
+#include "Limit.hpp"
+#include "Order.hpp"
 
-class Limit;
-class Order;
+// What a pegged order's price follows: the best price on its own side, the midpoint of the
+// best bid and offer, or the best price on the other side
+enum class PegType {
+    Primary,
+    Midpoint,
+    Market
+};
+
+// What happens when an incoming order with an owner meets a resting order of the same owner:
+// cancel the rest of the incoming order, cancel the resting order and keep matching, cancel
+// both, or take the smaller of the two sizes off both without trading and keep matching
+enum class SelfTradePrevention {
+    None,
+    CancelNewest,
+    CancelOldest,
+    CancelBoth,
+    Decrement
+};
 
 class Book {
 private:
@@ -21,10 +45,63 @@ private:
     Limit *highestStopSell;
     Limit *lowestStopBuy;
 
-    std::unordered_map<int, Order*> orderMap;
-    std::unordered_map<int, Limit*> limitBuyMap;
-    std::unordered_map<int, Limit*> limitSellMap;
-    std::unordered_map<int, Limit*> stopMap;
+    ArenaMap<int, Order*> orderMap;
+    ArenaMap<int, Limit*> limitBuyMap;
+    ArenaMap<int, Limit*> limitSellMap;
+    ArenaMap<int, Limit*> stopMap;
+    // Newest resting limit order of each owner, the head of a list linked through the orders
+    ArenaMap<int, Order*> ownerOrders;
+
+    // Pegged orders with the same side, peg type and offset always share a price, so each
+    // combination is one FIFO group, indexed by side then peg type then offset. Their prices are
+    // worked out from the book edges only when an incoming order matches, so moving the edges
+    // costs nothing.
+    ArenaOrderedMap<int, Limit*> pegGroups[2][3];
+    ArenaMap<int, Order*> pegOrderMap;
+    int pegCounts[2];
+
+    // Trailing stops that were placed while their side's reference price was at the same high
+    // water mark share an epoch. Sell stops follow the best buy and buy stops the best sell,
+    // with buy prices negated so both sides trigger once the reference falls to the high water
+    // mark minus the offset. Epochs are stacked oldest first with falling high water marks, and
+    // a new high merges the epochs below it into one instead of touching their orders. Within an
+    // epoch, stops are grouped in FIFOs by offset, and each epoch with stops is indexed by its
+    // highest trigger price, so a BBO change only costs the stops it triggers.
+    struct TrailingEpoch {
+        int highWaterMark;
+        // Set while the epoch has groups and is in its side's trigger index
+        bool indexed;
+        int triggerPrice;
+        ArenaOrderedMultimap<int, Limit*> groups;
+
+        TrailingEpoch(int _highWaterMark, Arena* arena)
+            : highWaterMark(_highWaterMark), indexed(false), triggerPrice(0), groups(ArenaAllocator<std::pair<const int, Limit*>>(arena)) {}
+    };
+    std::vector<TrailingEpoch, ArenaAllocator<TrailingEpoch>> trailingEpochs[2];
+    ArenaOrderedSet<std::pair<int, int>> trailingTriggers[2];
+    ArenaMap<int, Order*> trailingOrderMap;
+    std::vector<Order*, ArenaAllocator<Order*>> triggeredTrailingStops;
+    int trailingCounts[2];
+
+    // Expiry times of good till time orders, which also keeps the book's clock. Entries stay in
+    // the wheel when their orders fill or cancel and are skipped when they come due.
+    TimingWheel expiryWheel;
+
+    SelfTradePrevention selfTradePrevention;
+    std::size_t preventedSelfTrades;
+
+    // Set during a call auction, while orders rest without matching
+    bool auctionMode;
+
+    ObjectPool<Order> orderPool;
+    ObjectPool<Limit> limitPool;
+
+    // XOR of a hash of every resting order and level, kept up to date on each change
+    std::uint64_t stateHash;
+    void toggleOrderHash(const Order* order);
+    void toggleLevelHash(const Limit* level, bool stopLevel);
+    void togglePegGroupHash(const Limit* group, PegType pegType);
+    void toggleTrailingEpochHash(bool buyOrSell, int highWaterMark);
 
     void addLimit(int limitPrice, bool buyOrSell);
     void addStop(int stopPrice, bool buyOrSell);
@@ -39,18 +116,43 @@ private:
     void deleteLimit(Limit* limit);
     void deleteStopLevel(Limit* limit);
     void deleteFromOrderMap(int orderId);
+    void linkOwnerOrder(Order* order);
+    void unlinkOwnerOrder(Order* order);
+    int cancelLevelsInRange(Limit* root, int lowPrice, int highPrice, std::vector<Limit*>& emptied);
+    void removeEmptiedLevels(std::vector<Limit*>& emptied, bool buyOrSell);
+    void collectRemainingLevels(Limit* root, const std::vector<Limit*>& removed, std::size_t& nextRemoved, std::vector<Limit*>& levels) const;
     void deleteFromLimitMaps(int LimitPrice, bool buyOrSell);
     void deleteFromStopMap(int StopPrice);
-    int limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int limitPrice);
+    void restLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int ownerId);
+    int limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int ownerId=0);
     int stopOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int stopPrice);
     int existingOrderAsMarketOrder(Order* headOrder, bool buyOrSell);
     int stopLimitOrderAsLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice);
     void executeStopOrders(bool buyOrSell);
+    void executeFixedStopOrders(bool buyOrSell);
+    bool executeTrailingStops(bool buyOrSell);
+    int trailingReference(bool buyOrSell) const;
+    void raiseTrailingWatermark(bool buyOrSell);
+    void mergeTrailingEpoch(TrailingEpoch& older, TrailingEpoch& newer);
+    void updateTrailingTrigger(bool buyOrSell, int epochIndex);
     void stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell);
     void marketOrderHelper(int orderId, bool buyOrSell, int shares);
+    template <bool preventSelfTrade>
+    bool fillBookEdge(bool buyOrSell, int& shares, int ownerId=0);
+    int matchOwnedOrder(bool buyOrSell, int shares, int limitPrice, int ownerId);
+    bool applySelfTradePrevention(Order* restingOrder, int& shares);
+    int matchPeggedOrders(bool buyOrSell, int shares, int limitPrice, int ownerId=0);
+    static bool pegPrice(bool buyOrSell, PegType pegType, int offset, int bestBuy, int bestSell, int& price);
+    Limit* bestPegGroup(bool buyOrSell, int bestBuy, int bestSell, PegType& pegType, int& price) const;
+    void fillPegGroup(Limit* group, PegType pegType, int shares);
+    PegType findPegType(const Order* order) const;
+    bool hasVolume(bool buyOrSell, int shares, int limitPrice) const;
+    void fillAuctionSide(bool buyOrSell, int shares);
+    static Limit* nextLevel(Limit* level, bool ascending);
 
     // Functions to balance AVL tree
     int limitHeightDifference(Limit* limit);
+    void updateLimitHeight(Limit* limit);
     Limit* rr_rotate(Limit* limit);
     Limit* ll_rotate(Limit* limit);
     Limit* lr_rotate(Limit* limit);
@@ -62,8 +164,20 @@ private:
     Limit* rl_rotateStop(Limit* limit);
     Limit* balanceStop(Limit* limit);
 
+    // Functions used to snapshot and restore the book
+    void clear();
+    std::uint32_t serializeLevels(Limit* root, char*& cursor) const;
+    bool restoreOrders(const char* data, std::size_t size, std::size_t& position, Limit* level, std::uint32_t levelSize, ArenaMap<int, Order*>& index);
+    Limit* buildTree(std::vector<Limit*>& levels, int start, int end, Limit* parent);
+    bool checkLevels(Limit* root, Limit* parent, bool stopTree, std::size_t& levelCount, std::size_t& orderCount, std::uint64_t& hash) const;
+    bool checkPegGroups(std::uint64_t& hash) const;
+    bool checkTrailingStops(std::uint64_t& hash) const;
+
 public:
-    Book();
+    // Without an arena the book allocates from the heap; with one, the book's pools and
+    // indexes are allocated entirely from the arena. heapAllocation makes the arena-less pools
+    // allocate every order and level from the global heap rather than from per-book slabs
+    explicit Book(Arena* arena=nullptr, bool heapAllocation=false);
     ~Book();
 
     // Counts used in order book perforamce visualisations
@@ -81,8 +195,8 @@ public:
     Limit* getLowestStopBuy() const;
 
     // Functions for different types of orders
-    void marketOrder(int orderId, bool buyOrSell, int shares);
-    void addLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice);
+    void marketOrder(int orderId, bool buyOrSell, int shares, int ownerId=0);
+    void addLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int ownerId=0);
     void cancelLimitOrder(int orderId);
     void modifyLimitOrder(int orderId, int newShares, int newLimit);
     void addStopOrder(int orderId, bool buyOrSell, int shares, int stopPrice);
@@ -91,6 +205,81 @@ public:
     void addStopLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice);
     void cancelStopLimitOrder(int orderId);
     void modifyStopLimitOrder(int orderId, int newShares, int newLimitPrice, int newStopPrice);
+    // Take liquidity up to limitPrice without ever resting. Immediate or cancel fills what it
+    // can and drops the rest, returning the shares filled. Fill or kill only trades if every
+    // share can be filled, returning whether it traded.
+    int immediateOrCancelOrder(int orderId, bool buyOrSell, int shares, int limitPrice);
+    bool fillOrKillOrder(int orderId, bool buyOrSell, int shares, int limitPrice);
+    // Market order that only trades up to protection ticks past the best price on the other side
+    // when it arrives, so it cannot sweep a thin book. Whatever is left at that price is dropped,
+    // or with restRemainder added as a limit order there. Returns the shares left over.
+    int protectedMarketOrder(int orderId, bool buyOrSell, int shares, int protection, bool restRemainder=false, int ownerId=0);
+    // Limit order that only shows displayShares at a time. Each time the displayed slice fills,
+    // the next slice is shown at the back of the same level. Cancel and modify it as a limit order.
+    void addIcebergOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int displayShares);
+    // Resting order priced at its peg's reference price plus offset, capped one tick short of
+    // the other side so it never crosses. It trades after limit orders at the same price, only
+    // with incoming orders, and not while its reference price is missing.
+    void addPeggedOrder(int orderId, bool buyOrSell, int shares, PegType pegType, int offset);
+    void cancelPeggedOrder(int orderId);
+    // Price a pegged order would trade at right now, false if it is not priced or not found
+    bool getPeggedPrice(int orderId, int& price) const;
+    // Stop market order whose stop price trails the best price on the other side by offset.
+    // A sell stop triggers once the best buy falls offset below the highest it has been since
+    // the stop was placed, and a buy stop once the best sell rises offset above its lowest.
+    // Like fixed stops, they are checked after orders trade, not after cancels.
+    void addTrailingStopOrder(int orderId, bool buyOrSell, int shares, int offset);
+    void cancelTrailingStopOrder(int orderId);
+    // Current stop price of a trailing stop, false if it is not found
+    bool getTrailingStopPrice(int orderId, int& stopPrice) const;
+    // Limit order that is cancelled once the book's clock reaches expiryTime. Times are
+    // non-negative ticks in whatever unit the caller picks, such as milliseconds since the open.
+    void addGoodTillTimeOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int expiryTime);
+    // Move the book's clock forward to now and cancel at most budget expired orders, returning
+    // how many were cancelled. Expired orders over the budget stay on the book, and can still
+    // trade, until a later call reaches them, so a burst of expiries can be spread out.
+    int advanceTime(int now, int budget=INT_MAX);
+    int getTime() const;
+    // Expired orders that are still waiting for advanceTime to cancel them, including some that
+    // have already filled or been cancelled
+    std::size_t getPendingExpiryCount() const;
+    // Cancel every resting limit order of an owner, or every one on a side priced from lowPrice
+    // to highPrice, returning how many were cancelled. Only the cancelled orders are visited.
+    // A few emptied levels are deleted one at a time, while many leave the tree together with a
+    // single rebuild. Stop, pegged and trailing stop orders are left alone.
+    int cancelOwnerOrders(int ownerId);
+    int massCancel(bool buyOrSell, int lowPrice=INT_MIN, int highPrice=INT_MAX);
+    // Market and limit orders with an owner are checked against the owner of each resting limit
+    // order they meet, as set here. Orders without an owner, and every other kind of order, are
+    // never checked. The setting is not part of snapshots.
+    void setSelfTradePrevention(SelfTradePrevention mode);
+    SelfTradePrevention getSelfTradePrevention() const;
+    // Resting orders that an incoming order met and did not trade with because of their owner
+    std::size_t getPreventedSelfTradeCount() const;
+    // Call auction. Once started, limit, iceberg and good till time orders rest even where they
+    // cross the other side, and stop orders wait, while market, immediate or cancel and fill or
+    // kill orders are rejected. Uncrossing trades the crossed orders at one price in price then
+    // time priority, ignoring owners, and returns to continuous trading. Pegged orders do not
+    // take part. The auction price is the one with the most executable volume, then the smallest
+    // imbalance, then the highest price when buyers are left over or the lowest when sellers
+    // are, then the nearest to referencePrice. getAuctionPrice returns false if the book is not
+    // crossed, and uncrossAuction returns the shares traded.
+    void startAuction();
+    bool inAuction() const;
+    bool getAuctionPrice(int& price, int& volume, int referencePrice=INT_MIN) const;
+    int uncrossAuction(int referencePrice=INT_MIN);
+
+    // Binary snapshots of every limit level, stop level and order, preserving FIFO order
+    std::vector<char> serializeSnapshot(std::uint64_t sequenceNumber=0) const;
+    bool restoreSnapshot(const char* data, std::size_t size, std::uint64_t* sequenceNumber=nullptr);
+    bool saveSnapshot(const std::string& filename, std::uint64_t sequenceNumber=0) const;
+    bool loadSnapshot(const std::string& filename, std::uint64_t* sequenceNumber=nullptr);
+
+    // Hash of the book's orders, including their queue positions, and levels, cheap enough to read after every command
+    std::uint64_t getStateHash() const;
+
+    // Walk every tree and order queue checking links, counts, volumes, indexes, book edges and the state hash
+    bool checkConsistency() const;
 
     // Functions that needed to be public for testing purposes
     int getLimitHeight(Limit* limit) const;
@@ -109,9 +298,9 @@ public:
 
     // Functions and data structures needed for generating sample data
     Order* getRandomOrder(int key, std::mt19937 gen) const;
-    std::unordered_set<Order*> limitOrders;
-    std::unordered_set<Order*> stopOrders;
-    std::unordered_set<Order*> stopLimitOrders;
+    ArenaSet<Order*> limitOrders;
+    ArenaSet<Order*> stopOrders;
+    ArenaSet<Order*> stopLimitOrders;
 };
 
 #endif
\ No newline at end of file
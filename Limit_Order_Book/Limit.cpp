@@ -3,7 +3,7 @@
 #include <iostream>
 
 Limit::Limit(int _limitPrice, bool _buyOrSell, int _size, int _totalVolume)
-    : limitPrice(_limitPrice), buyOrSell(_buyOrSell), size(_size), totalVolume(_totalVolume),
+    : limitPrice(_limitPrice), buyOrSell(_buyOrSell), size(_size), totalVolume(_totalVolume), hiddenVolume(0), appendCount(0), height(1),
     parent(nullptr), leftChild(nullptr), rightChild(nullptr),
     headOrder(nullptr), tailOrder(nullptr) {}
 
@@ -115,6 +115,16 @@ int Limit::getTotalVolume() const
     return totalVolume;
 }
 
+int Limit::getHiddenVolume() const
+{
+    return hiddenVolume;
+}
+
+std::uint32_t Limit::getAppendCount() const
+{
+    return appendCount;
+}
+
 bool Limit::getBuyOrSell() const
 {
     return buyOrSell;
@@ -166,8 +176,10 @@ void Limit::append(Order *order)
             order->nextOrder = nullptr;
             tailOrder = order;
         }
+        order->queuePosition = appendCount++;
         size += 1;
         totalVolume += order->getShares();
+        hiddenVolume += order->hiddenShares;
         order->parentLimit = this;
 }
 
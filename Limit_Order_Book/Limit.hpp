@@ -1,6 +1,8 @@
 #ifndef LIMIT_HPP
 #define LIMIT_HPP
 
+#include <cstdint>
+
 class Order;
 
 class Limit {
@@ -8,7 +10,13 @@ private:
     int limitPrice;
     int size;
     int totalVolume;
+    // Shares held back by iceberg orders, not part of totalVolume
+    int hiddenVolume;
+    // Queue position handed to the next appended order, restarting at 0 once the level empties
+    std::uint32_t appendCount;
     bool buyOrSell;
+    // Height of the subtree rooted at this level, kept current by the book's AVL code
+    std::uint8_t height;
     Limit *parent;
     Limit *leftChild;
     Limit *rightChild;
@@ -16,6 +24,7 @@ private:
     Order *tailOrder;
 
     friend class Order;
+    friend class Book;
 public:
     Limit(int _limitPrice, bool _buyOrSell, int _size=0, int _totalVolume=0);
     ~Limit();
@@ -24,6 +33,8 @@ public:
     int getLimitPrice() const;
     int getSize() const;
     int getTotalVolume() const;
+    int getHiddenVolume() const;
+    std::uint32_t getAppendCount() const;
     bool getBuyOrSell() const;
     Limit* getParent() const;
     Limit* getLeftChild() const;
@@ -0,0 +1,151 @@
+#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+#include "Arena.hpp"
+
+// Per-book slab allocator for orders and limits. Freed slots go on an intrusive free list
+// and are reused first, so a book in steady state never goes back to the global heap and
+// books on different threads never contend on the allocator. Given an arena, the slabs and
+// the slab list are allocated from it instead of the heap. In heap mode every object is
+// allocated from and freed to the global heap instead, linked into a list of live objects so
+// reset can still release them all; this keeps the old allocation pattern measurable.
+template <typename T>
+class ObjectPool {
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct HeapNode {
+        HeapNode* prev;
+        HeapNode* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    ArenaAllocator<Slot> slabAllocator;
+    std::vector<Slot*, ArenaAllocator<Slot*>> slabs;
+    Slot* freeList;
+    std::size_t slabSize;
+    std::size_t liveCount;
+    bool useHeap;
+    HeapNode* heapObjects;
+
+    static HeapNode* heapNode(T* object)
+    {
+        return reinterpret_cast<HeapNode*>(reinterpret_cast<unsigned char*>(object) - offsetof(HeapNode, storage));
+    }
+
+    void releaseHeapObjects()
+    {
+        while (heapObjects != nullptr)
+        {
+            HeapNode* next = heapObjects->next;
+            ::operator delete(heapObjects);
+            heapObjects = next;
+        }
+    }
+
+    void grow()
+    {
+        Slot* slab = slabAllocator.allocate(slabSize);
+        slabs.push_back(slab);
+        for (std::size_t i = slabSize; i > 0; i--)
+        {
+            slab[i - 1].next = freeList;
+            freeList = &slab[i - 1];
+        }
+    }
+
+public:
+    explicit ObjectPool(std::size_t _slabSize=4096, Arena* arena=nullptr, bool _useHeap=false)
+        : slabAllocator(arena), slabs(ArenaAllocator<Slot*>(arena)), freeList(nullptr), slabSize(_slabSize), liveCount(0),
+        useHeap(_useHeap), heapObjects(nullptr) {}
+
+    // Releases the slabs without running destructors of objects still allocated
+    ~ObjectPool()
+    {
+        releaseHeapObjects();
+        for (Slot* slab : slabs)
+        {
+            slabAllocator.deallocate(slab, slabSize);
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args)
+    {
+        if (useHeap)
+        {
+            HeapNode* node = static_cast<HeapNode*>(::operator new(sizeof(HeapNode)));
+            node->prev = nullptr;
+            node->next = heapObjects;
+            if (heapObjects != nullptr)
+            {
+                heapObjects->prev = node;
+            }
+            heapObjects = node;
+            liveCount += 1;
+            return new (node->storage) T(std::forward<Args>(args)...);
+        }
+        if (freeList == nullptr)
+        {
+            grow();
+        }
+        Slot* slot = freeList;
+        freeList = slot->next;
+        liveCount += 1;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object)
+    {
+        object->~T();
+        if (useHeap)
+        {
+            HeapNode* node = heapNode(object);
+            (node->prev != nullptr ? node->prev->next : heapObjects) = node->next;
+            if (node->next != nullptr)
+            {
+                node->next->prev = node->prev;
+            }
+            ::operator delete(node);
+            liveCount -= 1;
+            return;
+        }
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = freeList;
+        freeList = slot;
+        liveCount -= 1;
+    }
+
+    // Return every slot to the free list without running destructors, keeping the slabs
+    void reset()
+    {
+        releaseHeapObjects();
+        freeList = nullptr;
+        for (Slot* slab : slabs)
+        {
+            for (std::size_t i = slabSize; i > 0; i--)
+            {
+                slab[i - 1].next = freeList;
+                freeList = &slab[i - 1];
+            }
+        }
+        liveCount = 0;
+    }
+
+    std::size_t size() const
+    {
+        return liveCount;
+    }
+};
+
+#endif
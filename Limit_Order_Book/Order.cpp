@@ -2,9 +2,10 @@
 #include "Limit.hpp"
 #include <iostream>
 
-Order::Order(int _idNumber, bool _buyOrSell, int _shares, int _limit)
-    : idNumber(_idNumber), buyOrSell(_buyOrSell), shares(_shares), limit(_limit), 
-    nextOrder(nullptr), prevOrder(nullptr), parentLimit(nullptr) {}
+Order::Order(int _idNumber, bool _buyOrSell, int _shares, int _limit, int _displayShares, int _hiddenShares, int _expiryTime, int _ownerId)
+    : idNumber(_idNumber), buyOrSell(_buyOrSell), shares(_shares), limit(_limit), displayShares(_displayShares),
+    hiddenShares(_hiddenShares), expiryTime(_expiryTime), ownerId(_ownerId), queuePosition(0), nextOrder(nullptr), prevOrder(nullptr),
+    nextOwnerOrder(nullptr), prevOwnerOrder(nullptr), parentLimit(nullptr) {}
 
 int Order::getShares() const
 {
@@ -26,11 +27,46 @@ int Order::getLimit() const
     return limit;
 }
 
+int Order::getDisplayShares() const
+{
+    return displayShares;
+}
+
+int Order::getHiddenShares() const
+{
+    return hiddenShares;
+}
+
+int Order::getExpiryTime() const
+{
+    return expiryTime;
+}
+
+int Order::getOwnerId() const
+{
+    return ownerId;
+}
+
+std::uint32_t Order::getQueuePosition() const
+{
+    return queuePosition;
+}
+
 Limit* Order::getParentLimit() const
 {
     return parentLimit;
 }
 
+Order* Order::getNextOrder() const
+{
+    return nextOrder;
+}
+
+Order* Order::getNextOwnerOrder() const
+{
+    return nextOwnerOrder;
+}
+
 void Order::partiallyFillOrder(int orderedShares)
 {
     shares -= orderedShares;
@@ -56,7 +92,12 @@ void Order::cancel()
     }
 
     parentLimit->totalVolume -= shares;
+    parentLimit->hiddenVolume -= hiddenShares;
     parentLimit->size -= 1;
+    if (parentLimit->size == 0)
+    {
+        parentLimit->appendCount = 0;
+    }
 }
 
 // Execute head order
@@ -74,18 +115,51 @@ void Order::execute()
     prevOrder = nullptr;
 
     parentLimit->totalVolume -= shares;
+    parentLimit->hiddenVolume -= hiddenShares;
     parentLimit->size -= 1;
+    if (parentLimit->size == 0)
+    {
+        parentLimit->appendCount = 0;
+    }
 }
 
+// Once the displayed shares of an iceberg head order have filled, show the next slice of its
+// reserve and send it to the back of the same limit, keeping the order and its level in place
+void Order::replenish()
+{
+    execute();
+    shares = hiddenShares < displayShares ? hiddenShares : displayShares;
+    hiddenShares -= shares;
+    parentLimit->append(this);
+}
+
+// New shares of an iceberg are its new total size, split again into a displayed slice and reserve
 void Order::modifyOrder(int newShares, int newLimit)
 {
     shares = newShares;
+    if (displayShares != 0)
+    {
+        shares = newShares < displayShares ? newShares : displayShares;
+        hiddenShares = newShares - shares;
+    }
     limit = newLimit;
     nextOrder = nullptr;
     prevOrder = nullptr;
     parentLimit = nullptr;
 }
 
+// Shrink a resting order to newShares without moving it, so it keeps its place in the queue.
+// An iceberg gives up its reserve first and then its displayed slice.
+void Order::reduceShares(int newShares)
+{
+    int newHiddenShares = newShares > shares ? newShares - shares : 0;
+    int newDisplayedShares = newShares > shares ? shares : newShares;
+    parentLimit->totalVolume -= shares - newDisplayedShares;
+    parentLimit->hiddenVolume -= hiddenShares - newHiddenShares;
+    shares = newDisplayedShares;
+    hiddenShares = newHiddenShares;
+}
+
 void Order::setShares(int newShares)
 {
     shares = newShares;
@@ -1,6 +1,8 @@
 #ifndef ORDER_HPP
 #define ORDER_HPP
 
+#include <cstdint>
+
 class Limit;
 
 class Order {
@@ -9,24 +11,48 @@ private:
     bool buyOrSell;
     int shares;
     int limit;
+    // Iceberg orders show at most displayShares at a time and keep the rest hidden.
+    // Both are 0 for ordinary orders.
+    int displayShares;
+    int hiddenShares;
+    // Good till time orders are cancelled once the book's clock reaches expiryTime, 0 for
+    // orders that rest until they are cancelled
+    int expiryTime;
+    // Participant that owns the order, 0 for none. The book links each owner's resting limit
+    // orders into a list so they can all be cancelled together.
+    int ownerId;
+    // Order of arrival at the parent limit, increasing from head to tail
+    std::uint32_t queuePosition;
     Order *nextOrder;
     Order *prevOrder;
+    Order *nextOwnerOrder;
+    Order *prevOwnerOrder;
     Limit *parentLimit;
 
     friend class Limit;
+    friend class Book;
 public:
-    Order(int _idNumber, bool _buyOrSell, int _shares, int _limit);
+    Order(int _idNumber, bool _buyOrSell, int _shares, int _limit, int _displayShares=0, int _hiddenShares=0, int _expiryTime=0, int _ownerId=0);
 
     int getShares() const;
     int getOrderId() const;
     bool getBuyOrSell() const;
     int getLimit() const;
+    int getDisplayShares() const;
+    int getHiddenShares() const;
+    int getExpiryTime() const;
+    int getOwnerId() const;
+    std::uint32_t getQueuePosition() const;
     Limit* getParentLimit() const;
+    Order* getNextOrder() const;
+    Order* getNextOwnerOrder() const;
 
     void partiallyFillOrder(int orderedShares);
     void cancel();
     void execute();
+    void replenish();
     void modifyOrder(int newShares, int newLimit);
+    void reduceShares(int newShares);
     void setShares(int newShares);
 
     void print() const;
@@ -0,0 +1,142 @@
+#include "TimingWheel.hpp"
+#include <algorithm>
+#include <bit>
+
+TimingWheel::TimingWheel(Arena* arena)
+    : slots(levelCount * slotCount, EntryList(ArenaAllocator<Entry>(arena)), ArenaAllocator<EntryList>(arena)), occupied{},
+    overflow(ArenaAllocator<Entry>(arena)), due(ArenaAllocator<Entry>(arena)), dueHead(0), scratch(ArenaAllocator<Entry>(arena)),
+    currentTime(0), entryCount(0) {}
+
+void TimingWheel::schedule(int orderId, int expiryTime)
+{
+    place(Entry{orderId, expiryTime});
+    entryCount += 1;
+}
+
+// File an entry relative to the current time
+void TimingWheel::place(const Entry& entry)
+{
+    if (entry.expiryTime <= currentTime)
+    {
+        due.push_back(entry);
+        return;
+    }
+    std::uint32_t difference = std::uint32_t(entry.expiryTime) ^ std::uint32_t(currentTime);
+    int level = (std::bit_width(difference) - 1) / slotBits;
+    if (level >= levelCount)
+    {
+        overflow.push_back(entry);
+        return;
+    }
+    int slot = (std::uint32_t(entry.expiryTime) >> (level * slotBits)) & (slotCount - 1);
+    slots[level * slotCount + slot].push_back(entry);
+    occupied[level] |= std::uint64_t(1) << slot;
+}
+
+// File every entry of a list again, leaving it empty
+void TimingWheel::refile(EntryList& list)
+{
+    scratch.swap(list);
+    for (const Entry& entry : scratch)
+    {
+        place(entry);
+    }
+    scratch.clear();
+}
+
+void TimingWheel::advance(int now)
+{
+    while (currentTime < now)
+    {
+        // The next time anything happens is the earliest occupied slot ahead of the clock on
+        // any level, or the next time the overflow list is filed again
+        std::int64_t next = now;
+        for (int level = 0; level < levelCount; level++)
+        {
+            int shift = level * slotBits;
+            int current = (currentTime >> shift) & (slotCount - 1);
+            std::uint64_t ahead = current == slotCount - 1 ? 0 : occupied[level] & (~std::uint64_t(0) << (current + 1));
+            if (ahead != 0)
+            {
+                std::int64_t blockStart = (std::int64_t(currentTime) >> (shift + slotBits)) << (shift + slotBits);
+                next = std::min(next, blockStart + (std::int64_t(std::countr_zero(ahead)) << shift));
+            }
+        }
+        constexpr int wheelBits = levelCount * slotBits;
+        if (!overflow.empty())
+        {
+            next = std::min(next, ((std::int64_t(currentTime) >> wheelBits) + 1) << wheelBits);
+        }
+        currentTime = static_cast<int>(next);
+
+        // Higher levels move down first, so entries they drop into lower slots due now are caught
+        if ((currentTime & ((1 << wheelBits) - 1)) == 0 && !overflow.empty())
+        {
+            refile(overflow);
+        }
+        for (int level = levelCount - 1; level > 0; level--)
+        {
+            int shift = level * slotBits;
+            int slot = (currentTime >> shift) & (slotCount - 1);
+            if ((currentTime & ((1 << shift) - 1)) == 0 && (occupied[level] >> slot & 1) != 0)
+            {
+                occupied[level] &= ~(std::uint64_t(1) << slot);
+                refile(slots[level * slotCount + slot]);
+            }
+        }
+        int slot = currentTime & (slotCount - 1);
+        if ((occupied[0] >> slot & 1) != 0)
+        {
+            occupied[0] &= ~(std::uint64_t(1) << slot);
+            EntryList& list = slots[slot];
+            due.insert(due.end(), list.begin(), list.end());
+            list.clear();
+        }
+    }
+}
+
+bool TimingWheel::popDue(Entry& entry)
+{
+    if (dueHead == due.size())
+    {
+        return false;
+    }
+    entry = due[dueHead];
+    dueHead += 1;
+    if (dueHead == due.size())
+    {
+        due.clear();
+        dueHead = 0;
+    }
+    entryCount -= 1;
+    return true;
+}
+
+void TimingWheel::clear(int time)
+{
+    for (EntryList& list : slots)
+    {
+        list.clear();
+    }
+    std::fill(std::begin(occupied), std::end(occupied), 0);
+    overflow.clear();
+    due.clear();
+    dueHead = 0;
+    currentTime = time;
+    entryCount = 0;
+}
+
+int TimingWheel::getTime() const
+{
+    return currentTime;
+}
+
+std::size_t TimingWheel::getDueCount() const
+{
+    return due.size() - dueHead;
+}
+
+std::size_t TimingWheel::size() const
+{
+    return entryCount;
+}
@@ -0,0 +1,81 @@
+#ifndef TIMINGWHEEL_HPP
+#define TIMINGWHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Arena.hpp"
+
+// Hierarchical timing wheel of order expiry times. Level 0 has a slot per tick and each level
+// above has slots 64 times as wide. An entry is filed by the highest 6 bit group in which its
+// expiry time differs from the clock, and moves down a level each time the clock reaches its
+// slot, so it is handled at most once per level. Expiry times past the top level wait in an
+// overflow list. Advancing jumps straight to the next occupied slot using a bitmap per level,
+// so long quiet periods cost nothing. Due entries are queued rather than handled, so the caller
+// can work through them a few at a time. Entries are never removed early: the caller checks each
+// one against the book when it comes out. Times are non-negative ticks.
+class TimingWheel {
+public:
+    struct Entry {
+        int orderId;
+        int expiryTime;
+    };
+
+private:
+    static constexpr int slotBits = 6;
+    static constexpr int slotCount = 1 << slotBits;
+    static constexpr int levelCount = 4;
+
+    using EntryList = std::vector<Entry, ArenaAllocator<Entry>>;
+
+    // levelCount * slotCount lists, level by level
+    std::vector<EntryList, ArenaAllocator<EntryList>> slots;
+    std::uint64_t occupied[levelCount];
+    EntryList overflow;
+    EntryList due;
+    std::size_t dueHead;
+    EntryList scratch;
+    int currentTime;
+    std::size_t entryCount;
+
+    void place(const Entry& entry);
+    void refile(EntryList& list);
+
+public:
+    explicit TimingWheel(Arena* arena=nullptr);
+
+    // Entries that are already due go straight to the due queue
+    void schedule(int orderId, int expiryTime);
+    // Move the clock forward to now, queueing every entry due by then. Earlier times are ignored.
+    void advance(int now);
+    // Take the oldest due entry, false if none are due
+    bool popDue(Entry& entry);
+    // Drop every entry and set the clock
+    void clear(int time=0);
+
+    int getTime() const;
+    std::size_t getDueCount() const;
+    std::size_t size() const;
+
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const
+    {
+        for (const EntryList& list : slots)
+        {
+            for (const Entry& entry : list)
+            {
+                visit(entry);
+            }
+        }
+        for (const Entry& entry : overflow)
+        {
+            visit(entry);
+        }
+        for (std::size_t i = dueHead; i < due.size(); i++)
+        {
+            visit(due[i]);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,351 @@
+#include "BookManager.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <chrono>
+#include <iostream>
+
+static std::int64_t nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BookManager::BookManager(int numberOfShards, std::size_t queueCapacity)
+    : running(false), recordLatencies(false), rebalanceInterval(0), submittedSinceRebalance(0),
+    maxMigrationsPerRebalance(4), migrationCount(0)
+{
+    for (int i = 0; i < numberOfShards; i++)
+    {
+        shards.push_back(new Shard(queueCapacity));
+    }
+}
+
+// Stop the matching threads before freeing the books they own
+BookManager::~BookManager()
+{
+    stop();
+    for (Shard* shard : shards)
+    {
+        delete shard;
+    }
+    shards.clear();
+
+    for (ManagedBook* managedBook : books)
+    {
+        delete managedBook->book;
+        delete managedBook;
+    }
+    books.clear();
+}
+
+// Create the book for a new symbol and assign it to a shard round robin
+int BookManager::addSymbol(const std::string& symbol)
+{
+    auto it = symbolIds.find(symbol);
+    if (it != symbolIds.end())
+    {
+        return it->second;
+    }
+    int symbolId = books.size();
+    ManagedBook* managedBook = new ManagedBook(symbol, symbolId % static_cast<int>(shards.size()));
+    managedBook->book = new Book();
+    books.push_back(managedBook);
+    symbolIds.emplace(symbol, symbolId);
+    return symbolId;
+}
+
+int BookManager::getSymbolId(const std::string& symbol) const
+{
+    auto it = symbolIds.find(symbol);
+    if (it != symbolIds.end())
+    {
+        return it->second;
+    }
+    std::cout << "No symbol " << symbol << std::endl;
+    return -1;
+}
+
+const std::string& BookManager::getSymbol(int symbolId) const
+{
+    return books[symbolId]->symbol;
+}
+
+Book* BookManager::getBook(int symbolId) const
+{
+    return books[symbolId]->book;
+}
+
+int BookManager::getShard(int symbolId) const
+{
+    return books[symbolId]->shard;
+}
+
+int BookManager::getNumberOfSymbols() const
+{
+    return books.size();
+}
+
+int BookManager::getNumberOfShards() const
+{
+    return shards.size();
+}
+
+void BookManager::start()
+{
+    if (!running.exchange(true))
+    {
+        for (int i = 0; i < static_cast<int>(shards.size()); i++)
+        {
+            shards[i]->thread = std::thread(&BookManager::shardLoop, this, i);
+        }
+    }
+}
+
+// Stop the matching threads once everything already submitted has been applied
+void BookManager::stop()
+{
+    if (running.exchange(false))
+    {
+        for (Shard* shard : shards)
+        {
+            shard->thread.join();
+        }
+    }
+}
+
+// Symbol ids come from the wire, so they are checked before they index the books
+static bool validSymbolId(int symbolId, std::size_t numberOfBooks)
+{
+    if (symbolId < 0 || static_cast<std::size_t>(symbolId) >= numberOfBooks)
+    {
+        std::cerr << "No symbol id " << symbolId << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool BookManager::submit(const Command& command)
+{
+    if (!validSymbolId(command.symbolId, books.size()))
+    {
+        return false;
+    }
+    ManagedBook* managedBook = books[command.symbolId];
+    managedBook->submittedCount += 1;
+    pushToShard(managedBook->shard, ShardRequest{recordLatencies ? nowNanoseconds() : 0, -1, command});
+
+    if (rebalanceInterval != 0 && ++submittedSinceRebalance >= rebalanceInterval)
+    {
+        rebalance();
+    }
+    return true;
+}
+
+bool BookManager::apply(const Command& command)
+{
+    if (!validSymbolId(command.symbolId, books.size()))
+    {
+        return false;
+    }
+    applyCommand(books[command.symbolId]->book, command);
+    return true;
+}
+
+void BookManager::pushToShard(int shardIndex, const ShardRequest& request)
+{
+    MPSCQueue<ShardRequest>& queue = shards[shardIndex]->queue;
+    while (!queue.tryPush(request))
+    {
+        std::this_thread::yield();
+    }
+}
+
+// Apply a request to a book this shard currently owns. A handoff marker is the last request
+// the old shard sees for the book, so publishing the new owner here hands over a quiescent book.
+void BookManager::processRequest(int shardIndex, const ShardRequest& request)
+{
+    Shard* shard = shards[shardIndex];
+    ManagedBook* managedBook = books[request.command.symbolId];
+    if (request.handoffShard >= 0)
+    {
+        managedBook->activeShard.store(request.handoffShard, std::memory_order_release);
+        return;
+    }
+
+    applyCommand(managedBook->book, request.command);
+    shard->processedCount += 1;
+    if (recordLatencies)
+    {
+        shard->latencies.push_back(nowNanoseconds() - request.submitTime);
+    }
+}
+
+// Apply every command waiting for a shard, returns how many requests were handled.
+// Requests for a book still being handed over are parked until the old shard lets go of it.
+std::size_t BookManager::processShard(int shardIndex)
+{
+    Shard* shard = shards[shardIndex];
+    std::size_t processed = 0;
+
+    for (auto it = shard->parkedRequests.begin(); it != shard->parkedRequests.end();)
+    {
+        if (books[it->first]->activeShard.load(std::memory_order_acquire) == shardIndex)
+        {
+            for (const ShardRequest& request : it->second)
+            {
+                processRequest(shardIndex, request);
+            }
+            processed += it->second.size();
+            it = shard->parkedRequests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    ShardRequest request;
+    while (shard->queue.tryPop(request))
+    {
+        int symbolId = request.command.symbolId;
+        auto parked = shard->parkedRequests.find(symbolId);
+        if (parked != shard->parkedRequests.end())
+        {
+            parked->second.push_back(request);
+        } else if (books[symbolId]->activeShard.load(std::memory_order_acquire) != shardIndex)
+        {
+            shard->parkedRequests[symbolId].push_back(request);
+        } else {
+            processRequest(shardIndex, request);
+        }
+        processed += 1;
+    }
+    return processed;
+}
+
+void BookManager::shardLoop(int shardIndex)
+{
+    while (running.load(std::memory_order_acquire))
+    {
+        if (processShard(shardIndex) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    // Drain, waiting for any handoffs still travelling through other shards' queues
+    while (processShard(shardIndex) != 0 || !shards[shardIndex]->parkedRequests.empty())
+    {
+        std::this_thread::yield();
+    }
+}
+
+void BookManager::setRebalanceInterval(std::uint64_t interval, int maxMigrations)
+{
+    rebalanceInterval = interval;
+    maxMigrationsPerRebalance = maxMigrations;
+}
+
+// Move books off the busiest shard using the command rates seen since the last rebalance.
+// Each step moves the busiest book that still narrows the gap between the busiest and idlest
+// shards, so cold books leave and a hot book keeps its thread. Returns the number of migrations.
+int BookManager::rebalance()
+{
+    std::vector<std::uint64_t> load(shards.size(), 0);
+    for (ManagedBook* managedBook : books)
+    {
+        load[managedBook->shard] += managedBook->submittedCount;
+    }
+
+    int migrations = 0;
+    while (migrations < maxMigrationsPerRebalance)
+    {
+        int busiest = 0;
+        int idlest = 0;
+        for (int i = 1; i < static_cast<int>(shards.size()); i++)
+        {
+            if (load[i] > load[busiest])
+            {
+                busiest = i;
+            }
+            if (load[i] < load[idlest])
+            {
+                idlest = i;
+            }
+        }
+        std::uint64_t gap = load[busiest] - load[idlest];
+
+        int candidate = -1;
+        for (int symbolId = 0; symbolId < static_cast<int>(books.size()); symbolId++)
+        {
+            ManagedBook* managedBook = books[symbolId];
+            std::uint64_t rate = managedBook->submittedCount;
+            if (managedBook->shard == busiest && rate != 0 && 2 * rate < gap && !isHandoffPending(symbolId)
+                && (candidate < 0 || rate > books[candidate]->submittedCount))
+            {
+                candidate = symbolId;
+            }
+        }
+        if (candidate < 0)
+        {
+            break;
+        }
+
+        std::uint64_t rate = books[candidate]->submittedCount;
+        migrate(candidate, idlest);
+        load[busiest] -= rate;
+        load[idlest] += rate;
+        migrations += 1;
+    }
+
+    for (ManagedBook* managedBook : books)
+    {
+        managedBook->submittedCount = 0;
+    }
+    submittedSinceRebalance = 0;
+    return migrations;
+}
+
+// Hand a book over to another shard, refused while a previous handoff of the book is in flight
+bool BookManager::migrate(int symbolId, int newShard)
+{
+    ManagedBook* managedBook = books[symbolId];
+    if (newShard == managedBook->shard || isHandoffPending(symbolId))
+    {
+        return false;
+    }
+
+    Command marker{};
+    marker.symbolId = symbolId;
+    pushToShard(managedBook->shard, ShardRequest{0, newShard, marker});
+    managedBook->shard = newShard;
+    migrationCount += 1;
+    return true;
+}
+
+bool BookManager::isHandoffPending(int symbolId) const
+{
+    return books[symbolId]->activeShard.load(std::memory_order_acquire) != books[symbolId]->shard;
+}
+
+std::uint64_t BookManager::getMigrationCount() const
+{
+    return migrationCount;
+}
+
+void BookManager::setRecordLatencies(bool record)
+{
+    recordLatencies = record;
+}
+
+std::vector<std::int64_t> BookManager::getLatencies() const
+{
+    std::vector<std::int64_t> result;
+    for (Shard* shard : shards)
+    {
+        result.insert(result.end(), shard->latencies.begin(), shard->latencies.end());
+    }
+    return result;
+}
+
+std::uint64_t BookManager::getProcessedCount(int shardIndex) const
+{
+    return shards[shardIndex]->processedCount;
+}
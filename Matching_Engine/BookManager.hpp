@@ -0,0 +1,105 @@
+#ifndef BOOKMANAGER_HPP
+#define BOOKMANAGER_HPP
+
+#include "MPSCQueue.hpp"
+#include "../Process_Orders/Command.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Book;
+
+// Owns one book per symbol and routes commands to them by symbolId.
+// Books are partitioned across matching threads (shards); each shard applies commands only
+// to the books it owns, so no book is ever touched by two threads.
+//
+// Books can be migrated between shards while running. The routing thread sends a handoff
+// marker down the old shard's queue and routes new commands to the new shard. The new shard
+// parks commands for the book until the old shard reaches the marker and passes ownership on,
+// so the book itself is handed over without copying any order state.
+class BookManager {
+private:
+    struct ShardRequest {
+        std::int64_t submitTime;
+        int handoffShard;
+        Command command;
+    };
+
+    struct Shard {
+        MPSCQueue<ShardRequest> queue;
+        std::thread thread;
+        std::uint64_t processedCount;
+        std::vector<std::int64_t> latencies;
+        std::unordered_map<int, std::vector<ShardRequest>> parkedRequests;
+
+        Shard(std::size_t queueCapacity) : queue(queueCapacity), processedCount(0) {}
+    };
+
+    struct ManagedBook {
+        std::string symbol;
+        Book* book;
+        int shard;
+        std::atomic<int> activeShard;
+        std::uint64_t submittedCount;
+
+        ManagedBook(const std::string& _symbol, int _shard)
+            : symbol(_symbol), book(nullptr), shard(_shard), activeShard(_shard), submittedCount(0) {}
+    };
+
+    std::vector<ManagedBook*> books;
+    std::unordered_map<std::string, int> symbolIds;
+    std::vector<Shard*> shards;
+    std::atomic<bool> running;
+    bool recordLatencies;
+
+    std::uint64_t rebalanceInterval;
+    std::uint64_t submittedSinceRebalance;
+    int maxMigrationsPerRebalance;
+    std::uint64_t migrationCount;
+
+    void shardLoop(int shardIndex);
+    std::size_t processShard(int shardIndex);
+    void processRequest(int shardIndex, const ShardRequest& request);
+    void pushToShard(int shardIndex, const ShardRequest& request);
+
+public:
+    BookManager(int numberOfShards, std::size_t queueCapacity=65536);
+    ~BookManager();
+
+    // Symbols must be added before the matching threads are started
+    int addSymbol(const std::string& symbol);
+    int getSymbolId(const std::string& symbol) const;
+    const std::string& getSymbol(int symbolId) const;
+    Book* getBook(int symbolId) const;
+    int getShard(int symbolId) const;
+    int getNumberOfSymbols() const;
+    int getNumberOfShards() const;
+
+    void start();
+    void stop();
+
+    // Route a command to the shard owning its symbol, must be called from a single thread.
+    // Both return false without doing anything for a symbolId that was never added.
+    bool submit(const Command& command);
+    // Apply a command directly on the calling thread, for use while the shards are stopped
+    bool apply(const Command& command);
+
+    // Rebalancing runs on the routing thread between submits. An interval of 0 disables the
+    // automatic rebalance, rebalance() and migrate() can still be called from the routing thread.
+    void setRebalanceInterval(std::uint64_t interval, int maxMigrations=4);
+    int rebalance();
+    bool migrate(int symbolId, int newShard);
+    bool isHandoffPending(int symbolId) const;
+    std::uint64_t getMigrationCount() const;
+
+    // Submit to completion latencies in nanoseconds and shard counters, read once the shards are stopped
+    void setRecordLatencies(bool record);
+    std::vector<std::int64_t> getLatencies() const;
+    std::uint64_t getProcessedCount(int shardIndex) const;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MPSCQUEUE_HPP
+#define MPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer/single-consumer ring buffer.
+// Producers claim a ticket with a CAS on the tail, so the consumer sees items in ticket
+// (arrival) order. Each slot carries a sequence number telling producers and the consumer
+// whether it is free or holds a published item.
+template <typename T>
+class MPSCQueue {
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask;
+
+    alignas(64) std::atomic<std::uint64_t> tail;
+    alignas(64) std::uint64_t head;
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit MPSCQueue(std::size_t capacity) : tail(0), head(0)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        slots = std::make_unique<Slot[]>(size);
+        mask = size - 1;
+        for (std::size_t i = 0; i < size; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    // Safe to call from any number of threads. Returns false if the queue is full.
+    bool tryPush(const T& value)
+    {
+        std::uint64_t position = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = slots[position & mask];
+            std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::int64_t difference = static_cast<std::int64_t>(sequence) - static_cast<std::int64_t>(position);
+            if (difference == 0)
+            {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0)
+            {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only the single consumer thread may call this. Returns false if nothing is published yet.
+    bool tryPop(T& value)
+    {
+        Slot& slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+        {
+            return false;
+        }
+        value = slot.value;
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        head += 1;
+        return true;
+    }
+
+    std::size_t capacity() const
+    {
+        return mask + 1;
+    }
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "OrderGateway.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Persistence/CommandJournal.hpp"
+
+#include <chrono>
+
+static std::int64_t nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ClientSession::ClientSession(int _clientId, MPSCQueue<GatewayRequest>* _queue)
+    : clientId(_clientId), queue(_queue), nextSequence(1), completedSequence(0) {}
+
+int ClientSession::getClientId() const
+{
+    return clientId;
+}
+
+std::uint64_t ClientSession::getCompletedSequence() const
+{
+    return completedSequence.load(std::memory_order_acquire);
+}
+
+// Enqueue a command, spinning while the queue is full, and return its client sequence number
+std::uint64_t ClientSession::submit(const Command& command)
+{
+    GatewayRequest request{clientId, nextSequence, nowNanoseconds(), command};
+    while (!queue->tryPush(request))
+    {
+        std::this_thread::yield();
+    }
+    return nextSequence++;
+}
+
+// Commands from one client are applied in order, so a single watermark covers all of them
+bool ClientSession::isComplete(std::uint64_t clientSequence) const
+{
+    return completedSequence.load(std::memory_order_acquire) >= clientSequence;
+}
+
+void ClientSession::waitFor(std::uint64_t clientSequence) const
+{
+    while (!isComplete(clientSequence))
+    {
+        std::this_thread::yield();
+    }
+}
+
+OrderGateway::OrderGateway(Book* _book, std::size_t queueCapacity)
+    : book(_book), journal(nullptr), queue(queueCapacity), running(false), recordLatencies(false) {}
+
+OrderGateway::~OrderGateway()
+{
+    stop();
+    for (ClientSession* session : sessions)
+    {
+        delete session;
+    }
+    sessions.clear();
+}
+
+ClientSession* OrderGateway::connect()
+{
+    ClientSession* session = new ClientSession(sessions.size(), &queue);
+    sessions.push_back(session);
+    return session;
+}
+
+void OrderGateway::start()
+{
+    if (!running.exchange(true))
+    {
+        matchingThread = std::thread(&OrderGateway::matchingLoop, this);
+    }
+}
+
+// Stop the matching thread once everything already submitted has been applied
+void OrderGateway::stop()
+{
+    if (running.exchange(false))
+    {
+        matchingThread.join();
+    }
+}
+
+// Apply every published command on the calling thread, returns how many were applied
+std::size_t OrderGateway::processPending()
+{
+    std::size_t processed = 0;
+    GatewayRequest request;
+    while (queue.tryPop(request))
+    {
+        if (journal != nullptr)
+        {
+            journal->append(request.command);
+        }
+        applyCommand(book, request.command);
+        sessions[request.clientId]->completedSequence.store(request.clientSequence, std::memory_order_release);
+        if (recordLatencies)
+        {
+            latencies.push_back(nowNanoseconds() - request.submitTime);
+        }
+        processed += 1;
+    }
+    return processed;
+}
+
+void OrderGateway::matchingLoop()
+{
+    while (running.load(std::memory_order_acquire))
+    {
+        if (processPending() == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    processPending();
+}
+
+void OrderGateway::setJournal(CommandJournal* _journal)
+{
+    journal = _journal;
+}
+
+void OrderGateway::setRecordLatencies(bool record)
+{
+    recordLatencies = record;
+}
+
+const std::vector<std::int64_t>& OrderGateway::getLatencies() const
+{
+    return latencies;
+}
@@ -0,0 +1,78 @@
+#ifndef ORDERGATEWAY_HPP
+#define ORDERGATEWAY_HPP
+
+#include "MPSCQueue.hpp"
+#include "../Process_Orders/Command.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+class Book;
+class CommandJournal;
+
+// A command as it travels from a client thread to the matching thread
+struct GatewayRequest {
+    int clientId;
+    std::uint64_t clientSequence;
+    std::int64_t submitTime;
+    Command command;
+};
+
+// Handle owned by a single client thread. Sequence numbers are assigned per client in submit
+// order, and the matching thread publishes the last one it has applied.
+class ClientSession {
+private:
+    int clientId;
+    MPSCQueue<GatewayRequest>* queue;
+    std::uint64_t nextSequence;
+    alignas(64) std::atomic<std::uint64_t> completedSequence;
+
+    friend class OrderGateway;
+public:
+    ClientSession(int _clientId, MPSCQueue<GatewayRequest>* _queue);
+
+    int getClientId() const;
+    std::uint64_t getCompletedSequence() const;
+
+    std::uint64_t submit(const Command& command);
+    bool isComplete(std::uint64_t clientSequence) const;
+    void waitFor(std::uint64_t clientSequence) const;
+};
+
+// Order entry gateway in front of a single-threaded book. Any number of client threads submit
+// through their sessions and one matching thread applies the commands in arrival order.
+class OrderGateway {
+private:
+    Book* book;
+    CommandJournal* journal;
+    MPSCQueue<GatewayRequest> queue;
+    std::vector<ClientSession*> sessions;
+    std::thread matchingThread;
+    std::atomic<bool> running;
+
+    bool recordLatencies;
+    std::vector<std::int64_t> latencies;
+
+    void matchingLoop();
+
+public:
+    OrderGateway(Book* _book, std::size_t queueCapacity=65536);
+    ~OrderGateway();
+
+    // Sessions must be connected before the matching thread is started
+    ClientSession* connect();
+    void start();
+    void stop();
+    std::size_t processPending();
+
+    // Journal every command on the matching thread before it is applied, set before start
+    void setJournal(CommandJournal* _journal);
+
+    // Submit to completion latencies in nanoseconds, used by the gateway benchmark
+    void setRecordLatencies(bool record);
+    const std::vector<std::int64_t>& getLatencies() const;
+};
+
+#endif
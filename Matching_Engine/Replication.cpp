@@ -0,0 +1,271 @@
+#include "Replication.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Replication ring needs lock-free atomics shared between processes");
+
+static const char replicationMagic[8] = {'L', 'O', 'B', 'R', 'E', 'P', 'L', '1'};
+
+struct ReplicationRingHeader {
+    char magic[8];
+    std::uint64_t capacity;
+    alignas(64) std::atomic<std::uint64_t> writeIndex;
+    alignas(64) std::atomic<std::uint64_t> readIndex;
+    alignas(64) std::atomic<bool> finished;
+    std::atomic<std::uint64_t> hashChecks;
+    std::atomic<std::uint64_t> hashMismatches;
+    std::atomic<std::uint64_t> firstMismatchSequence;
+};
+
+static std::size_t recordsOffset()
+{
+    return (sizeof(ReplicationRingHeader) + 63) & ~std::size_t(63);
+}
+
+ReplicationRing::ReplicationRing() : header(nullptr), records(nullptr), mappedSize(0), owner(false) {}
+
+ReplicationRing::~ReplicationRing()
+{
+    close();
+}
+
+bool ReplicationRing::create(const std::string& _name, std::size_t capacity)
+{
+    close();
+    std::size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    mappedSize = recordsOffset() + size * sizeof(ReplicationRecord);
+
+    int fd = shm_open(_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, mappedSize) != 0)
+    {
+        std::cerr << "Error creating replication ring: " << _name << std::endl;
+        if (fd >= 0)
+        {
+            ::close(fd);
+            shm_unlink(_name.c_str());
+        }
+        return false;
+    }
+    void* region = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED)
+    {
+        std::cerr << "Error mapping replication ring: " << _name << std::endl;
+        shm_unlink(_name.c_str());
+        return false;
+    }
+
+    header = new (region) ReplicationRingHeader();
+    header->capacity = size;
+    header->writeIndex.store(0);
+    header->readIndex.store(0);
+    header->finished.store(false);
+    header->hashChecks.store(0);
+    header->hashMismatches.store(0);
+    header->firstMismatchSequence.store(0);
+    records = reinterpret_cast<ReplicationRecord*>(static_cast<char*>(region) + recordsOffset());
+    // Publish the magic last so a standby never attaches to a half initialised ring
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, replicationMagic, sizeof(replicationMagic));
+    owner = true;
+    name = _name;
+    return true;
+}
+
+bool ReplicationRing::attach(const std::string& _name)
+{
+    close();
+    int fd = shm_open(_name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+    {
+        std::cerr << "Error opening replication ring: " << _name << std::endl;
+        return false;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    void* region = size > 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (region == MAP_FAILED)
+    {
+        std::cerr << "Error mapping replication ring: " << _name << std::endl;
+        return false;
+    }
+    header = static_cast<ReplicationRingHeader*>(region);
+    mappedSize = size;
+    if (std::memcmp(header->magic, replicationMagic, sizeof(replicationMagic)) != 0)
+    {
+        std::cerr << "Invalid replication ring: " << _name << std::endl;
+        close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    records = reinterpret_cast<ReplicationRecord*>(static_cast<char*>(region) + recordsOffset());
+    owner = false;
+    name = _name;
+    return true;
+}
+
+void ReplicationRing::close()
+{
+    if (header != nullptr)
+    {
+        munmap(header, mappedSize);
+        header = nullptr;
+        records = nullptr;
+    }
+    if (owner)
+    {
+        shm_unlink(name.c_str());
+        owner = false;
+    }
+}
+
+void ReplicationRing::publish(const ReplicationRecord& record)
+{
+    std::uint64_t index = header->writeIndex.load(std::memory_order_relaxed);
+    while (index - header->readIndex.load(std::memory_order_acquire) >= header->capacity)
+    {
+        std::this_thread::yield();
+    }
+    records[index & (header->capacity - 1)] = record;
+    header->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void ReplicationRing::finish()
+{
+    header->finished.store(true, std::memory_order_release);
+}
+
+bool ReplicationRing::tryConsume(ReplicationRecord& record)
+{
+    std::uint64_t index = header->readIndex.load(std::memory_order_relaxed);
+    if (index == header->writeIndex.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    record = records[index & (header->capacity - 1)];
+    header->readIndex.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+bool ReplicationRing::isFinished() const
+{
+    return header->finished.load(std::memory_order_acquire);
+}
+
+void ReplicationRing::recordHashCheck(bool matched, std::uint64_t sequenceNumber)
+{
+    header->hashChecks.fetch_add(1, std::memory_order_relaxed);
+    if (!matched && header->hashMismatches.fetch_add(1, std::memory_order_relaxed) == 0)
+    {
+        header->firstMismatchSequence.store(sequenceNumber, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t ReplicationRing::getHashChecks() const
+{
+    return header->hashChecks.load(std::memory_order_relaxed);
+}
+
+std::uint64_t ReplicationRing::getHashMismatches() const
+{
+    return header->hashMismatches.load(std::memory_order_relaxed);
+}
+
+std::uint64_t ReplicationRing::getFirstMismatchSequence() const
+{
+    return header->firstMismatchSequence.load(std::memory_order_relaxed);
+}
+
+ReplicationPrimary::ReplicationPrimary(Book* _book, ReplicationRing* _ring, std::uint64_t _hashInterval)
+    : book(_book), ring(_ring), hashInterval(_hashInterval), sequenceNumber(0)
+{
+    if (hashInterval == 0)
+    {
+        throw std::invalid_argument("Replication hash interval must be at least 1");
+    }
+}
+
+// The record goes out after the command is applied, so the attached hash is the state after it
+void ReplicationPrimary::apply(const Command& command)
+{
+    applyCommand(book, command);
+    sequenceNumber += 1;
+    bool hashCheck = sequenceNumber % hashInterval == 0;
+    ring->publish(ReplicationRecord{sequenceNumber, hashCheck ? book->getStateHash() : 0, hashCheck, command});
+}
+
+std::uint64_t ReplicationPrimary::getSequenceNumber() const
+{
+    return sequenceNumber;
+}
+
+StandbyReplica::StandbyReplica(Book* _book, ReplicationRing* _ring)
+    : book(_book), ring(_ring), sequenceNumber(0), primary(false) {}
+
+std::size_t StandbyReplica::poll()
+{
+    std::size_t applied = 0;
+    ReplicationRecord record;
+    while (!primary && ring->tryConsume(record))
+    {
+        if (record.sequenceNumber != sequenceNumber + 1)
+        {
+            std::cerr << "Replication gap after sequence " << sequenceNumber << std::endl;
+        }
+        applyCommand(book, record.command);
+        sequenceNumber = record.sequenceNumber;
+        if (record.hasStateHash)
+        {
+            ring->recordHashCheck(book->getStateHash() == record.stateHash, sequenceNumber);
+        }
+        applied += 1;
+    }
+    return applied;
+}
+
+// Sleeps briefly when the ring is empty so an idle standby does not compete with the primary for CPU
+void StandbyReplica::run(const std::atomic<bool>& stop)
+{
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        bool finished = ring->isFinished();
+        if (poll() == 0)
+        {
+            if (finished)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+Book* StandbyReplica::promote()
+{
+    poll();
+    primary = true;
+    return book;
+}
+
+bool StandbyReplica::isPrimary() const
+{
+    return primary;
+}
+
+std::uint64_t StandbyReplica::getSequenceNumber() const
+{
+    return sequenceNumber;
+}
@@ -0,0 +1,101 @@
+#ifndef REPLICATION_HPP
+#define REPLICATION_HPP
+
+#include "../Process_Orders/Command.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Book;
+
+// One sequenced command from the primary. Every hash interval the primary also attaches its
+// state hash after applying the command, so the standby can check it has the same book.
+struct ReplicationRecord {
+    std::uint64_t sequenceNumber;
+    std::uint64_t stateHash;
+    bool hasStateHash;
+    Command command;
+};
+
+struct ReplicationRingHeader;
+
+// Single-producer/single-consumer ring of replication records in POSIX shared memory, so the
+// primary and standby can be separate processes on the same machine. The primary creates the
+// ring and the standby attaches to it by name.
+class ReplicationRing {
+private:
+    ReplicationRingHeader* header;
+    ReplicationRecord* records;
+    std::size_t mappedSize;
+    bool owner;
+    std::string name;
+
+public:
+    ReplicationRing();
+    ~ReplicationRing();
+
+    ReplicationRing(const ReplicationRing&) = delete;
+    ReplicationRing& operator=(const ReplicationRing&) = delete;
+
+    // Capacity is rounded up to a power of two
+    bool create(const std::string& _name, std::size_t capacity);
+    bool attach(const std::string& _name);
+    // Unmaps the ring, the creator also removes the shared memory object
+    void close();
+
+    // Producer side. Waits while the ring is full, so a stalled standby applies back pressure.
+    void publish(const ReplicationRecord& record);
+    // Tells the standby no more records will follow
+    void finish();
+
+    // Consumer side
+    bool tryConsume(ReplicationRecord& record);
+    bool isFinished() const;
+    // Hash checks the standby has passed and failed, readable from either process
+    void recordHashCheck(bool matched, std::uint64_t sequenceNumber);
+    std::uint64_t getHashChecks() const;
+    std::uint64_t getHashMismatches() const;
+    std::uint64_t getFirstMismatchSequence() const;
+};
+
+// Applies commands to the primary book and streams them to the standby
+class ReplicationPrimary {
+private:
+    Book* book;
+    ReplicationRing* ring;
+    std::uint64_t hashInterval;
+    std::uint64_t sequenceNumber;
+
+public:
+    // Throws std::invalid_argument for a hash interval of 0
+    ReplicationPrimary(Book* _book, ReplicationRing* _ring, std::uint64_t _hashInterval=1024);
+
+    void apply(const Command& command);
+    std::uint64_t getSequenceNumber() const;
+};
+
+// Keeps a hot copy of the primary's book by applying the replicated stream. Failover is a
+// role switch: promote() applies whatever is left in the ring and hands over the live book.
+class StandbyReplica {
+private:
+    Book* book;
+    ReplicationRing* ring;
+    std::uint64_t sequenceNumber;
+    bool primary;
+
+public:
+    StandbyReplica(Book* _book, ReplicationRing* _ring);
+
+    // Applies every record currently in the ring, returning how many were applied
+    std::size_t poll();
+    // Polls until the primary finishes the stream or stop is set
+    void run(const std::atomic<bool>& stop);
+    Book* promote();
+
+    bool isPrimary() const;
+    std::uint64_t getSequenceNumber() const;
+};
+
+#endif
@@ -0,0 +1,357 @@
+#include "CommandJournal.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char journalMagic[8] = {'L', 'O', 'B', 'J', 'R', 'N', 'L', '\0'};
+// Bumped whenever Command's layout, its command types or what a command does on replay changes.
+// 2: symbolId, timestamp and ownerId fields, command types up to AuctionEnd, and ModifyLimit
+//    keeping queue priority when it only reduces shares at the same price.
+static const std::uint32_t journalVersion = 2;
+// Trips when Command's size changes, as a reminder to bump journalVersion. Type or meaning
+// changes that keep the size are not caught and have to be bumped by hand.
+static_assert(sizeof(Command) == 32, "Command changed, bump journalVersion");
+
+static JournalHeader journalHeader()
+{
+    JournalHeader header{};
+    std::memcpy(header.magic, journalMagic, sizeof(journalMagic));
+    header.version = journalVersion;
+    header.recordSize = sizeof(JournalRecord);
+    return header;
+}
+
+static bool validHeader(const JournalHeader& header)
+{
+    return std::memcmp(header.magic, journalMagic, sizeof(journalMagic)) == 0 && header.version == journalVersion
+        && header.recordSize == sizeof(JournalRecord);
+}
+
+// FNV-1a over the record's fields rather than its bytes, so struct padding never affects it
+static std::uint32_t recordChecksum(const JournalRecord& record)
+{
+    const Command& command = record.command;
+    std::uint32_t hash = 2166136261u;
+    for (std::uint64_t value : {record.sequenceNumber, std::uint64_t(command.type), std::uint64_t(command.buyOrSell),
+        std::uint64_t(std::uint32_t(command.orderId)), std::uint64_t(std::uint32_t(command.shares)),
+        std::uint64_t(std::uint32_t(command.limitPrice)), std::uint64_t(std::uint32_t(command.stopPrice)),
+        std::uint64_t(std::uint32_t(command.symbolId)), std::uint64_t(std::uint32_t(command.timestamp)),
+        std::uint64_t(std::uint32_t(command.ownerId))})
+    {
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            hash = (hash ^ ((value >> shift) & 0xff)) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+CommandJournal::CommandJournal(std::size_t capacity)
+    : fd(-1), nextSequence(1), appendIndex(0), durableIndex(0), durableSequence(0),
+    groupCommitCount(0), failed(false), running(false)
+{
+    std::size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    ring = std::make_unique<JournalRecord[]>(size);
+    mask = size - 1;
+}
+
+CommandJournal::~CommandJournal()
+{
+    close();
+}
+
+bool CommandJournal::open(const std::string& filename, bool truncate)
+{
+    close();
+
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Error opening journal file: " << filename << std::endl;
+        return false;
+    }
+
+    // A new file, or one whose header was torn by a crash, starts over with a fresh header.
+    // An existing header must match this build's record layout.
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+    if (fileSize < static_cast<off_t>(sizeof(JournalHeader)))
+    {
+        JournalHeader header = journalHeader();
+        if ((fileSize > 0 && ftruncate(fd, 0) != 0) || ::write(fd, &header, sizeof(header)) != sizeof(header) || fdatasync(fd) != 0)
+        {
+            std::cerr << "Error writing journal header: " << filename << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        fileSize = sizeof(header);
+    } else {
+        JournalHeader header;
+        if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || !validHeader(header))
+        {
+            std::cerr << "Journal header does not match this build: " << filename << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+
+    // Drop any torn record left at the end by a crash so new records stay aligned, along with
+    // trailing records whose checksums fail, as replay would stop at them. Numbering then
+    // continues after the last record replay will apply.
+    off_t completeSize = fileSize - (fileSize - sizeof(JournalHeader)) % sizeof(JournalRecord);
+    nextSequence = 1;
+    JournalRecord lastRecord;
+    while (completeSize > static_cast<off_t>(sizeof(JournalHeader))
+        && pread(fd, &lastRecord, sizeof(lastRecord), completeSize - sizeof(JournalRecord)) == sizeof(lastRecord))
+    {
+        if (lastRecord.checksum == recordChecksum(lastRecord))
+        {
+            nextSequence = lastRecord.sequenceNumber + 1;
+            break;
+        }
+        std::cerr << "Dropping corrupt journal record at the end of " << filename << std::endl;
+        completeSize -= sizeof(JournalRecord);
+    }
+    if (completeSize != fileSize && ftruncate(fd, completeSize) != 0)
+    {
+        std::cerr << "Error truncating torn journal record" << std::endl;
+    }
+
+    failed.store(false);
+    appendIndex.store(0);
+    durableIndex.store(0);
+    durableSequence.store(nextSequence - 1);
+    running.store(true);
+    writerThread = std::thread(&CommandJournal::writerLoop, this);
+    return true;
+}
+
+void CommandJournal::close()
+{
+    if (running.exchange(false))
+    {
+        writerThread.join();
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// The ring only holds records that are not yet durable, so a full ring is the one case where
+// the matching thread has to wait for the disk. The writer fills in the checksum.
+std::uint64_t CommandJournal::append(const Command& command)
+{
+    std::uint64_t index = appendIndex.load(std::memory_order_relaxed);
+    while (index - durableIndex.load(std::memory_order_acquire) > mask)
+    {
+        if (failed.load(std::memory_order_acquire))
+        {
+            return 0;
+        }
+        std::this_thread::yield();
+    }
+    if (failed.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+    ring[index & mask] = JournalRecord{nextSequence, command, 0};
+    appendIndex.store(index + 1, std::memory_order_release);
+    return nextSequence++;
+}
+
+std::uint64_t CommandJournal::getDurableSequence() const
+{
+    return durableSequence.load(std::memory_order_acquire);
+}
+
+bool CommandJournal::waitForDurable(std::uint64_t sequenceNumber) const
+{
+    while (getDurableSequence() < sequenceNumber)
+    {
+        if (failed.load(std::memory_order_acquire))
+        {
+            return getDurableSequence() >= sequenceNumber;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+std::uint64_t CommandJournal::getGroupCommitCount() const
+{
+    return groupCommitCount.load(std::memory_order_relaxed);
+}
+
+bool CommandJournal::hasFailed() const
+{
+    return failed.load(std::memory_order_acquire);
+}
+
+// Write ring entries [start, end), split in two if the range wraps around the ring
+bool CommandJournal::writeRecords(std::uint64_t start, std::uint64_t end)
+{
+    while (start != end)
+    {
+        std::size_t first = start & mask;
+        std::size_t count = std::min<std::uint64_t>(end - start, mask + 1 - first);
+        for (std::size_t i = first; i < first + count; i++)
+        {
+            ring[i].checksum = recordChecksum(ring[i]);
+        }
+        const char* data = reinterpret_cast<const char*>(&ring[first]);
+        std::size_t remaining = count * sizeof(JournalRecord);
+        while (remaining > 0)
+        {
+            ssize_t written = ::write(fd, data, remaining);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                std::cerr << "Error writing journal" << std::endl;
+                return false;
+            }
+            data += written;
+            remaining -= written;
+        }
+        start += count;
+    }
+    return true;
+}
+
+void CommandJournal::writerLoop()
+{
+    while (true)
+    {
+        bool stopping = !running.load(std::memory_order_acquire);
+        std::uint64_t start = durableIndex.load(std::memory_order_relaxed);
+        std::uint64_t end = appendIndex.load(std::memory_order_acquire);
+        if (start == end)
+        {
+            if (stopping)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+
+        // Everything appended so far goes out in one group commit, and only counts as durable
+        // once both the write and the sync have succeeded
+        if (!writeRecords(start, end))
+        {
+            failed.store(true, std::memory_order_release);
+            return;
+        }
+        if (fdatasync(fd) != 0)
+        {
+            std::cerr << "Error syncing journal" << std::endl;
+            failed.store(true, std::memory_order_release);
+            return;
+        }
+        durableSequence.store(ring[(end - 1) & mask].sequenceNumber, std::memory_order_release);
+        durableIndex.store(end, std::memory_order_release);
+        groupCommitCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static bool readHeader(std::ifstream& file, const std::string& filename)
+{
+    JournalHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !validHeader(header))
+    {
+        std::cerr << "Invalid journal header: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Number of leading records whose checksums match
+static std::size_t validRecords(const JournalRecord* records, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (records[i].checksum != recordChecksum(records[i]))
+        {
+            std::cerr << "Corrupt journal record after sequence " << (i > 0 ? records[i - 1].sequenceNumber : 0) << std::endl;
+            return i;
+        }
+    }
+    return count;
+}
+
+// Read every complete record in a journal file, ignoring a torn record at the end
+std::vector<JournalRecord> CommandJournal::readJournal(const std::string& filename)
+{
+    std::vector<JournalRecord> records;
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return records;
+    }
+    std::size_t size = file.tellg();
+    file.seekg(0);
+    if (size < sizeof(JournalHeader) || !readHeader(file, filename))
+    {
+        return records;
+    }
+    records.resize((size - sizeof(JournalHeader)) / sizeof(JournalRecord));
+    file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(JournalRecord));
+    records.resize(validRecords(records.data(), records.size()));
+    return records;
+}
+
+std::uint64_t recoverBook(Book* book, const std::string& snapshotFile, const std::string& journalFile)
+{
+    std::uint64_t lastSequence = 0;
+    std::ifstream snapshot(snapshotFile);
+    if (snapshot.good())
+    {
+        snapshot.close();
+        if (!book->loadSnapshot(snapshotFile, &lastSequence))
+        {
+            lastSequence = 0;
+        }
+    }
+
+    // Stream the journal in blocks rather than holding millions of records in memory
+    std::ifstream journal(journalFile, std::ios::binary);
+    if (!journal.is_open() || !readHeader(journal, journalFile))
+    {
+        return lastSequence;
+    }
+    std::vector<JournalRecord> records(65536);
+    while (journal)
+    {
+        journal.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(JournalRecord));
+        std::size_t complete = journal.gcount() / sizeof(JournalRecord);
+        std::size_t count = validRecords(records.data(), complete);
+        if (count != complete)
+        {
+            journal.setstate(std::ios::failbit);
+        }
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].sequenceNumber > lastSequence)
+            {
+                applyCommand(book, records[i].command);
+                lastSequence = records[i].sequenceNumber;
+            }
+        }
+    }
+    return lastSequence;
+}
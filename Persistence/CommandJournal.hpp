@@ -0,0 +1,84 @@
+#ifndef COMMANDJOURNAL_HPP
+#define COMMANDJOURNAL_HPP
+
+#include "../Process_Orders/Command.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Book;
+
+// One sequenced input command as stored in the journal file, with a checksum over its fields
+struct JournalRecord {
+    std::uint64_t sequenceNumber;
+    Command command;
+    std::uint32_t checksum;
+};
+
+// Written once at the start of the file. The version must be bumped whenever Command's layout,
+// its command types or their meaning on replay change, so a journal written by another build is
+// rejected rather than replayed.
+struct JournalHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+};
+
+// Append-only write-ahead journal of the commands applied to a book.
+// The matching thread appends records into an in-memory ring and carries on. A dedicated
+// writer thread drains everything appended since its last pass with one write and one
+// fdatasync (group commit), then publishes the highest durable sequence number. If a write or
+// sync fails the journal is marked failed, the durable sequence stops advancing and the writer exits.
+class CommandJournal {
+private:
+    int fd;
+    std::unique_ptr<JournalRecord[]> ring;
+    std::size_t mask;
+    std::uint64_t nextSequence;
+
+    alignas(64) std::atomic<std::uint64_t> appendIndex;
+    alignas(64) std::atomic<std::uint64_t> durableIndex;
+    std::atomic<std::uint64_t> durableSequence;
+    std::atomic<std::uint64_t> groupCommitCount;
+    std::atomic<bool> failed;
+
+    std::thread writerThread;
+    std::atomic<bool> running;
+
+    void writerLoop();
+    bool writeRecords(std::uint64_t start, std::uint64_t end);
+
+public:
+    CommandJournal(std::size_t capacity=1 << 20);
+    ~CommandJournal();
+
+    // Opens the journal for appending and starts the writer thread. Sequence numbers continue
+    // after the last complete record already in the file whose checksum matches.
+    bool open(const std::string& filename, bool truncate=false);
+    // Waits for everything appended to become durable, then stops the writer thread
+    void close();
+
+    // Called by the matching thread only, returns the command's sequence number, or 0 once the
+    // journal has failed
+    std::uint64_t append(const Command& command);
+    std::uint64_t getDurableSequence() const;
+    // Returns false if the journal failed before the sequence number became durable
+    bool waitForDurable(std::uint64_t sequenceNumber) const;
+    std::uint64_t getGroupCommitCount() const;
+    bool hasFailed() const;
+
+    // Reads every valid record, stopping at a torn or corrupt record. A file without a matching
+    // header yields no records.
+    static std::vector<JournalRecord> readJournal(const std::string& filename);
+};
+
+// Rebuild a book from the latest snapshot (if the file exists) plus the journal records after
+// it, returning the sequence number of the last command applied. Replay stops at the first
+// corrupt record, and a journal with a mismatched header is not replayed at all.
+std::uint64_t recoverBook(Book* book, const std::string& snapshotFile, const std::string& journalFile);
+
+#endif
@@ -0,0 +1,123 @@
+#include "ForkCheckpointer.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+static std::int64_t checkpointNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ForkCheckpointer::ForkCheckpointer()
+    : child(-1), startTime(0), lastForkTime(0), lastDuration(0), lastSize(0), lastSequence(0),
+    lastSucceeded(false), checkpointCount(0) {}
+
+ForkCheckpointer::~ForkCheckpointer()
+{
+    wait();
+}
+
+bool ForkCheckpointer::start(const Book* book, const std::string& _filename, std::uint64_t sequenceNumber)
+{
+    if (isRunning())
+    {
+        return false;
+    }
+    startTime = checkpointNanoseconds();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "Unable to fork checkpoint process" << std::endl;
+        return false;
+    }
+    if (pid == 0)
+    {
+        // The child only writes the snapshot, then exits without running the parent's destructors
+        std::string temporary = _filename + ".tmp";
+        bool saved = book->saveSnapshot(temporary, sequenceNumber) && std::rename(temporary.c_str(), _filename.c_str()) == 0;
+        _exit(saved ? 0 : 1);
+    }
+    lastForkTime = checkpointNanoseconds() - startTime;
+    child = pid;
+    filename = _filename;
+    lastSequence = sequenceNumber;
+    return true;
+}
+
+void ForkCheckpointer::finish(int status)
+{
+    child = -1;
+    lastDuration = checkpointNanoseconds() - startTime;
+    lastSucceeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    struct stat fileStatus;
+    lastSize = lastSucceeded && stat(filename.c_str(), &fileStatus) == 0 ? fileStatus.st_size : 0;
+    if (!lastSucceeded)
+    {
+        std::cerr << "Checkpoint to " << filename << " failed" << std::endl;
+    }
+    checkpointCount += 1;
+}
+
+bool ForkCheckpointer::poll()
+{
+    if (!isRunning())
+    {
+        return true;
+    }
+    int status;
+    if (waitpid(child, &status, WNOHANG) == child)
+    {
+        finish(status);
+        return true;
+    }
+    return false;
+}
+
+void ForkCheckpointer::wait()
+{
+    int status;
+    if (isRunning() && waitpid(child, &status, 0) == child)
+    {
+        finish(status);
+    }
+}
+
+bool ForkCheckpointer::isRunning() const
+{
+    return child > 0;
+}
+
+bool ForkCheckpointer::getLastSucceeded() const
+{
+    return lastSucceeded;
+}
+
+std::int64_t ForkCheckpointer::getLastForkNanoseconds() const
+{
+    return lastForkTime;
+}
+
+std::int64_t ForkCheckpointer::getLastDurationNanoseconds() const
+{
+    return lastDuration;
+}
+
+std::uint64_t ForkCheckpointer::getLastSize() const
+{
+    return lastSize;
+}
+
+std::uint64_t ForkCheckpointer::getLastSequenceNumber() const
+{
+    return lastSequence;
+}
+
+int ForkCheckpointer::getCheckpointCount() const
+{
+    return checkpointCount;
+}
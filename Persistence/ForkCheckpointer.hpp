@@ -0,0 +1,49 @@
+#ifndef FORKCHECKPOINTER_HPP
+#define FORKCHECKPOINTER_HPP
+
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+
+class Book;
+
+// Background snapshots of a book taken by a forked child process.
+// start() forks at a command boundary and the child writes the snapshot from its copy-on-write
+// view of the book while the parent carries on matching, paying only for the fork itself and
+// for the page faults on pages it writes while the child is running. The snapshot is written
+// to a temporary file and renamed into place, so a failed checkpoint never replaces a good one.
+// Call start() from the thread that owns the book so the child sees it between commands.
+class ForkCheckpointer {
+private:
+    pid_t child;
+    std::string filename;
+    std::int64_t startTime;
+    std::int64_t lastForkTime;
+    std::int64_t lastDuration;
+    std::uint64_t lastSize;
+    std::uint64_t lastSequence;
+    bool lastSucceeded;
+    int checkpointCount;
+
+    void finish(int status);
+
+public:
+    ForkCheckpointer();
+    ~ForkCheckpointer();
+
+    // Returns false if a checkpoint is already running or the fork fails
+    bool start(const Book* book, const std::string& _filename, std::uint64_t sequenceNumber=0);
+    // Reaps the child without blocking, returns true once no checkpoint is running
+    bool poll();
+    void wait();
+    bool isRunning() const;
+
+    bool getLastSucceeded() const;
+    std::int64_t getLastForkNanoseconds() const;
+    std::int64_t getLastDurationNanoseconds() const;
+    std::uint64_t getLastSize() const;
+    std::uint64_t getLastSequenceNumber() const;
+    int getCheckpointCount() const;
+};
+
+#endif
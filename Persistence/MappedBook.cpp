@@ -0,0 +1,180 @@
+#include "MappedBook.hpp"
+#include "../Limit_Order_Book/Arena.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+static const char mappedBookMagic[8] = {'L', 'O', 'B', 'M', 'A', 'P', '0', '2'};
+
+// Stored at the start of the file, followed by the arena's allocations
+struct MappedBookHeader {
+    char magic[8];
+    std::uint64_t baseAddress;
+    std::uint64_t capacity;
+    // Guards against reopening a file written by a build with a different Book layout
+    std::uint64_t bookSize;
+    std::uint64_t cleanShutdown;
+    std::uint64_t sequenceNumber;
+    Book* book;
+    Arena arena;
+};
+
+static std::size_t arenaOffset()
+{
+    return (sizeof(MappedBookHeader) + 63) & ~std::size_t(63);
+}
+
+MappedBook::MappedBook() : fd(-1), header(nullptr), mappedSize(0) {}
+
+MappedBook::~MappedBook()
+{
+    close();
+}
+
+bool MappedBook::map(const std::string& filename, std::uintptr_t baseAddress, std::size_t capacity)
+{
+    void* region = mmap(reinterpret_cast<void*>(baseAddress), capacity, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_FIXED_NOREPLACE | MAP_NORESERVE, fd, 0);
+    if (region == MAP_FAILED || region != reinterpret_cast<void*>(baseAddress))
+    {
+        if (region != MAP_FAILED)
+        {
+            munmap(region, capacity);
+        }
+        std::cerr << "Unable to map book file " << filename << " at its base address" << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    header = static_cast<MappedBookHeader*>(region);
+    mappedSize = capacity;
+    return true;
+}
+
+bool MappedBook::create(const std::string& filename, std::size_t capacity, std::uintptr_t baseAddress)
+{
+    close();
+    capacity = (capacity + 4095) & ~std::size_t(4095);
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, capacity) != 0)
+    {
+        std::cerr << "Error creating book file: " << filename << std::endl;
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+        return false;
+    }
+    if (!map(filename, baseAddress, capacity))
+    {
+        return false;
+    }
+
+    std::memcpy(header->magic, mappedBookMagic, sizeof(mappedBookMagic));
+    header->baseAddress = baseAddress;
+    header->capacity = capacity;
+    header->bookSize = sizeof(Book);
+    header->cleanShutdown = 0;
+    header->sequenceNumber = 0;
+    new (&header->arena) Arena(reinterpret_cast<char*>(header) + arenaOffset(), capacity - arenaOffset());
+    header->book = new (header->arena.allocate(sizeof(Book))) Book(&header->arena);
+    return true;
+}
+
+bool MappedBook::open(const std::string& filename, bool fullCheck)
+{
+    close();
+    fd = ::open(filename.c_str(), O_RDWR);
+    alignas(MappedBookHeader) char storedBytes[sizeof(MappedBookHeader)];
+    const MappedBookHeader& stored = *reinterpret_cast<const MappedBookHeader*>(storedBytes);
+    if (fd < 0 || pread(fd, storedBytes, sizeof(storedBytes), 0) != sizeof(storedBytes)
+        || std::memcmp(stored.magic, mappedBookMagic, sizeof(mappedBookMagic)) != 0 || stored.bookSize != sizeof(Book))
+    {
+        std::cerr << "Invalid book file: " << filename << std::endl;
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+        return false;
+    }
+    if (!map(filename, stored.baseAddress, stored.capacity))
+    {
+        return false;
+    }
+
+    // A book that was not closed cleanly may have been left part way through an update
+    if ((fullCheck || header->cleanShutdown == 0) && !header->book->checkConsistency())
+    {
+        std::cerr << "Book file failed consistency check: " << filename << std::endl;
+        munmap(header, mappedSize);
+        header = nullptr;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    header->cleanShutdown = 0;
+    return true;
+}
+
+void MappedBook::close()
+{
+    if (header != nullptr)
+    {
+        header->cleanShutdown = 1;
+        sync();
+        munmap(header, mappedSize);
+        header = nullptr;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// Only the part of the file the arena has handed out can be dirty
+bool MappedBook::sync()
+{
+    if (header == nullptr)
+    {
+        return false;
+    }
+    std::size_t length = (arenaOffset() + header->arena.getUsed() + 4095) & ~std::size_t(4095);
+    return msync(header, length < mappedSize ? length : mappedSize, MS_SYNC) == 0;
+}
+
+Book* MappedBook::getBook() const
+{
+    return header == nullptr ? nullptr : header->book;
+}
+
+bool MappedBook::isOpen() const
+{
+    return header != nullptr;
+}
+
+std::uint64_t MappedBook::getSequenceNumber() const
+{
+    return header->sequenceNumber;
+}
+
+void MappedBook::setSequenceNumber(std::uint64_t sequenceNumber)
+{
+    header->sequenceNumber = sequenceNumber;
+}
+
+std::size_t MappedBook::getUsedBytes() const
+{
+    return header->arena.getUsed();
+}
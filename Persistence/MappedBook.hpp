@@ -0,0 +1,49 @@
+#ifndef MAPPEDBOOK_HPP
+#define MAPPEDBOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Book;
+struct MappedBookHeader;
+
+// A book whose orders, levels and indexes all live in a memory-mapped file.
+// The file is always mapped at the address it was created at, so the raw pointers inside the
+// book stay valid and reopening it is a remap plus a consistency check, with nothing to parse
+// or rebuild. Only a process crash is covered; use the journal for machine failures.
+class MappedBook {
+private:
+    int fd;
+    MappedBookHeader* header;
+    std::size_t mappedSize;
+
+    bool map(const std::string& filename, std::uintptr_t baseAddress, std::size_t capacity);
+
+public:
+    static constexpr std::uintptr_t defaultBaseAddress = 0x500000000000;
+
+    MappedBook();
+    ~MappedBook();
+
+    MappedBook(const MappedBook&) = delete;
+    MappedBook& operator=(const MappedBook&) = delete;
+
+    // Create a new empty book in a sparse file of the given capacity
+    bool create(const std::string& filename, std::size_t capacity, std::uintptr_t baseAddress=defaultBaseAddress);
+    // Remap an existing book. The full structural check runs if the book was not closed
+    // cleanly or if fullCheck is set, otherwise only the header is validated.
+    bool open(const std::string& filename, bool fullCheck=false);
+    // Flush dirty pages, mark the book as cleanly closed and unmap it
+    void close();
+    bool sync();
+
+    Book* getBook() const;
+    bool isOpen() const;
+    // The sequence number of the last command applied, for resuming a journal
+    std::uint64_t getSequenceNumber() const;
+    void setSequenceNumber(std::uint64_t sequenceNumber);
+    std::size_t getUsedBytes() const;
+};
+
+#endif
@@ -0,0 +1,377 @@
+#include "AsyncFileReader.hpp"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// O_DIRECT needs buffers, offsets and lengths aligned to the logical block size, a page is
+// enough for every common file system
+static const std::size_t directAlignment = 4096;
+
+// liburing is not a dependency, so the two io_uring system calls are made directly
+static int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+AsyncFileReader::AsyncFileReader(std::size_t _bufferSize, int _bufferCount)
+    : bufferSize((_bufferSize + directAlignment - 1) / directAlignment * directAlignment), bufferCount(_bufferCount),
+    fd(-1), direct(false), failed(false), backend(Backend::IoUring), fileSize(0), chunkCount(0), nextChunk(0),
+    holding(false), ringFd(-1), submissionRing(nullptr), submissionRingSize(0), completionRing(nullptr),
+    completionRingSize(0), submissionEntries(nullptr), submissionEntriesSize(0), submissionTail(nullptr),
+    submissionMask(nullptr), submissionArray(nullptr), completionHead(nullptr), completionTail(nullptr),
+    completionMask(nullptr), completionEntries(nullptr), inFlight(0), stopping(false)
+{
+    if (bufferSize == 0)
+    {
+        bufferSize = directAlignment;
+    }
+    if (bufferCount < 2)
+    {
+        bufferCount = 2;
+    }
+    slots.resize(bufferCount);
+    for (Slot& slot : slots)
+    {
+        slot.data = static_cast<char*>(std::aligned_alloc(directAlignment, bufferSize));
+    }
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    close();
+    for (Slot& slot : slots)
+    {
+        std::free(slot.data);
+    }
+}
+
+bool AsyncFileReader::isIoUringSupported()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ringFd = ioUringSetup(1, &params);
+    if (ringFd < 0)
+    {
+        return false;
+    }
+    ::close(ringFd);
+    return true;
+}
+
+bool AsyncFileReader::setupIoUring()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = ioUringSetup(bufferCount, &params);
+    if (ringFd < 0)
+    {
+        return false;
+    }
+
+    submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMapping)
+    {
+        submissionRingSize = std::max(submissionRingSize, completionRingSize);
+        completionRingSize = submissionRingSize;
+    }
+    submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    completionRing = singleMapping ? submissionRing
+        : mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* entries = mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED || entries == MAP_FAILED)
+    {
+        submissionRing = submissionRing == MAP_FAILED ? nullptr : submissionRing;
+        completionRing = completionRing == MAP_FAILED ? nullptr : completionRing;
+        closeIoUring();
+        if (entries != MAP_FAILED)
+        {
+            munmap(entries, submissionEntriesSize);
+        }
+        return false;
+    }
+    submissionEntries = static_cast<io_uring_sqe*>(entries);
+
+    char* submission = static_cast<char*>(submissionRing);
+    submissionTail = reinterpret_cast<unsigned*>(submission + params.sq_off.tail);
+    submissionMask = reinterpret_cast<unsigned*>(submission + params.sq_off.ring_mask);
+    submissionArray = reinterpret_cast<unsigned*>(submission + params.sq_off.array);
+    char* completion = static_cast<char*>(completionRing);
+    completionHead = reinterpret_cast<unsigned*>(completion + params.cq_off.head);
+    completionTail = reinterpret_cast<unsigned*>(completion + params.cq_off.tail);
+    completionMask = reinterpret_cast<unsigned*>(completion + params.cq_off.ring_mask);
+    completionEntries = reinterpret_cast<io_uring_cqe*>(completion + params.cq_off.cqes);
+    return true;
+}
+
+void AsyncFileReader::closeIoUring()
+{
+    if (submissionEntries != nullptr)
+    {
+        munmap(submissionEntries, submissionEntriesSize);
+    }
+    if (completionRing != nullptr && completionRing != submissionRing)
+    {
+        munmap(completionRing, completionRingSize);
+    }
+    if (submissionRing != nullptr)
+    {
+        munmap(submissionRing, submissionRingSize);
+    }
+    if (ringFd >= 0)
+    {
+        ::close(ringFd);
+    }
+    ringFd = -1;
+    submissionRing = nullptr;
+    completionRing = nullptr;
+    submissionEntries = nullptr;
+}
+
+bool AsyncFileReader::open(const std::string& filename, Backend _backend)
+{
+    close();
+    fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+    direct = fd >= 0;
+    if (fd < 0)
+    {
+        fd = ::open(filename.c_str(), O_RDONLY);
+    }
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0)
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    fileSize = status.st_size;
+    chunkCount = (fileSize + bufferSize - 1) / bufferSize;
+    nextChunk = 0;
+    holding = false;
+    failed = false;
+
+    backend = _backend == Backend::IoUring && setupIoUring() ? Backend::IoUring : Backend::ReadAheadThread;
+    for (int i = 0; i < bufferCount; i++)
+    {
+        startChunk(slots[i], i);
+    }
+    if (backend == Backend::ReadAheadThread)
+    {
+        stopping = false;
+        readAhead = std::thread(&AsyncFileReader::readAheadLoop, this);
+    }
+    return true;
+}
+
+void AsyncFileReader::close()
+{
+    if (readAhead.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        readAhead.join();
+    }
+    // The kernel may still be writing into the buffers until every read has completed
+    while (ringFd >= 0 && inFlight > 0 && reapCompletions())
+    {
+    }
+    closeIoUring();
+    inFlight = 0;
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+    fd = -1;
+    fileSize = 0;
+    chunkCount = 0;
+    nextChunk = 0;
+    holding = false;
+}
+
+void AsyncFileReader::startChunk(Slot& slot, std::uint64_t chunk)
+{
+    slot.chunk = chunk;
+    slot.expected = chunk < chunkCount ? std::min<std::uint64_t>(bufferSize, fileSize - chunk * bufferSize) : 0;
+    slot.filled = 0;
+    slot.ready = false;
+    if (backend == Backend::IoUring && chunk < chunkCount)
+    {
+        submitRead(slot);
+    }
+}
+
+// Reads always ask for the rest of the buffer, so O_DIRECT lengths stay aligned and the
+// last chunk of the file simply comes back short
+void AsyncFileReader::submitRead(Slot& slot)
+{
+    unsigned tail = *submissionTail;
+    unsigned index = tail & *submissionMask;
+    io_uring_sqe& entry = submissionEntries[index];
+    std::memset(&entry, 0, sizeof(entry));
+    entry.opcode = IORING_OP_READ;
+    entry.fd = fd;
+    entry.addr = reinterpret_cast<std::uint64_t>(slot.data + slot.filled);
+    entry.len = static_cast<unsigned>(bufferSize - slot.filled);
+    entry.off = slot.chunk * bufferSize + slot.filled;
+    entry.user_data = &slot - slots.data();
+    submissionArray[index] = index;
+    __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+    if (ioUringEnter(ringFd, 1, 0, 0) < 0)
+    {
+        std::cerr << "Error submitting read: " << std::strerror(errno) << std::endl;
+        failed = true;
+        return;
+    }
+    inFlight += 1;
+}
+
+// Waits for at least one completion if none are queued, then processes all queued ones.
+// Returns false only if waiting failed, read errors are reported through failed.
+bool AsyncFileReader::reapCompletions()
+{
+    unsigned head = *completionHead;
+    if (head == __atomic_load_n(completionTail, __ATOMIC_ACQUIRE))
+    {
+        if (ioUringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+        {
+            std::cerr << "Error waiting for reads: " << std::strerror(errno) << std::endl;
+            failed = true;
+            return false;
+        }
+    }
+    while (head != __atomic_load_n(completionTail, __ATOMIC_ACQUIRE))
+    {
+        const io_uring_cqe& completion = completionEntries[head & *completionMask];
+        Slot& slot = slots[completion.user_data];
+        inFlight -= 1;
+        if (completion.res < 0)
+        {
+            std::cerr << "Error reading file: " << std::strerror(-completion.res) << std::endl;
+            failed = true;
+        } else {
+            slot.filled += completion.res;
+            if (completion.res == 0 || slot.filled >= slot.expected)
+            {
+                slot.expected = std::min(slot.expected, slot.filled);
+                slot.ready = true;
+            } else {
+                submitRead(slot);
+            }
+        }
+        head += 1;
+    }
+    __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+    return true;
+}
+
+void AsyncFileReader::readAheadLoop()
+{
+    for (std::uint64_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        Slot& slot = slots[chunk % bufferCount];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return stopping || (slot.chunk == chunk && !slot.ready); });
+            if (stopping)
+            {
+                return;
+            }
+        }
+        ssize_t result = 1;
+        std::size_t filled = 0;
+        while (filled < slot.expected && result > 0)
+        {
+            result = pread(fd, slot.data + filled, bufferSize - filled, chunk * bufferSize + filled);
+            filled += result > 0 ? result : 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (result < 0)
+            {
+                std::cerr << "Error reading file: " << std::strerror(errno) << std::endl;
+                failed = true;
+            }
+            slot.filled = filled;
+            slot.expected = std::min(slot.expected, filled);
+            slot.ready = true;
+        }
+        changed.notify_all();
+    }
+}
+
+bool AsyncFileReader::next(const char*& data, std::size_t& size)
+{
+    if (holding)
+    {
+        Slot& previous = slots[(nextChunk - 1) % bufferCount];
+        holding = false;
+        if (backend == Backend::IoUring)
+        {
+            startChunk(previous, previous.chunk + bufferCount);
+        } else {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                startChunk(previous, previous.chunk + bufferCount);
+            }
+            changed.notify_all();
+        }
+    }
+    if (nextChunk >= chunkCount)
+    {
+        return false;
+    }
+
+    Slot& slot = slots[nextChunk % bufferCount];
+    if (backend == Backend::IoUring)
+    {
+        while (!slot.ready && !failed && reapCompletions())
+        {
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return slot.ready || failed; });
+    }
+    if (failed)
+    {
+        return false;
+    }
+    data = slot.data;
+    size = slot.expected;
+    nextChunk += 1;
+    holding = true;
+    return true;
+}
+
+AsyncFileReader::Backend AsyncFileReader::getBackend() const
+{
+    return backend;
+}
+
+bool AsyncFileReader::isDirect() const
+{
+    return direct;
+}
+
+std::uint64_t AsyncFileReader::getFileSize() const
+{
+    return fileSize;
+}
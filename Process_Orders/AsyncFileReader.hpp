@@ -0,0 +1,100 @@
+#ifndef ASYNCFILEREADER_HPP
+#define ASYNCFILEREADER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Reads a file front to back through a ring of page-aligned buffers, keeping reads in flight
+// for every buffer the caller is not holding. The file is opened with O_DIRECT when the file
+// system allows it, so multi-GB replays do not push everything else out of the page cache.
+// Reads go through io_uring, set up with raw system calls, or through a read-ahead thread
+// when io_uring is not available.
+class AsyncFileReader {
+public:
+    enum class Backend {
+        IoUring,
+        ReadAheadThread
+    };
+
+private:
+    // One buffer of the ring, holding chunk number chunk of the file
+    struct Slot {
+        char* data;
+        std::uint64_t chunk;
+        std::size_t expected;
+        std::size_t filled;
+        bool ready;
+    };
+
+    std::size_t bufferSize;
+    int bufferCount;
+    std::vector<Slot> slots;
+    int fd;
+    bool direct;
+    bool failed;
+    Backend backend;
+    std::uint64_t fileSize;
+    std::uint64_t chunkCount;
+    std::uint64_t nextChunk;
+    bool holding;
+
+    // io_uring rings, mapped from the ring file descriptor
+    int ringFd;
+    void* submissionRing;
+    std::size_t submissionRingSize;
+    void* completionRing;
+    std::size_t completionRingSize;
+    io_uring_sqe* submissionEntries;
+    std::size_t submissionEntriesSize;
+    unsigned* submissionTail;
+    unsigned* submissionMask;
+    unsigned* submissionArray;
+    unsigned* completionHead;
+    unsigned* completionTail;
+    unsigned* completionMask;
+    io_uring_cqe* completionEntries;
+    int inFlight;
+
+    // Read-ahead thread state, slots are handed over under the mutex
+    std::thread readAhead;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping;
+
+    bool setupIoUring();
+    void closeIoUring();
+    void submitRead(Slot& slot);
+    bool reapCompletions();
+    void startChunk(Slot& slot, std::uint64_t chunk);
+    void readAheadLoop();
+
+public:
+    AsyncFileReader(std::size_t bufferSize=1 << 20, int bufferCount=8);
+    ~AsyncFileReader();
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    // Falls back to the read-ahead thread when io_uring cannot be set up
+    bool open(const std::string& filename, Backend backend=Backend::IoUring);
+    void close();
+
+    // Waits for the next buffer in file order and hands the previous one back for reading.
+    // Returns false at the end of the file or after a read error.
+    bool next(const char*& data, std::size_t& size);
+
+    Backend getBackend() const;
+    bool isDirect() const;
+    std::uint64_t getFileSize() const;
+    static bool isIoUringSupported();
+};
+
+#endif
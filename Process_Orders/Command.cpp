@@ -0,0 +1,368 @@
+#include "Command.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <climits>
+#include <cstdint>
+
+// Read the next space separated integer, advancing the position past it
+static bool parseInt(std::string_view line, std::size_t& position, int& value)
+{
+    while (position < line.size() && line[position] == ' ')
+    {
+        position += 1;
+    }
+    bool negative = position < line.size() && line[position] == '-';
+    if (negative)
+    {
+        position += 1;
+    }
+    if (position >= line.size() || line[position] < '0' || line[position] > '9')
+    {
+        return false;
+    }
+    // Accumulate in 64 bits and reject anything outside int, allowing INT_MIN itself
+    std::int64_t magnitude = 0;
+    std::int64_t limit = negative ? -std::int64_t(INT_MIN) : INT_MAX;
+    while (position < line.size() && line[position] >= '0' && line[position] <= '9')
+    {
+        magnitude = magnitude * 10 + (line[position] - '0');
+        if (magnitude > limit)
+        {
+            return false;
+        }
+        position += 1;
+    }
+    value = static_cast<int>(negative ? -magnitude : magnitude);
+    return true;
+}
+
+// Apply a single command to the book
+void applyCommand(Book* book, const Command& command)
+{
+    if (command.timestamp != 0)
+    {
+        book->advanceTime(command.timestamp, expiriesPerCommand);
+    }
+    switch (command.type)
+    {
+    case CommandType::Market:
+        book->marketOrder(command.orderId, command.buyOrSell, command.shares, command.ownerId);
+        break;
+    case CommandType::AddLimit:
+        book->addLimitOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice, command.ownerId);
+        break;
+    case CommandType::CancelLimit:
+        book->cancelLimitOrder(command.orderId);
+        break;
+    case CommandType::ModifyLimit:
+        book->modifyLimitOrder(command.orderId, command.shares, command.limitPrice);
+        break;
+    case CommandType::AddStop:
+        book->addStopOrder(command.orderId, command.buyOrSell, command.shares, command.stopPrice);
+        break;
+    case CommandType::CancelStop:
+        book->cancelStopOrder(command.orderId);
+        break;
+    case CommandType::ModifyStop:
+        book->modifyStopOrder(command.orderId, command.shares, command.stopPrice);
+        break;
+    case CommandType::AddStopLimit:
+        book->addStopLimitOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice, command.stopPrice);
+        break;
+    case CommandType::CancelStopLimit:
+        book->cancelStopLimitOrder(command.orderId);
+        break;
+    case CommandType::ModifyStopLimit:
+        book->modifyStopLimitOrder(command.orderId, command.shares, command.limitPrice, command.stopPrice);
+        break;
+    case CommandType::ImmediateOrCancel:
+        book->immediateOrCancelOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice);
+        break;
+    case CommandType::FillOrKill:
+        book->fillOrKillOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice);
+        break;
+    case CommandType::AddIceberg:
+        book->addIcebergOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice, command.stopPrice);
+        break;
+    case CommandType::AddPegged:
+        book->addPeggedOrder(command.orderId, command.buyOrSell, command.shares, static_cast<PegType>(command.limitPrice), command.stopPrice);
+        break;
+    case CommandType::CancelPegged:
+        book->cancelPeggedOrder(command.orderId);
+        break;
+    case CommandType::AddTrailingStop:
+        book->addTrailingStopOrder(command.orderId, command.buyOrSell, command.shares, command.stopPrice);
+        break;
+    case CommandType::CancelTrailingStop:
+        book->cancelTrailingStopOrder(command.orderId);
+        break;
+    case CommandType::AddGoodTillTime:
+        book->addGoodTillTimeOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice, command.stopPrice);
+        break;
+    case CommandType::ClockTick:
+        book->advanceTime(command.limitPrice, command.shares > 0 ? command.shares : INT_MAX);
+        break;
+    case CommandType::CancelOwner:
+        book->cancelOwnerOrders(command.ownerId);
+        break;
+    case CommandType::MassCancel:
+        book->massCancel(command.buyOrSell, command.limitPrice, command.stopPrice);
+        break;
+    case CommandType::ProtectedMarket:
+        book->protectedMarketOrder(command.orderId, command.buyOrSell, command.shares, command.limitPrice, command.stopPrice != 0, command.ownerId);
+        break;
+    case CommandType::AuctionBegin:
+        book->startAuction();
+        break;
+    case CommandType::AuctionEnd:
+        book->uncrossAuction(command.limitPrice);
+        break;
+    }
+}
+
+// Parse one line of the text order format into a command, returns false for unknown order types
+bool parseCommand(std::string_view line, Command& command)
+{
+    std::size_t position = line.find(' ');
+    std::string_view orderType = line.substr(0, position);
+    if (position == std::string_view::npos)
+    {
+        position = line.size();
+    }
+
+    // A "Symbol <id>" prefix routes the command that follows it through a BookManager
+    if (orderType == "Symbol")
+    {
+        int symbolId;
+        if (!parseInt(line, position, symbolId) || symbolId < 0)
+        {
+            return false;
+        }
+        while (position < line.size() && line[position] == ' ')
+        {
+            position += 1;
+        }
+        if (!parseCommand(line.substr(position), command))
+        {
+            return false;
+        }
+        command.symbolId = symbolId;
+        return true;
+    }
+
+    command = Command{};
+    int buyOrSell = 0;
+    if (orderType == "Market")
+    {
+        command.type = CommandType::Market;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares))
+        {
+            return false;
+        }
+    } else if (orderType == "AddLimit" || orderType == "AddMarketLimit" || orderType == "ImmediateOrCancel" || orderType == "FillOrKill")
+    {
+        command.type = orderType == "ImmediateOrCancel" ? CommandType::ImmediateOrCancel
+            : orderType == "FillOrKill" ? CommandType::FillOrKill : CommandType::AddLimit;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares) || !parseInt(line, position, command.limitPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "CancelLimit" || orderType == "CancelStop" || orderType == "CancelStopLimit" || orderType == "CancelPegged"
+        || orderType == "CancelTrailing")
+    {
+        command.type = orderType == "CancelLimit" ? CommandType::CancelLimit
+            : orderType == "CancelStop" ? CommandType::CancelStop
+            : orderType == "CancelStopLimit" ? CommandType::CancelStopLimit
+            : orderType == "CancelPegged" ? CommandType::CancelPegged : CommandType::CancelTrailingStop;
+        if (!parseInt(line, position, command.orderId))
+        {
+            return false;
+        }
+    } else if (orderType == "ModifyLimit")
+    {
+        command.type = CommandType::ModifyLimit;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, command.shares)
+            || !parseInt(line, position, command.limitPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "AddStop" || orderType == "AddTrailing")
+    {
+        command.type = orderType == "AddStop" ? CommandType::AddStop : CommandType::AddTrailingStop;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares) || !parseInt(line, position, command.stopPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "ModifyStop")
+    {
+        command.type = CommandType::ModifyStop;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, command.shares)
+            || !parseInt(line, position, command.stopPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "AddStopLimit" || orderType == "AddIceberg" || orderType == "AddPegged" || orderType == "AddLimitUntil")
+    {
+        command.type = orderType == "AddStopLimit" ? CommandType::AddStopLimit
+            : orderType == "AddIceberg" ? CommandType::AddIceberg
+            : orderType == "AddPegged" ? CommandType::AddPegged : CommandType::AddGoodTillTime;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares) || !parseInt(line, position, command.limitPrice)
+            || !parseInt(line, position, command.stopPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "MarketFor")
+    {
+        command.type = CommandType::Market;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares) || !parseInt(line, position, command.ownerId))
+        {
+            return false;
+        }
+    } else if (orderType == "AddLimitFor")
+    {
+        command.type = CommandType::AddLimit;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares) || !parseInt(line, position, command.limitPrice)
+            || !parseInt(line, position, command.ownerId))
+        {
+            return false;
+        }
+    } else if (orderType == "CancelOwner")
+    {
+        command.type = CommandType::CancelOwner;
+        if (!parseInt(line, position, command.ownerId))
+        {
+            return false;
+        }
+    } else if (orderType == "MassCancel")
+    {
+        command.type = CommandType::MassCancel;
+        if (!parseInt(line, position, buyOrSell) || !parseInt(line, position, command.limitPrice)
+            || !parseInt(line, position, command.stopPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "MarketProtected" || orderType == "MarketProtectedFor")
+    {
+        command.type = CommandType::ProtectedMarket;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, buyOrSell)
+            || !parseInt(line, position, command.shares) || !parseInt(line, position, command.limitPrice)
+            || !parseInt(line, position, command.stopPrice)
+            || (orderType == "MarketProtectedFor" && !parseInt(line, position, command.ownerId)))
+        {
+            return false;
+        }
+    } else if (orderType == "AuctionBegin")
+    {
+        command.type = CommandType::AuctionBegin;
+    } else if (orderType == "AuctionEnd")
+    {
+        command.type = CommandType::AuctionEnd;
+        if (!parseInt(line, position, command.limitPrice))
+        {
+            return false;
+        }
+    } else if (orderType == "ClockTick")
+    {
+        command.type = CommandType::ClockTick;
+        if (!parseInt(line, position, command.limitPrice) || !parseInt(line, position, command.shares))
+        {
+            return false;
+        }
+    } else if (orderType == "ModifyStopLimit")
+    {
+        command.type = CommandType::ModifyStopLimit;
+        if (!parseInt(line, position, command.orderId) || !parseInt(line, position, command.shares)
+            || !parseInt(line, position, command.limitPrice) || !parseInt(line, position, command.stopPrice))
+        {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    command.buyOrSell = buyOrSell != 0;
+    return true;
+}
+
+std::string formatCommand(const Command& command)
+{
+    if (command.symbolId != 0)
+    {
+        Command unrouted = command;
+        unrouted.symbolId = 0;
+        return "Symbol " + std::to_string(command.symbolId) + " " + formatCommand(unrouted);
+    }
+    std::string side = command.buyOrSell ? " 1 " : " 0 ";
+    std::string orderId = std::to_string(command.orderId);
+    std::string shares = std::to_string(command.shares);
+    switch (command.type)
+    {
+    case CommandType::Market:
+        if (command.ownerId != 0)
+        {
+            return "MarketFor " + orderId + side + shares + " " + std::to_string(command.ownerId);
+        }
+        return "Market " + orderId + side + shares;
+    case CommandType::AddLimit:
+        if (command.ownerId != 0)
+        {
+            return "AddLimitFor " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.ownerId);
+        }
+        return "AddLimit " + orderId + side + shares + " " + std::to_string(command.limitPrice);
+    case CommandType::CancelLimit:
+        return "CancelLimit " + orderId;
+    case CommandType::ModifyLimit:
+        return "ModifyLimit " + orderId + " " + shares + " " + std::to_string(command.limitPrice);
+    case CommandType::AddStop:
+        return "AddStop " + orderId + side + shares + " " + std::to_string(command.stopPrice);
+    case CommandType::CancelStop:
+        return "CancelStop " + orderId;
+    case CommandType::ModifyStop:
+        return "ModifyStop " + orderId + " " + shares + " " + std::to_string(command.stopPrice);
+    case CommandType::AddStopLimit:
+        return "AddStopLimit " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::CancelStopLimit:
+        return "CancelStopLimit " + orderId;
+    case CommandType::ModifyStopLimit:
+        return "ModifyStopLimit " + orderId + " " + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::ImmediateOrCancel:
+        return "ImmediateOrCancel " + orderId + side + shares + " " + std::to_string(command.limitPrice);
+    case CommandType::FillOrKill:
+        return "FillOrKill " + orderId + side + shares + " " + std::to_string(command.limitPrice);
+    case CommandType::AddIceberg:
+        return "AddIceberg " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::AddPegged:
+        return "AddPegged " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::CancelPegged:
+        return "CancelPegged " + orderId;
+    case CommandType::AddTrailingStop:
+        return "AddTrailing " + orderId + side + shares + " " + std::to_string(command.stopPrice);
+    case CommandType::CancelTrailingStop:
+        return "CancelTrailing " + orderId;
+    case CommandType::AddGoodTillTime:
+        return "AddLimitUntil " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::ClockTick:
+        return "ClockTick " + std::to_string(command.limitPrice) + " " + shares;
+    case CommandType::CancelOwner:
+        return "CancelOwner " + std::to_string(command.ownerId);
+    case CommandType::MassCancel:
+        return "MassCancel" + side + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::ProtectedMarket:
+        if (command.ownerId != 0)
+        {
+            return "MarketProtectedFor " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice)
+                + " " + std::to_string(command.ownerId);
+        }
+        return "MarketProtected " + orderId + side + shares + " " + std::to_string(command.limitPrice) + " " + std::to_string(command.stopPrice);
+    case CommandType::AuctionBegin:
+        return "AuctionBegin";
+    case CommandType::AuctionEnd:
+        return "AuctionEnd " + std::to_string(command.limitPrice);
+    }
+    return "";
+}
@@ -0,0 +1,72 @@
+#ifndef COMMAND_HPP
+#define COMMAND_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class Book;
+
+// The different requests the order book accepts, one per order pipeline keyword
+enum class CommandType : std::uint8_t {
+    Market,
+    AddLimit,
+    CancelLimit,
+    ModifyLimit,
+    AddStop,
+    CancelStop,
+    ModifyStop,
+    AddStopLimit,
+    CancelStopLimit,
+    ModifyStopLimit,
+    ImmediateOrCancel,
+    FillOrKill,
+    AddIceberg,
+    AddPegged,
+    CancelPegged,
+    AddTrailingStop,
+    CancelTrailingStop,
+    AddGoodTillTime,
+    ClockTick,
+    CancelOwner,
+    MassCancel,
+    ProtectedMarket,
+    AuctionBegin,
+    AuctionEnd
+};
+
+// Binary form of a single order book request.
+// Modify commands carry the new shares and prices in shares, limitPrice and stopPrice.
+// AddIceberg carries its display size in stopPrice, and AddPegged carries its PegType in
+// limitPrice and its offset in stopPrice. AddTrailingStop carries its offset in stopPrice, and
+// AddGoodTillTime its expiry time. ClockTick carries the time in limitPrice and the most expired
+// orders to cancel in shares, 0 for no limit. MassCancel carries its price range in limitPrice
+// and stopPrice. ProtectedMarket carries its protection in ticks in limitPrice and stopPrice is 1
+// to rest what is left at the protection price. AuctionEnd carries the reference price used to
+// break ties in limitPrice.
+// ownerId is the participant a Market or AddLimit order belongs to, checked for self-trades,
+// and the one CancelOwner cancels.
+// symbolId selects the book when commands are routed through a BookManager. In the text format
+// it is an optional "Symbol <id>" prefix before the keyword, left out for symbol 0.
+// A non-zero timestamp moves the book's clock forward before the command applies, cancelling
+// at most expiriesPerCommand expired orders. The text format has no timestamps.
+struct Command {
+    CommandType type;
+    bool buyOrSell;
+    int orderId;
+    int shares;
+    int limitPrice;
+    int stopPrice;
+    int symbolId;
+    int timestamp;
+    int ownerId;
+};
+
+constexpr int expiriesPerCommand = 64;
+
+void applyCommand(Book* book, const Command& command);
+bool parseCommand(std::string_view line, Command& command);
+// Inverse of parseCommand, writes the order pipeline line for a command
+std::string formatCommand(const Command& command);
+
+#endif
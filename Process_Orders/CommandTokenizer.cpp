@@ -0,0 +1,373 @@
+#include "CommandTokenizer.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#endif
+
+// Which command fields a keyword's integers fill, in order: i order id, b side, s shares,
+// l limit price, p stop price, o owner id. Field slots are 0 to 5 in that order, slot 6 is unused.
+struct KeywordLayout {
+    std::string_view keyword;
+    CommandType type;
+    std::size_t fieldCount;
+    int slots[6];
+
+    constexpr KeywordLayout(std::string_view _keyword, CommandType _type, std::string_view fields)
+        : keyword(_keyword), type(_type), fieldCount(fields.size()), slots{6, 6, 6, 6, 6, 6}
+    {
+        for (std::size_t i = 0; i < fields.size(); i++)
+        {
+            slots[i] = static_cast<int>(std::string_view("ibslpo").find(fields[i]));
+        }
+    }
+};
+
+static constexpr KeywordLayout keywordLayouts[] = {
+    {"Market", CommandType::Market, "ibs"},
+    {"AddLimit", CommandType::AddLimit, "ibsl"},
+    {"AddMarketLimit", CommandType::AddLimit, "ibsl"},
+    {"CancelLimit", CommandType::CancelLimit, "i"},
+    {"ModifyLimit", CommandType::ModifyLimit, "isl"},
+    {"AddStop", CommandType::AddStop, "ibsp"},
+    {"CancelStop", CommandType::CancelStop, "i"},
+    {"ModifyStop", CommandType::ModifyStop, "isp"},
+    {"AddStopLimit", CommandType::AddStopLimit, "ibslp"},
+    {"CancelStopLimit", CommandType::CancelStopLimit, "i"},
+    {"ModifyStopLimit", CommandType::ModifyStopLimit, "islp"},
+    {"ImmediateOrCancel", CommandType::ImmediateOrCancel, "ibsl"},
+    {"FillOrKill", CommandType::FillOrKill, "ibsl"},
+    {"AddIceberg", CommandType::AddIceberg, "ibslp"},
+    {"AddPegged", CommandType::AddPegged, "ibslp"},
+    {"CancelPegged", CommandType::CancelPegged, "i"},
+    {"AddTrailing", CommandType::AddTrailingStop, "ibsp"},
+    {"CancelTrailing", CommandType::CancelTrailingStop, "i"},
+    {"AddLimitUntil", CommandType::AddGoodTillTime, "ibslp"},
+    {"ClockTick", CommandType::ClockTick, "ls"},
+    {"AddLimitFor", CommandType::AddLimit, "ibslo"},
+    {"CancelOwner", CommandType::CancelOwner, "o"},
+    {"MassCancel", CommandType::MassCancel, "blp"},
+    {"MarketFor", CommandType::Market, "ibso"},
+    {"MarketProtected", CommandType::ProtectedMarket, "ibslp"},
+    {"MarketProtectedFor", CommandType::ProtectedMarket, "ibslpo"},
+    {"AuctionBegin", CommandType::AuctionBegin, ""},
+    {"AuctionEnd", CommandType::AuctionEnd, "l"}
+};
+
+// Keywords are told apart by their length and the low bits of their first and last letters,
+// which is unique for every keyword, so a lookup is one table load and one compare
+static constexpr int layoutSlot(std::size_t length, char first, char last)
+{
+    return static_cast<int>((length + (first & 3) + ((last & 31) << 2)) & 127);
+}
+
+struct LayoutTable {
+    const KeywordLayout* slots[128];
+
+    constexpr LayoutTable() : slots()
+    {
+        for (const KeywordLayout& layout : keywordLayouts)
+        {
+            int slot = layoutSlot(layout.keyword.size(), layout.keyword[0], layout.keyword.back());
+            if (slots[slot] != nullptr)
+            {
+                // Not a constant expression, so a colliding keyword fails to compile
+                throw "keyword slot collision";
+            }
+            slots[slot] = &layout;
+        }
+    }
+};
+
+static constexpr LayoutTable layoutTable;
+
+static const KeywordLayout* findLayout(const char* keyword, std::size_t length)
+{
+    if (length == 0)
+    {
+        return nullptr;
+    }
+    const KeywordLayout* layout = layoutTable.slots[layoutSlot(length, keyword[0], keyword[length - 1])];
+    if (layout == nullptr || layout->keyword.size() != length || std::memcmp(layout->keyword.data(), keyword, length) != 0)
+    {
+        return nullptr;
+    }
+    return layout;
+}
+
+// Full parse of one line, used by the scalar tokenizer and for lines the vector path rejects
+static void parseLine(std::string_view line, std::vector<Command>& commands, std::size_t& invalidLines)
+{
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+    Command command;
+    if (parseCommand(line, command))
+    {
+        commands.push_back(command);
+    } else if (!line.empty())
+    {
+        std::cerr << "Unknown order type: " << line << std::endl;
+        invalidLines += 1;
+    }
+}
+
+static std::size_t tokenizeScalar(const char* begin, const char* end, std::vector<Command>& commands)
+{
+    std::size_t invalidLines = 0;
+    while (begin < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        if (lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+        parseLine(std::string_view(begin, lineEnd - begin), commands, invalidLines);
+        begin = lineEnd + 1;
+    }
+    return invalidLines;
+}
+
+static bool convertDigitsScalar(const char* digits, std::size_t length, std::uint64_t& value)
+{
+    value = 0;
+    for (std::size_t i = 0; i < length; i++)
+    {
+        unsigned digit = static_cast<unsigned char>(digits[i]) - '0';
+        if (digit > 9)
+        {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+#ifdef TOKENIZER_X86
+
+// Shuffles that move an n digit run to the end of a 16 byte register, zeroing the bytes before it
+struct DigitShuffles {
+    alignas(16) std::uint8_t masks[17][16];
+
+    constexpr DigitShuffles() : masks()
+    {
+        for (int length = 0; length <= 16; length++)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                masks[length][i] = i >= 16 - length ? i - (16 - length) : 0x80;
+            }
+        }
+    }
+};
+
+static constexpr DigitShuffles digitShuffles;
+
+// Convert a run of up to 16 digits with three multiply-add steps: pairs, groups of four and
+// groups of eight. Needs 16 readable bytes from digits. Has no branches, so keywords can go
+// through it too and just come out as not digits.
+__attribute__((target("sse4.2")))
+static inline bool convertDigitsVector(const char* digits, std::size_t length, std::uint64_t& value)
+{
+    __m128i bytes = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(digits)), _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(9)), bytes);
+    std::uint32_t wanted = (1u << length) - 1;
+    bool valid = (static_cast<std::uint32_t>(_mm_movemask_epi8(isDigit)) & wanted) == wanted;
+    bytes = _mm_shuffle_epi8(bytes, _mm_load_si128(reinterpret_cast<const __m128i*>(digitShuffles.masks[length])));
+    __m128i pairs = _mm_maddubs_epi16(bytes, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    __m128i fours = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    fours = _mm_packus_epi32(fours, fours);
+    __m128i eights = _mm_madd_epi16(fours, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    value = static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_cvtsi128_si32(eights))) * 100000000
+        + static_cast<std::uint32_t>(_mm_extract_epi32(eights, 1));
+    return valid;
+}
+
+// Bit i of the result is set if byte i of the 64 byte block is a space, carriage return or newline
+using SeparatorMaskFunction = std::uint64_t (*)(const char* block, std::uint64_t& newlines);
+
+__attribute__((target("sse4.2")))
+static std::uint64_t separatorMasksSSE42(const char* block, std::uint64_t& newlines)
+{
+    std::uint64_t separators = 0;
+    newlines = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i newline = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+        __m128i separator = _mm_or_si128(newline, _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+        newlines |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(newline))) << (16 * i);
+        separators |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(separator))) << (16 * i);
+    }
+    return separators;
+}
+
+__attribute__((target("avx2")))
+static std::uint64_t separatorMasksAVX2(const char* block, std::uint64_t& newlines)
+{
+    std::uint64_t separators = 0;
+    newlines = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        __m256i newline = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+        __m256i separator = _mm256_or_si256(newline, _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))));
+        newlines |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(newline))) << (32 * i);
+        separators |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(separator))) << (32 * i);
+    }
+    return separators;
+}
+
+// A token is the text between two separators, it is empty for repeated separators
+struct Token {
+    std::uint64_t value;
+    std::size_t length;
+    bool number;
+    bool regular;
+};
+
+// Two passes per 64 byte block: the first converts every token as a number, the second
+// visits the newlines and builds each line's command from its tokens with a table instead of
+// branches. Tokens of the line still open at the end of a block are carried to the next one,
+// only the first eight since no keyword has more than six integers. The partial block at
+// the end goes to the scalar path.
+__attribute__((target("sse4.2")))
+static std::size_t tokenizeVector(const char* begin, const char* end, std::vector<Command>& commands, SeparatorMaskFunction separatorMasks)
+{
+    constexpr std::size_t carriedTokens = 8;
+    std::size_t invalidLines = 0;
+    const char* blocksEnd = begin + (end - begin) / 64 * 64;
+    const char* lineStart = begin;
+    const char* tokenStart = begin;
+    Token tokens[carriedTokens + 64 + 6] = {};
+    std::size_t pending = 0;
+
+    for (const char* block = begin; block < blocksEnd; block += 64)
+    {
+        std::uint64_t newlines;
+        std::uint64_t separators = separatorMasks(block, newlines);
+
+        std::size_t count = pending;
+        for (std::uint64_t remaining = separators; remaining != 0; remaining &= remaining - 1)
+        {
+            const char* separator = block + __builtin_ctzll(remaining);
+            Token& token = tokens[count++];
+            token.length = separator - tokenStart;
+            std::size_t length = token.length - 1 < 16 ? token.length : 16;
+            if (tokenStart + 16 <= end)
+            {
+                token.number = convertDigitsVector(tokenStart, length, token.value);
+            } else {
+                token.number = convertDigitsScalar(tokenStart, length, token.value);
+            }
+            // Bitwise ands, a branch here would be mispredicted on every keyword
+            token.number = token.number & (token.length - 1 < 16) & (token.value <= INT_MAX);
+            // parseCommand only accepts a carriage return right before the newline
+            token.regular = *separator != '\r' || (separator + 1 < end && separator[1] == '\n');
+            tokenStart = separator + 1;
+        }
+
+        std::size_t first = 0;
+        for (std::uint64_t remaining = newlines; remaining != 0; remaining &= remaining - 1)
+        {
+            int bit = __builtin_ctzll(remaining);
+            const char* newline = block + bit;
+            std::size_t last = pending + __builtin_popcountll(separators & ((std::uint64_t(1) << bit) - 1));
+            const Token* line = tokens + first;
+            std::size_t tokenCount = last - first + 1;
+
+            const KeywordLayout* layout = findLayout(lineStart, line[0].length);
+            bool valid = layout != nullptr && line[0].regular;
+            if (valid)
+            {
+                int fields[7] = {0, 0, 0, 0, 0, 0, 0};
+                for (std::size_t i = 1; i <= 6; i++)
+                {
+                    valid &= i > layout->fieldCount || (i < tokenCount && line[i].number && line[i].regular);
+                    fields[layout->slots[i - 1]] = static_cast<int>(line[i].value);
+                }
+                if (valid)
+                {
+                    commands.push_back(Command{layout->type, fields[1] != 0, fields[0], fields[2], fields[3], fields[4], 0, 0, fields[5]});
+                }
+            }
+            if (!valid && newline > lineStart)
+            {
+                parseLine(std::string_view(lineStart, newline - lineStart), commands, invalidLines);
+            }
+            first = last + 1;
+            lineStart = newline + 1;
+        }
+
+        pending = count - first < carriedTokens ? count - first : carriedTokens;
+        std::memmove(tokens, tokens + first, pending * sizeof(Token));
+    }
+    return invalidLines + tokenizeScalar(lineStart, end, commands);
+}
+
+#endif
+
+bool isTokenizerSupported(TokenizerKind kind)
+{
+#ifdef TOKENIZER_X86
+    switch (kind)
+    {
+    case TokenizerKind::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2");
+    case TokenizerKind::SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case TokenizerKind::Scalar:
+        return true;
+    }
+#endif
+    return kind == TokenizerKind::Scalar;
+}
+
+TokenizerKind getBestTokenizer()
+{
+    static const TokenizerKind best = isTokenizerSupported(TokenizerKind::AVX2) ? TokenizerKind::AVX2
+        : isTokenizerSupported(TokenizerKind::SSE42) ? TokenizerKind::SSE42 : TokenizerKind::Scalar;
+    return best;
+}
+
+const char* getTokenizerName(TokenizerKind kind)
+{
+    switch (kind)
+    {
+    case TokenizerKind::AVX2:
+        return "AVX2";
+    case TokenizerKind::SSE42:
+        return "SSE4.2";
+    case TokenizerKind::Scalar:
+        return "scalar";
+    }
+    return "unknown";
+}
+
+std::size_t tokenizeCommands(const char* begin, const char* end, std::vector<Command>& commands)
+{
+    return tokenizeCommands(begin, end, commands, getBestTokenizer());
+}
+
+// An unsupported kind falls back to the scalar tokenizer
+std::size_t tokenizeCommands(const char* begin, const char* end, std::vector<Command>& commands, TokenizerKind kind)
+{
+#ifdef TOKENIZER_X86
+    if (kind == TokenizerKind::AVX2 && isTokenizerSupported(kind))
+    {
+        return tokenizeVector(begin, end, commands, separatorMasksAVX2);
+    }
+    if (kind == TokenizerKind::SSE42 && isTokenizerSupported(kind))
+    {
+        return tokenizeVector(begin, end, commands, separatorMasksSSE42);
+    }
+#endif
+    return tokenizeScalar(begin, end, commands);
+}
@@ -0,0 +1,29 @@
+#ifndef COMMANDTOKENIZER_HPP
+#define COMMANDTOKENIZER_HPP
+
+#include "Command.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Instruction sets the tokenizer can use, best one is picked at runtime
+enum class TokenizerKind {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+// Parses a block of order pipeline lines into commands, appending them in line order.
+// The vector versions find spaces and newlines with byte compares over 32 (AVX2) or 16 (SSE4.2)
+// bytes at a time and convert each digit run with multiply-adds. Lines they cannot handle,
+// such as negative numbers or a symbol prefix, go through parseCommand, so every version gives
+// the same commands.
+// Returns the number of non-empty lines that were not valid commands.
+std::size_t tokenizeCommands(const char* begin, const char* end, std::vector<Command>& commands);
+std::size_t tokenizeCommands(const char* begin, const char* end, std::vector<Command>& commands, TokenizerKind kind);
+
+TokenizerKind getBestTokenizer();
+bool isTokenizerSupported(TokenizerKind kind);
+const char* getTokenizerName(TokenizerKind kind);
+
+#endif
@@ -0,0 +1,81 @@
+#include "HashTrace.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <fstream>
+#include <iostream>
+
+std::vector<HashCheckpoint> recordHashTrace(Book* book, const std::vector<Command>& commands, int interval)
+{
+    std::vector<HashCheckpoint> trace;
+    if (interval < 1)
+    {
+        std::cerr << "Hash trace interval must be at least 1" << std::endl;
+        return trace;
+    }
+    trace.reserve(commands.size() / interval + 1);
+    for (std::size_t i = 0; i < commands.size(); i++)
+    {
+        applyCommand(book, commands[i]);
+        std::uint64_t sequenceNumber = i + 1;
+        if (sequenceNumber % interval == 0 || sequenceNumber == commands.size())
+        {
+            trace.push_back(HashCheckpoint{sequenceNumber, book->getStateHash()});
+        }
+    }
+    return trace;
+}
+
+// One "sequence hash" pair per line, hash in hex, so traces can also be diffed by hand
+bool saveHashTrace(const std::string& filename, const std::vector<HashCheckpoint>& trace)
+{
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening hash trace file: " << filename << std::endl;
+        return false;
+    }
+    for (const HashCheckpoint& checkpoint : trace)
+    {
+        file << checkpoint.sequenceNumber << " " << std::hex << checkpoint.stateHash << std::dec << "\n";
+    }
+    return file.good();
+}
+
+std::vector<HashCheckpoint> loadHashTrace(const std::string& filename)
+{
+    std::vector<HashCheckpoint> trace;
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening hash trace file: " << filename << std::endl;
+        return trace;
+    }
+    HashCheckpoint checkpoint;
+    while (file >> checkpoint.sequenceNumber >> std::hex >> checkpoint.stateHash >> std::dec)
+    {
+        trace.push_back(checkpoint);
+    }
+    return trace;
+}
+
+HashDivergence compareHashTraces(const std::vector<HashCheckpoint>& first, const std::vector<HashCheckpoint>& second)
+{
+    HashDivergence result{false, 0, 0};
+    std::size_t common = std::min(first.size(), second.size());
+    for (std::size_t i = 0; i < common; i++)
+    {
+        if (first[i].sequenceNumber != second[i].sequenceNumber || first[i].stateHash != second[i].stateHash)
+        {
+            result.diverged = true;
+            result.firstDivergentSequence = std::min(first[i].sequenceNumber, second[i].sequenceNumber);
+            return result;
+        }
+        result.lastMatchingSequence = first[i].sequenceNumber;
+    }
+    if (first.size() != second.size())
+    {
+        result.diverged = true;
+        result.firstDivergentSequence = (first.size() > common ? first : second)[common].sequenceNumber;
+    }
+    return result;
+}
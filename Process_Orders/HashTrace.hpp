@@ -0,0 +1,33 @@
+#ifndef HASHTRACE_HPP
+#define HASHTRACE_HPP
+
+#include "Command.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Book;
+
+// The book's state hash after a given number of commands
+struct HashCheckpoint {
+    std::uint64_t sequenceNumber;
+    std::uint64_t stateHash;
+};
+
+// Where two hash traces of the same command stream stop agreeing
+struct HashDivergence {
+    bool diverged;
+    std::uint64_t lastMatchingSequence;
+    std::uint64_t firstDivergentSequence;
+};
+
+// Apply the commands in order, recording the state hash after every interval commands and after the last one.
+// An interval below 1 applies nothing and returns an empty trace.
+std::vector<HashCheckpoint> recordHashTrace(Book* book, const std::vector<Command>& commands, int interval);
+bool saveHashTrace(const std::string& filename, const std::vector<HashCheckpoint>& trace);
+std::vector<HashCheckpoint> loadHashTrace(const std::string& filename);
+// Traces must be recorded with the same interval. A trace that ends early diverges at its first missing checkpoint.
+HashDivergence compareHashTraces(const std::vector<HashCheckpoint>& first, const std::vector<HashCheckpoint>& second);
+
+#endif
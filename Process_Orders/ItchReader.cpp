@@ -0,0 +1,343 @@
+#include "ItchReader.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Message lengths and field offsets from the TotalView-ITCH 5.0 specification
+static const std::size_t headerLength = 11;
+static const std::size_t stockDirectoryLength = 39;
+static const std::size_t addOrderLength = 36;
+static const std::size_t addOrderMPIDLength = 40;
+static const std::size_t orderExecutedLength = 31;
+static const std::size_t orderExecutedPriceLength = 36;
+static const std::size_t orderCancelLength = 23;
+static const std::size_t orderDeleteLength = 19;
+static const std::size_t orderReplaceLength = 35;
+
+static inline std::uint64_t readBigEndian(const unsigned char* field, int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        value = (value << 8) | field[i];
+    }
+    return value;
+}
+
+ItchReader::ItchReader()
+    : data(nullptr), size(0), stockLocate(-1), nextOrderId(1), messageCount(0), commandCount(0)
+{
+    std::memset(stock, ' ', sizeof(stock));
+}
+
+ItchReader::~ItchReader()
+{
+    close();
+}
+
+bool ItchReader::open(const std::string& filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Error opening ITCH file: " << filename << std::endl;
+        return false;
+    }
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+    void* mapping = fileSize > 0 ? mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Error mapping ITCH file: " << filename << std::endl;
+        return false;
+    }
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    data = static_cast<const unsigned char*>(mapping);
+    size = fileSize;
+    return true;
+}
+
+void ItchReader::close()
+{
+    if (data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(data), size);
+        data = nullptr;
+        size = 0;
+    }
+}
+
+void ItchReader::selectSymbol(const std::string& symbol)
+{
+    std::memset(stock, ' ', sizeof(stock));
+    std::memcpy(stock, symbol.data(), std::min(symbol.size(), sizeof(stock)));
+    stockLocate = -1;
+}
+
+// Shares leaving an order through an execution or partial cancel
+template <typename Handler>
+void ItchReader::reduceOrder(std::uint64_t reference, int shares, Handler& handler)
+{
+    auto it = orders.find(reference);
+    if (it == orders.end())
+    {
+        return;
+    }
+    ItchOrder& order = it->second;
+    order.shares -= shares;
+    if (order.shares > 0)
+    {
+        handler(Command{.type = CommandType::ModifyLimit, .orderId = order.orderId, .shares = order.shares, .limitPrice = order.price});
+    } else {
+        handler(Command{.type = CommandType::CancelLimit, .orderId = order.orderId});
+        orders.erase(it);
+    }
+}
+
+template <typename Handler>
+void ItchReader::parse(Handler&& handler)
+{
+    orders.clear();
+    nextOrderId = 1;
+    messageCount = 0;
+    commandCount = 0;
+    auto emit = [&](const Command& command)
+    {
+        commandCount += 1;
+        handler(command);
+    };
+
+    std::size_t position = 0;
+    while (position + 2 <= size)
+    {
+        std::size_t length = readBigEndian(data + position, 2);
+        const unsigned char* message = data + position + 2;
+        position += 2 + length;
+        if (position > size || length < headerLength)
+        {
+            break;
+        }
+        messageCount += 1;
+        char type = message[0];
+        int locate = readBigEndian(message + 1, 2);
+
+        if (type == 'R' && length >= stockDirectoryLength)
+        {
+            if (std::memcmp(message + 11, stock, sizeof(stock)) == 0)
+            {
+                stockLocate = locate;
+            }
+            continue;
+        }
+        // Without a stock directory the locate code is learnt from the first add for the symbol
+        if (stockLocate < 0 && (type == 'A' || type == 'F') && length >= addOrderLength && std::memcmp(message + 24, stock, sizeof(stock)) == 0)
+        {
+            stockLocate = locate;
+        }
+        if (locate != stockLocate)
+        {
+            continue;
+        }
+
+        switch (type)
+        {
+            case 'A':
+            case 'F':
+            {
+                if (length < (type == 'A' ? addOrderLength : addOrderMPIDLength))
+                {
+                    break;
+                }
+                std::uint64_t reference = readBigEndian(message + 11, 8);
+                bool buyOrSell = message[19] == 'B';
+                int shares = readBigEndian(message + 20, 4);
+                int price = readBigEndian(message + 32, 4);
+                int orderId = nextOrderId++;
+                orders[reference] = ItchOrder{orderId, shares, price, buyOrSell};
+                emit(Command{.type = CommandType::AddLimit, .buyOrSell = buyOrSell, .orderId = orderId, .shares = shares, .limitPrice = price});
+                break;
+            }
+            case 'E':
+            case 'C':
+                if (length >= (type == 'E' ? orderExecutedLength : orderExecutedPriceLength))
+                {
+                    reduceOrder(readBigEndian(message + 11, 8), readBigEndian(message + 19, 4), emit);
+                }
+                break;
+            case 'X':
+                if (length >= orderCancelLength)
+                {
+                    reduceOrder(readBigEndian(message + 11, 8), readBigEndian(message + 19, 4), emit);
+                }
+                break;
+            case 'D':
+            {
+                auto it = length >= orderDeleteLength ? orders.find(readBigEndian(message + 11, 8)) : orders.end();
+                if (it != orders.end())
+                {
+                    emit(Command{.type = CommandType::CancelLimit, .orderId = it->second.orderId});
+                    orders.erase(it);
+                }
+                break;
+            }
+            case 'U':
+            {
+                // The new reference takes over the book order, which moves to the back of its new level
+                // even at the same price with fewer shares, where ModifyLimit would keep its place
+                auto it = length >= orderReplaceLength ? orders.find(readBigEndian(message + 11, 8)) : orders.end();
+                if (it != orders.end())
+                {
+                    ItchOrder order = it->second;
+                    orders.erase(it);
+                    order.shares = readBigEndian(message + 27, 4);
+                    order.price = readBigEndian(message + 31, 4);
+                    orders[readBigEndian(message + 19, 8)] = order;
+                    emit(Command{.type = CommandType::CancelLimit, .orderId = order.orderId});
+                    emit(Command{.type = CommandType::AddLimit, .buyOrSell = order.buyOrSell, .orderId = order.orderId, .shares = order.shares, .limitPrice = order.price});
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+std::size_t ItchReader::replay(Book* book)
+{
+    parse([book](const Command& command)
+    {
+        applyCommand(book, command);
+    });
+    return commandCount;
+}
+
+std::vector<Command> ItchReader::readCommands()
+{
+    std::vector<Command> commands;
+    parse([&commands](const Command& command)
+    {
+        commands.push_back(command);
+    });
+    return commands;
+}
+
+std::uint64_t ItchReader::getMessageCount() const
+{
+    return messageCount;
+}
+
+std::uint64_t ItchReader::getCommandCount() const
+{
+    return commandCount;
+}
+
+int ItchReader::getStockLocate() const
+{
+    return stockLocate;
+}
+
+ItchWriter::ItchWriter() : timestamp(0) {}
+
+void ItchWriter::header(char type, int stockLocate, std::size_t length)
+{
+    put(length, 2);
+    buffer.push_back(type);
+    put(stockLocate, 2);
+    put(0, 2);
+    put(timestamp++, 6);
+}
+
+void ItchWriter::put(std::uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+        buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+void ItchWriter::putStock(const std::string& symbol)
+{
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        buffer.push_back(i < symbol.size() ? symbol[i] : ' ');
+    }
+}
+
+// Only the stock field is filled in, the rest of the directory entry is zeroed
+void ItchWriter::stockDirectory(int stockLocate, const std::string& symbol)
+{
+    header('R', stockLocate, stockDirectoryLength);
+    putStock(symbol);
+    buffer.insert(buffer.end(), stockDirectoryLength - headerLength - 8, 0);
+}
+
+void ItchWriter::addOrder(int stockLocate, std::uint64_t reference, bool buyOrSell, int shares, const std::string& symbol, int price)
+{
+    header('A', stockLocate, addOrderLength);
+    put(reference, 8);
+    buffer.push_back(buyOrSell ? 'B' : 'S');
+    put(shares, 4);
+    putStock(symbol);
+    put(price, 4);
+}
+
+void ItchWriter::orderExecuted(int stockLocate, std::uint64_t reference, int shares)
+{
+    header('E', stockLocate, orderExecutedLength);
+    put(reference, 8);
+    put(shares, 4);
+    put(0, 8);
+}
+
+void ItchWriter::orderCancel(int stockLocate, std::uint64_t reference, int shares)
+{
+    header('X', stockLocate, orderCancelLength);
+    put(reference, 8);
+    put(shares, 4);
+}
+
+void ItchWriter::orderDelete(int stockLocate, std::uint64_t reference)
+{
+    header('D', stockLocate, orderDeleteLength);
+    put(reference, 8);
+}
+
+void ItchWriter::orderReplace(int stockLocate, std::uint64_t reference, std::uint64_t newReference, int shares, int price)
+{
+    header('U', stockLocate, orderReplaceLength);
+    put(reference, 8);
+    put(newReference, 8);
+    put(shares, 4);
+    put(price, 4);
+}
+
+void ItchWriter::systemEvent(char eventCode)
+{
+    header('S', 0, 12);
+    buffer.push_back(eventCode);
+}
+
+const std::vector<unsigned char>& ItchWriter::getBuffer() const
+{
+    return buffer;
+}
+
+bool ItchWriter::save(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening ITCH file: " << filename << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    return file.good();
+}
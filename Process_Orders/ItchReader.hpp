@@ -0,0 +1,92 @@
+#ifndef ITCHREADER_HPP
+#define ITCHREADER_HPP
+
+#include "Command.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Book;
+
+// Reads NASDAQ TotalView-ITCH 5.0 order messages for one symbol from a memory-mapped file.
+// The file is a sequence of messages each prefixed by a 2 byte big-endian length, as in
+// NASDAQ's historical ITCH files. Fields are decoded straight out of the mapping without
+// copying messages. Add Order (A, F) becomes AddLimit, Order Executed (E, C) and Order Cancel (X)
+// become ModifyLimit with the remaining shares or CancelLimit once nothing is left, Order
+// Delete (D) becomes CancelLimit and Order Replace (U) becomes CancelLimit followed by AddLimit
+// of the original order, since a replace always loses priority.
+// Prices keep ITCH's four implied decimal places.
+class ItchReader {
+private:
+    // What the book needs to know about a live ITCH order reference
+    struct ItchOrder {
+        int orderId;
+        int shares;
+        int price;
+        bool buyOrSell;
+    };
+
+    const unsigned char* data;
+    std::size_t size;
+    char stock[8];
+    int stockLocate;
+    int nextOrderId;
+    std::unordered_map<std::uint64_t, ItchOrder> orders;
+    std::uint64_t messageCount;
+    std::uint64_t commandCount;
+
+    template <typename Handler>
+    void parse(Handler&& handler);
+    template <typename Handler>
+    void reduceOrder(std::uint64_t reference, int shares, Handler& handler);
+
+public:
+    ItchReader();
+    ~ItchReader();
+
+    ItchReader(const ItchReader&) = delete;
+    ItchReader& operator=(const ItchReader&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+    // Stock symbol as it appears in the messages, without the space padding
+    void selectSymbol(const std::string& symbol);
+
+    // Each call parses the file from the start with fresh order state
+    std::size_t replay(Book* book);
+    std::vector<Command> readCommands();
+
+    std::uint64_t getMessageCount() const;
+    std::uint64_t getCommandCount() const;
+    int getStockLocate() const;
+};
+
+// Encodes ITCH 5.0 messages with their length prefixes, for building test and benchmark files
+class ItchWriter {
+private:
+    std::vector<unsigned char> buffer;
+    std::uint64_t timestamp;
+
+    void header(char type, int stockLocate, std::size_t length);
+    void put(std::uint64_t value, int bytes);
+    void putStock(const std::string& symbol);
+
+public:
+    ItchWriter();
+
+    void stockDirectory(int stockLocate, const std::string& symbol);
+    void addOrder(int stockLocate, std::uint64_t reference, bool buyOrSell, int shares, const std::string& symbol, int price);
+    void orderExecuted(int stockLocate, std::uint64_t reference, int shares);
+    void orderCancel(int stockLocate, std::uint64_t reference, int shares);
+    void orderDelete(int stockLocate, std::uint64_t reference);
+    void orderReplace(int stockLocate, std::uint64_t reference, std::uint64_t newReference, int shares, int price);
+    void systemEvent(char eventCode);
+
+    const std::vector<unsigned char>& getBuffer() const;
+    bool save(const std::string& filename) const;
+};
+
+#endif
@@ -1,11 +1,22 @@
 #include "OrderPipeline.hpp"
+#include "ItchReader.hpp"
+#include "CommandTokenizer.hpp"
 #include "../Limit_Order_Book/Book.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <random>
 #include <chrono>
+#include <cstring>
+#include <memory>
 
 OrderPipeline::OrderPipeline(Book* book) : book(book) {
     orderFunctions = {
@@ -19,7 +30,24 @@ OrderPipeline::OrderPipeline(Book* book) : book(book) {
         {"ModifyStop", &OrderPipeline::processModifyStopOrder},
         {"AddStopLimit", &OrderPipeline::processAddStopLimitOrder},
         {"CancelStopLimit", &OrderPipeline::processCancelStopLimitOrder},
-        {"ModifyStopLimit", &OrderPipeline::processModifyStopLimitOrder}
+        {"ModifyStopLimit", &OrderPipeline::processModifyStopLimitOrder},
+        {"ImmediateOrCancel", &OrderPipeline::processImmediateOrCancelOrder},
+        {"FillOrKill", &OrderPipeline::processFillOrKillOrder},
+        {"AddIceberg", &OrderPipeline::processAddIcebergOrder},
+        {"AddPegged", &OrderPipeline::processAddPeggedOrder},
+        {"CancelPegged", &OrderPipeline::processCancelPeggedOrder},
+        {"AddTrailing", &OrderPipeline::processAddTrailingStopOrder},
+        {"CancelTrailing", &OrderPipeline::processCancelTrailingStopOrder},
+        {"AddLimitUntil", &OrderPipeline::processAddGoodTillTimeOrder},
+        {"ClockTick", &OrderPipeline::processClockTick},
+        {"AddLimitFor", &OrderPipeline::processAddOwnedLimitOrder},
+        {"MarketFor", &OrderPipeline::processOwnedMarketOrder},
+        {"MarketProtected", &OrderPipeline::processProtectedMarketOrder},
+        {"MarketProtectedFor", &OrderPipeline::processOwnedProtectedMarketOrder},
+        {"CancelOwner", &OrderPipeline::processCancelOwnerOrders},
+        {"MassCancel", &OrderPipeline::processMassCancel},
+        {"AuctionBegin", &OrderPipeline::processAuctionBegin},
+        {"AuctionEnd", &OrderPipeline::processAuctionEnd}
     };
 }
 
@@ -67,6 +95,155 @@ void OrderPipeline::processOrdersFromFile(const std::string& filename)
     csvFile.close();
 }
 
+// Split the mapped file into line-aligned chunks for the workers and apply the parsed chunks in file order
+std::size_t OrderPipeline::processOrdersParallel(const std::string& filename, int workers, std::size_t chunkSize)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return 0;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    void* mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return 0;
+    }
+    workers = std::max(workers, 1);
+    const char* data = static_cast<const char*>(mapping);
+
+    // Chunks end just after a newline so no line is split between two workers
+    std::vector<std::pair<const char*, const char*>> bounds;
+    const char* begin = data;
+    const char* fileEnd = data + size;
+    while (begin < fileEnd) {
+        const char* end = fileEnd - begin > static_cast<off_t>(chunkSize) ? begin + chunkSize : fileEnd;
+        const char* newline = end < fileEnd ? static_cast<const char*>(std::memchr(end, '\n', fileEnd - end)) : nullptr;
+        end = newline == nullptr ? fileEnd : newline + 1;
+        bounds.emplace_back(begin, end);
+        begin = end;
+    }
+
+    // Parsed chunks go through a ring of slots, so workers run at most slotCount chunks ahead of
+    // the matcher and memory stays bounded however large the file is. A slot's filled value is
+    // the index of the chunk it holds plus one.
+    struct ChunkSlot {
+        std::vector<Command> commands;
+        std::atomic<std::size_t> filled{0};
+    };
+    const std::size_t slotCount = 2 * workers;
+    std::unique_ptr<ChunkSlot[]> slots(new ChunkSlot[slotCount]);
+    std::atomic<std::size_t> appliedChunks(0);
+    std::atomic<std::size_t> nextChunk(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back([&]() {
+            for (std::size_t chunk = nextChunk.fetch_add(1); chunk < bounds.size(); chunk = nextChunk.fetch_add(1)) {
+                while (chunk >= appliedChunks.load(std::memory_order_acquire) + slotCount) {
+                    std::this_thread::yield();
+                }
+                ChunkSlot& slot = slots[chunk % slotCount];
+                slot.commands.reserve((bounds[chunk].second - bounds[chunk].first) / 16);
+                tokenizeCommands(bounds[chunk].first, bounds[chunk].second, slot.commands);
+                slot.filled.store(chunk + 1, std::memory_order_release);
+            }
+        });
+    }
+
+    // Chunks are claimed in order, so the next chunk to apply is always the oldest one in progress
+    std::size_t applied = 0;
+    for (std::size_t chunk = 0; chunk < bounds.size(); chunk++) {
+        ChunkSlot& slot = slots[chunk % slotCount];
+        while (slot.filled.load(std::memory_order_acquire) != chunk + 1) {
+            std::this_thread::yield();
+        }
+        for (const Command& command : slot.commands) {
+            applyCommand(book, command);
+        }
+        applied += slot.commands.size();
+        // Keep the capacity for the chunk that reuses this slot
+        slot.commands.clear();
+        appliedChunks.store(chunk + 1, std::memory_order_release);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    munmap(mapping, size);
+    return applied;
+}
+
+std::size_t OrderPipeline::processOrdersAsync(const std::string& filename, AsyncFileReader::Backend backend, std::size_t bufferSize, int bufferCount)
+{
+    AsyncFileReader reader(bufferSize, bufferCount);
+    if (!reader.open(filename, backend)) {
+        return 0;
+    }
+
+    // A line split across two buffers is copied into carry and tokenized once it is complete
+    std::string carry;
+    std::vector<Command> commands;
+    std::size_t applied = 0;
+    const char* data;
+    std::size_t size;
+    while (reader.next(data, size)) {
+        const char* begin = data;
+        const char* end = data + size;
+        commands.clear();
+        if (!carry.empty()) {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', size));
+            if (newline == nullptr) {
+                carry.append(begin, end);
+                continue;
+            }
+            carry.append(begin, newline + 1);
+            tokenizeCommands(carry.data(), carry.data() + carry.size(), commands);
+            begin = newline + 1;
+        }
+        const char* lastNewline = static_cast<const char*>(memrchr(begin, '\n', end - begin));
+        const char* linesEnd = lastNewline == nullptr ? begin : lastNewline + 1;
+        tokenizeCommands(begin, linesEnd, commands);
+        carry.assign(linesEnd, end);
+
+        for (const Command& command : commands) {
+            applyCommand(book, command);
+        }
+        applied += commands.size();
+    }
+
+    commands.clear();
+    tokenizeCommands(carry.data(), carry.data() + carry.size(), commands);
+    for (const Command& command : commands) {
+        applyCommand(book, command);
+    }
+    return applied + commands.size();
+}
+
+std::size_t OrderPipeline::processItchFile(const std::string& filename, const std::string& symbol)
+{
+    ItchReader reader;
+    if (!reader.open(filename))
+    {
+        return 0;
+    }
+    reader.selectSymbol(symbol);
+    return reader.replay(book);
+}
+
+// Parse a whole order file into binary commands without applying them to a book
+std::vector<Command> OrderPipeline::loadCommandsFromFile(const std::string& filename)
+{
+    std::vector<Command> commands;
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return commands;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    tokenizeCommands(text.data(), text.data() + text.size(), commands);
+    return commands;
+}
+
 void OrderPipeline::processMarketOrder(std::istringstream& iss) {
     int orderId, shares;
     bool buyOrSell;
@@ -130,3 +307,114 @@ void OrderPipeline::processModifyStopLimitOrder(std::istringstream& iss) {
     iss >> orderId >> newShares >> newLimitPrice >> newStopPrice;
     book->modifyStopLimitOrder(orderId, newShares, newLimitPrice, newStopPrice);
 }
+
+void OrderPipeline::processImmediateOrCancelOrder(std::istringstream& iss) {
+    int orderId, shares, limitPrice;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice;
+    book->immediateOrCancelOrder(orderId, buyOrSell, shares, limitPrice);
+}
+
+void OrderPipeline::processFillOrKillOrder(std::istringstream& iss) {
+    int orderId, shares, limitPrice;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice;
+    book->fillOrKillOrder(orderId, buyOrSell, shares, limitPrice);
+}
+
+void OrderPipeline::processAddIcebergOrder(std::istringstream& iss) {
+    int orderId, shares, limitPrice, displayShares;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> displayShares;
+    book->addIcebergOrder(orderId, buyOrSell, shares, limitPrice, displayShares);
+}
+
+void OrderPipeline::processAddPeggedOrder(std::istringstream& iss) {
+    int orderId, shares, pegType, offset;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> pegType >> offset;
+    book->addPeggedOrder(orderId, buyOrSell, shares, static_cast<PegType>(pegType), offset);
+}
+
+void OrderPipeline::processCancelPeggedOrder(std::istringstream& iss) {
+    int orderId;
+    iss >> orderId;
+    book->cancelPeggedOrder(orderId);
+}
+
+void OrderPipeline::processAddTrailingStopOrder(std::istringstream& iss) {
+    int orderId, shares, offset;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> offset;
+    book->addTrailingStopOrder(orderId, buyOrSell, shares, offset);
+}
+
+void OrderPipeline::processCancelTrailingStopOrder(std::istringstream& iss) {
+    int orderId;
+    iss >> orderId;
+    book->cancelTrailingStopOrder(orderId);
+}
+
+void OrderPipeline::processAddGoodTillTimeOrder(std::istringstream& iss) {
+    int orderId, shares, limitPrice, expiryTime;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> expiryTime;
+    book->addGoodTillTimeOrder(orderId, buyOrSell, shares, limitPrice, expiryTime);
+}
+
+void OrderPipeline::processClockTick(std::istringstream& iss) {
+    int time, budget;
+    iss >> time >> budget;
+    book->advanceTime(time, budget > 0 ? budget : INT_MAX);
+}
+
+void OrderPipeline::processAddOwnedLimitOrder(std::istringstream& iss) {
+    int orderId, shares, limitPrice, ownerId;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> ownerId;
+    book->addLimitOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
+}
+
+void OrderPipeline::processCancelOwnerOrders(std::istringstream& iss) {
+    int ownerId;
+    iss >> ownerId;
+    book->cancelOwnerOrders(ownerId);
+}
+
+void OrderPipeline::processMassCancel(std::istringstream& iss) {
+    int lowPrice, highPrice;
+    bool buyOrSell;
+    iss >> buyOrSell >> lowPrice >> highPrice;
+    book->massCancel(buyOrSell, lowPrice, highPrice);
+}
+
+void OrderPipeline::processOwnedMarketOrder(std::istringstream& iss) {
+    int orderId, shares, ownerId;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> ownerId;
+    book->marketOrder(orderId, buyOrSell, shares, ownerId);
+}
+
+void OrderPipeline::processProtectedMarketOrder(std::istringstream& iss) {
+    int orderId, shares, protection;
+    bool buyOrSell, restRemainder;
+    iss >> orderId >> buyOrSell >> shares >> protection >> restRemainder;
+    book->protectedMarketOrder(orderId, buyOrSell, shares, protection, restRemainder);
+}
+
+void OrderPipeline::processOwnedProtectedMarketOrder(std::istringstream& iss) {
+    int orderId, shares, protection, ownerId;
+    bool buyOrSell, restRemainder;
+    iss >> orderId >> buyOrSell >> shares >> protection >> restRemainder >> ownerId;
+    book->protectedMarketOrder(orderId, buyOrSell, shares, protection, restRemainder, ownerId);
+}
+
+void OrderPipeline::processAuctionBegin(std::istringstream&) {
+    book->startAuction();
+}
+
+void OrderPipeline::processAuctionEnd(std::istringstream& iss) {
+    int referencePrice;
+    iss >> referencePrice;
+    book->uncrossAuction(referencePrice);
+}
@@ -5,6 +5,9 @@
 #include <unordered_map>
 #include <string_view>
 #include <sstream>
+#include <vector>
+#include "Command.hpp"
+#include "AsyncFileReader.hpp"
 
 class Book;
 
@@ -25,10 +28,39 @@ private:
     void processAddStopLimitOrder(std::istringstream& iss);
     void processCancelStopLimitOrder(std::istringstream& iss);
     void processModifyStopLimitOrder(std::istringstream& iss);
+    void processImmediateOrCancelOrder(std::istringstream& iss);
+    void processFillOrKillOrder(std::istringstream& iss);
+    void processAddIcebergOrder(std::istringstream& iss);
+    void processAddPeggedOrder(std::istringstream& iss);
+    void processCancelPeggedOrder(std::istringstream& iss);
+    void processAddTrailingStopOrder(std::istringstream& iss);
+    void processCancelTrailingStopOrder(std::istringstream& iss);
+    void processAddGoodTillTimeOrder(std::istringstream& iss);
+    void processClockTick(std::istringstream& iss);
+    void processAddOwnedLimitOrder(std::istringstream& iss);
+    void processCancelOwnerOrders(std::istringstream& iss);
+    void processMassCancel(std::istringstream& iss);
+    void processOwnedMarketOrder(std::istringstream& iss);
+    void processProtectedMarketOrder(std::istringstream& iss);
+    void processOwnedProtectedMarketOrder(std::istringstream& iss);
+    void processAuctionBegin(std::istringstream& iss);
+    void processAuctionEnd(std::istringstream& iss);
 
 public:
     OrderPipeline(Book* book);
     void processOrdersFromFile(const std::string& filename);
+    // Workers parse line-aligned chunks of the mapped file into commands while this thread
+    // applies the chunks in file order, giving the same book as processing the file sequentially.
+    // Workers stay at most two chunks per worker ahead of the matcher.
+    std::size_t processOrdersParallel(const std::string& filename, int workers, std::size_t chunkSize=1 << 20);
+    // Streams the file through a ring of aligned buffers with reads in flight while earlier
+    // buffers are tokenized and applied, for files too large to map or keep in page cache
+    std::size_t processOrdersAsync(const std::string& filename, AsyncFileReader::Backend backend=AsyncFileReader::Backend::IoUring,
+        std::size_t bufferSize=1 << 20, int bufferCount=8);
+    // Replay one symbol's order messages from a binary TotalView-ITCH 5.0 file
+    std::size_t processItchFile(const std::string& filename, const std::string& symbol);
+
+    static std::vector<Command> loadCommandsFromFile(const std::string& filename);
 };
 
 #endif
\ No newline at end of file
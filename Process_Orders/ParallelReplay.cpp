@@ -0,0 +1,149 @@
+#include "ParallelReplay.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+LatencyHistogram::LatencyHistogram() : buckets(10000, 0), count(0) {}
+
+void LatencyHistogram::record(std::int64_t nanoseconds)
+{
+    std::size_t bucket = std::min<std::size_t>(std::max<std::int64_t>(nanoseconds, 0) / bucketWidth, buckets.size() - 1);
+    buckets[bucket] += 1;
+    count += 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+}
+
+// Upper edge of the bucket holding the given percentile (0-100)
+std::int64_t LatencyHistogram::percentile(double pct) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    std::uint64_t target = static_cast<std::uint64_t>(pct / 100.0 * (count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+        {
+            return (i + 1) * bucketWidth;
+        }
+    }
+    return buckets.size() * bucketWidth;
+}
+
+std::uint64_t LatencyHistogram::getCount() const
+{
+    return count;
+}
+
+ParallelReplay::ParallelReplay() : heapAllocation(false) {}
+
+ParallelReplay::~ParallelReplay()
+{
+    deleteBooks();
+}
+
+void ParallelReplay::deleteBooks()
+{
+    for (Book* book : books)
+    {
+        delete book;
+    }
+    books.clear();
+}
+
+void ParallelReplay::setInitialCommands(const std::vector<Command>& commands)
+{
+    initialCommands = commands;
+}
+
+void ParallelReplay::addStream(const std::vector<Command>& commands)
+{
+    streams.push_back(commands);
+}
+
+int ParallelReplay::getNumberOfStreams() const
+{
+    return streams.size();
+}
+
+void ParallelReplay::setHeapAllocation(bool enabled)
+{
+    heapAllocation = enabled;
+}
+
+// Build a fresh book per stream, then time every command of every stream across the workers
+ParallelReplay::Report ParallelReplay::run(int threads)
+{
+    deleteBooks();
+    for (std::size_t i = 0; i < streams.size(); i++)
+    {
+        Book* book = new Book(nullptr, heapAllocation);
+        for (const Command& command : initialCommands)
+        {
+            applyCommand(book, command);
+        }
+        books.push_back(book);
+    }
+
+    Report report{threads, 0, 0.0, 0.0, std::vector<ThreadReport>(threads)};
+    std::atomic<int> nextStream(0);
+
+    auto worker = [&](int threadIndex) {
+        ThreadReport& threadReport = report.threadReports[threadIndex];
+        threadReport.booksReplayed = 0;
+        threadReport.commands = 0;
+        int stream;
+        while ((stream = nextStream.fetch_add(1)) < static_cast<int>(streams.size()))
+        {
+            Book* book = books[stream];
+            for (const Command& command : streams[stream])
+            {
+                auto start = std::chrono::steady_clock::now();
+                applyCommand(book, command);
+                auto end = std::chrono::steady_clock::now();
+                threadReport.histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+            threadReport.booksReplayed += 1;
+            threadReport.commands += streams[stream].size();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        workers.emplace_back(worker, i);
+    }
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (const ThreadReport& threadReport : report.threadReports)
+    {
+        report.commands += threadReport.commands;
+    }
+    report.seconds = std::chrono::duration<double>(end - start).count();
+    report.ordersPerSecond = report.commands / report.seconds;
+    return report;
+}
+
+Book* ParallelReplay::getBook(int stream) const
+{
+    return books[stream];
+}
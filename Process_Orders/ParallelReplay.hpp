@@ -0,0 +1,69 @@
+#ifndef PARALLELREPLAY_HPP
+#define PARALLELREPLAY_HPP
+
+#include "Command.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class Book;
+
+// Per command latencies in 10ns buckets up to 100us, anything slower lands in the last bucket
+class LatencyHistogram {
+private:
+    static const int bucketWidth = 10;
+    std::vector<std::uint64_t> buckets;
+    std::uint64_t count;
+
+public:
+    LatencyHistogram();
+
+    void record(std::int64_t nanoseconds);
+    void merge(const LatencyHistogram& other);
+    std::int64_t percentile(double pct) const;
+    std::uint64_t getCount() const;
+};
+
+// Replays K independent command streams into K books on a pool of worker threads.
+// Workers take whole streams off a shared counter, so each book is only touched by one thread.
+class ParallelReplay {
+public:
+    struct ThreadReport {
+        int booksReplayed;
+        std::uint64_t commands;
+        LatencyHistogram histogram;
+    };
+
+    struct Report {
+        int threads;
+        std::uint64_t commands;
+        double seconds;
+        double ordersPerSecond;
+        std::vector<ThreadReport> threadReports;
+    };
+
+private:
+    std::vector<Command> initialCommands;
+    std::vector<std::vector<Command>> streams;
+    std::vector<Book*> books;
+    bool heapAllocation;
+
+    void deleteBooks();
+
+public:
+    ParallelReplay();
+    ~ParallelReplay();
+
+    // Commands applied to every book before timing starts, such as initialOrders.txt
+    void setInitialCommands(const std::vector<Command>& commands);
+    void addStream(const std::vector<Command>& commands);
+    int getNumberOfStreams() const;
+    // Build the books of later runs on the global heap instead of per book pools, to measure allocator contention
+    void setHeapAllocation(bool enabled);
+
+    Report run(int threads);
+    // Book built from a stream by the last run
+    Book* getBook(int stream) const;
+};
+
+#endif
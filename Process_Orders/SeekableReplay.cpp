@@ -0,0 +1,161 @@
+#include "SeekableReplay.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+SeekableReplay::SeekableReplay(std::vector<Command> _commands, std::uint64_t _checkpointInterval)
+    : commands(std::move(_commands)), checkpointInterval(_checkpointInterval), book(nullptr), position(0)
+{
+    if (checkpointInterval == 0)
+    {
+        throw std::invalid_argument("Checkpoint interval must be at least 1");
+    }
+    book = new Book();
+}
+
+SeekableReplay::~SeekableReplay()
+{
+    delete book;
+}
+
+// Checkpoint i holds the book after i * interval commands, starting with the empty book
+void SeekableReplay::buildCheckpoints()
+{
+    Book* replayBook = new Book();
+    checkpoints.clear();
+    checkpoints.push_back(replayBook->serializeSnapshot(0));
+    for (std::uint64_t i = 0; i < commands.size(); i++)
+    {
+        applyCommand(replayBook, commands[i]);
+        if ((i + 1) % checkpointInterval == 0)
+        {
+            checkpoints.push_back(replayBook->serializeSnapshot(i + 1));
+        }
+    }
+    delete replayBook;
+}
+
+// Side file layout: interval, checkpoint count, then each checkpoint's size and bytes
+bool SeekableReplay::saveCheckpoints(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening checkpoint file: " << filename << std::endl;
+        return false;
+    }
+    std::uint64_t count = checkpoints.size();
+    file.write(reinterpret_cast<const char*>(&checkpointInterval), sizeof(checkpointInterval));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const std::vector<char>& checkpoint : checkpoints)
+    {
+        std::uint64_t size = checkpoint.size();
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(checkpoint.data(), size);
+    }
+    return file.good();
+}
+
+// The count and sizes in the file are checked against the command stream and the file length
+// before anything is allocated
+bool SeekableReplay::loadCheckpoints(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    std::uint64_t fileSize = file.is_open() ? static_cast<std::uint64_t>(file.tellg()) : 0;
+    file.seekg(0);
+    std::uint64_t interval, count;
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(&interval), sizeof(interval))
+        || !file.read(reinterpret_cast<char*>(&count), sizeof(count)) || interval != checkpointInterval
+        || count > commands.size() / checkpointInterval + 1)
+    {
+        std::cerr << "Invalid checkpoint file: " << filename << std::endl;
+        return false;
+    }
+    std::vector<std::vector<char>> loaded(count);
+    for (std::vector<char>& checkpoint : loaded)
+    {
+        std::uint64_t size;
+        if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > fileSize - static_cast<std::uint64_t>(file.tellg()))
+        {
+            std::cerr << "Truncated checkpoint file: " << filename << std::endl;
+            return false;
+        }
+        checkpoint.resize(size);
+        if (!file.read(checkpoint.data(), size))
+        {
+            std::cerr << "Truncated checkpoint file: " << filename << std::endl;
+            return false;
+        }
+    }
+    checkpoints = std::move(loaded);
+    return true;
+}
+
+bool SeekableReplay::seek(std::uint64_t sequenceNumber)
+{
+    if (sequenceNumber > commands.size() || checkpoints.empty())
+    {
+        return false;
+    }
+    std::uint64_t checkpoint = std::min<std::uint64_t>(sequenceNumber / checkpointInterval, checkpoints.size() - 1);
+    std::uint64_t checkpointSequence = checkpoint * checkpointInterval;
+    if (sequenceNumber < position || position < checkpointSequence)
+    {
+        // A checkpoint loaded from a file built for another command stream holds the wrong sequence.
+        // Either way the book is left empty at the start of the stream.
+        const std::vector<char>& snapshot = checkpoints[checkpoint];
+        std::uint64_t snapshotSequence = 0;
+        bool restored = book->restoreSnapshot(snapshot.data(), snapshot.size(), &snapshotSequence);
+        if (!restored || snapshotSequence != checkpointSequence)
+        {
+            if (restored)
+            {
+                std::cerr << "Checkpoint " << checkpoint << " holds sequence " << snapshotSequence << " instead of " << checkpointSequence << std::endl;
+            }
+            std::vector<char> empty = Book().serializeSnapshot(0);
+            book->restoreSnapshot(empty.data(), empty.size());
+            position = 0;
+            return false;
+        }
+        position = checkpointSequence;
+    }
+    for (; position < sequenceNumber; position++)
+    {
+        applyCommand(book, commands[position]);
+    }
+    return true;
+}
+
+Book* SeekableReplay::getBook() const
+{
+    return book;
+}
+
+std::uint64_t SeekableReplay::getPosition() const
+{
+    return position;
+}
+
+std::uint64_t SeekableReplay::getNumberOfCommands() const
+{
+    return commands.size();
+}
+
+std::size_t SeekableReplay::getNumberOfCheckpoints() const
+{
+    return checkpoints.size();
+}
+
+std::size_t SeekableReplay::getCheckpointBytes() const
+{
+    std::size_t bytes = 0;
+    for (const std::vector<char>& checkpoint : checkpoints)
+    {
+        bytes += checkpoint.size();
+    }
+    return bytes;
+}
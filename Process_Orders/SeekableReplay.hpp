@@ -0,0 +1,48 @@
+#ifndef SEEKABLEREPLAY_HPP
+#define SEEKABLEREPLAY_HPP
+
+#include "Command.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Book;
+
+// Replays a command stream to any sequence number without starting from the beginning.
+// buildCheckpoints() replays the stream once and keeps a binary snapshot every interval
+// commands. A seek restores the nearest checkpoint at or before the target and applies only
+// the commands after it, or just steps forward when the book is already closer to the target.
+class SeekableReplay {
+private:
+    std::vector<Command> commands;
+    std::uint64_t checkpointInterval;
+    std::vector<std::vector<char>> checkpoints;
+    Book* book;
+    std::uint64_t position;
+
+public:
+    // Throws std::invalid_argument for a checkpoint interval of 0
+    SeekableReplay(std::vector<Command> _commands, std::uint64_t _checkpointInterval);
+    ~SeekableReplay();
+
+    SeekableReplay(const SeekableReplay&) = delete;
+    SeekableReplay& operator=(const SeekableReplay&) = delete;
+
+    void buildCheckpoints();
+    // Checkpoints can be kept in a side file next to the command file instead of being rebuilt
+    bool saveCheckpoints(const std::string& filename) const;
+    bool loadCheckpoints(const std::string& filename);
+
+    // Bring the book to the state after the first sequenceNumber commands. Fails, leaving the
+    // book empty at position 0, if the checkpoint it needs is invalid or from another stream.
+    bool seek(std::uint64_t sequenceNumber);
+
+    Book* getBook() const;
+    std::uint64_t getPosition() const;
+    std::uint64_t getNumberOfCommands() const;
+    std::size_t getNumberOfCheckpoints() const;
+    std::size_t getCheckpointBytes() const;
+};
+
+#endif
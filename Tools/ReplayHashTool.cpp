@@ -0,0 +1,62 @@
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/HashTrace.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Verifies that two builds of the engine produce the same book for the same command stream.
+// Record a trace with each build, then compare the traces. Recording with an interval of 1
+// pins the first divergence to a single command.
+// Usage: ReplayHashTool record <commands file> <trace file> [interval]
+//        ReplayHashTool compare <first trace> <second trace>
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "record" && argc >= 4)
+    {
+        int interval = argc > 4 ? std::stoi(argv[4]) : 1000;
+        if (interval < 1)
+        {
+            std::cerr << "Interval must be at least 1" << std::endl;
+            return 1;
+        }
+        std::vector<Command> commands = OrderPipeline::loadCommandsFromFile(argv[2]);
+        Book* book = new Book();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<HashCheckpoint> trace = recordHashTrace(book, commands, interval);
+        auto end = std::chrono::steady_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+        if (!saveHashTrace(argv[3], trace))
+        {
+            delete book;
+            return 1;
+        }
+        std::cout << "Replayed " << commands.size() << " commands in " << milliseconds << " ms, "
+        << trace.size() << " checkpoints, final hash " << std::hex << book->getStateHash() << std::dec << std::endl;
+        delete book;
+        return 0;
+    }
+    if (mode == "compare" && argc >= 4)
+    {
+        std::vector<HashCheckpoint> first = loadHashTrace(argv[2]);
+        std::vector<HashCheckpoint> second = loadHashTrace(argv[3]);
+        HashDivergence divergence = compareHashTraces(first, second);
+        if (!divergence.diverged)
+        {
+            std::cout << "Traces match over " << first.size() << " checkpoints" << std::endl;
+            return 0;
+        }
+        std::cout << "First divergent sequence number: " << divergence.firstDivergentSequence
+        << " (last matching: " << divergence.lastMatchingSequence << ")" << std::endl;
+        return 2;
+    }
+
+    std::cerr << "Usage: ReplayHashTool record <commands file> <trace file> [interval]" << std::endl;
+    std::cerr << "       ReplayHashTool compare <first trace> <second trace>" << std::endl;
+    return 1;
+}
@@ -0,0 +1,183 @@
+#include "../Limit_Order_Book/Limit.hpp"
+#include "../Limit_Order_Book/Order.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Matching_Engine/BookManager.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+struct BookManagerTests: public ::testing::Test
+{
+    BookManager* manager;
+
+    virtual void SetUp() override{
+        manager = new BookManager(2, 1024);
+    }
+
+    virtual void TearDown() override{
+        delete manager;
+    }
+};
+
+TEST_F(BookManagerTests, TestAddingSymbols){
+    int aapl = manager->addSymbol("AAPL");
+    int msft = manager->addSymbol("MSFT");
+
+    EXPECT_EQ(aapl, 0);
+    EXPECT_EQ(msft, 1);
+    EXPECT_EQ(manager->addSymbol("AAPL"), aapl);
+    EXPECT_EQ(manager->getSymbolId("MSFT"), msft);
+    EXPECT_EQ(manager->getSymbolId("TSLA"), -1);
+    EXPECT_EQ(manager->getSymbol(msft), "MSFT");
+    EXPECT_EQ(manager->getNumberOfSymbols(), 2);
+    EXPECT_NE(manager->getBook(aapl), manager->getBook(msft));
+}
+
+TEST_F(BookManagerTests, TestSymbolsSpreadAcrossShards){
+    for (int i = 0; i < 6; i++)
+    {
+        manager->addSymbol("SYM" + std::to_string(i));
+    }
+
+    EXPECT_EQ(manager->getNumberOfShards(), 2);
+    EXPECT_EQ(manager->getShard(0), 0);
+    EXPECT_EQ(manager->getShard(1), 1);
+    EXPECT_EQ(manager->getShard(4), 0);
+    EXPECT_EQ(manager->getShard(5), 1);
+}
+
+TEST_F(BookManagerTests, TestApplyRoutesToSymbolBook){
+    int aapl = manager->addSymbol("AAPL");
+    int msft = manager->addSymbol("MSFT");
+
+    manager->apply(Command{CommandType::AddLimit, true, 111, 10, 80, 0, aapl});
+    manager->apply(Command{CommandType::AddLimit, true, 111, 25, 90, 0, msft});
+
+    EXPECT_EQ(manager->getBook(aapl)->getHighestBuy()->getLimitPrice(), 80);
+    EXPECT_EQ(manager->getBook(msft)->getHighestBuy()->getLimitPrice(), 90);
+    EXPECT_EQ(manager->getBook(msft)->getHighestBuy()->getTotalVolume(), 25);
+}
+
+TEST_F(BookManagerTests, TestUnknownSymbolIsRejected){
+    int aapl = manager->addSymbol("AAPL");
+
+    EXPECT_FALSE(manager->apply(Command{CommandType::AddLimit, true, 111, 10, 80, 0, 1}));
+    EXPECT_FALSE(manager->apply(Command{CommandType::AddLimit, true, 112, 10, 80, 0, -1}));
+    EXPECT_FALSE(manager->submit(Command{CommandType::AddLimit, true, 113, 10, 80, 0, 7}));
+    EXPECT_TRUE(manager->apply(Command{CommandType::AddLimit, true, 114, 10, 80, 0, aapl}));
+    EXPECT_EQ(manager->getBook(aapl)->getHighestBuy()->getSize(), 1);
+}
+
+TEST_F(BookManagerTests, TestTextCommandsRouteBySymbolPrefix){
+    manager->addSymbol("AAPL");
+    int msft = manager->addSymbol("MSFT");
+
+    Command command;
+    ASSERT_TRUE(parseCommand("Symbol 1 AddLimit 111 1 25 90", command));
+    EXPECT_TRUE(manager->apply(command));
+    ASSERT_TRUE(parseCommand("AddLimit 112 1 10 80", command));
+    EXPECT_TRUE(manager->apply(command));
+
+    EXPECT_EQ(manager->getBook(msft)->getHighestBuy()->getLimitPrice(), 90);
+    EXPECT_EQ(manager->getBook(0)->getHighestBuy()->getLimitPrice(), 80);
+}
+
+TEST_F(BookManagerTests, TestShardsApplyCommandsInOrder){
+    for (int i = 0; i < 4; i++)
+    {
+        manager->addSymbol("SYM" + std::to_string(i));
+    }
+    manager->start();
+
+    for (int orderId = 1; orderId <= 1000; orderId++)
+    {
+        for (int symbolId = 0; symbolId < 4; symbolId++)
+        {
+            manager->submit(Command{CommandType::AddLimit, false, orderId, 2, 100 + orderId % 10, 0, symbolId});
+        }
+    }
+    for (int symbolId = 0; symbolId < 4; symbolId++)
+    {
+        manager->submit(Command{CommandType::Market, true, 2000, 5, 0, 0, symbolId});
+    }
+    manager->stop();
+
+    EXPECT_EQ(manager->getProcessedCount(0) + manager->getProcessedCount(1), 4004);
+    for (int symbolId = 0; symbolId < 4; symbolId++)
+    {
+        Book* book = manager->getBook(symbolId);
+        EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 100);
+        EXPECT_EQ(book->getLowestSell()->getHeadOrder()->getOrderId(), 30);
+        EXPECT_EQ(book->getLowestSell()->getHeadOrder()->getShares(), 1);
+    }
+}
+
+// Shard rebalancing tests
+TEST_F(BookManagerTests, TestMigrateWhileStopped){
+    int aapl = manager->addSymbol("AAPL");
+
+    EXPECT_EQ(manager->getShard(aapl), 0);
+    EXPECT_FALSE(manager->migrate(aapl, 0));
+    EXPECT_TRUE(manager->migrate(aapl, 1));
+
+    EXPECT_EQ(manager->getShard(aapl), 1);
+    EXPECT_TRUE(manager->isHandoffPending(aapl));
+    EXPECT_FALSE(manager->migrate(aapl, 0));
+
+    manager->start();
+    manager->stop();
+
+    EXPECT_FALSE(manager->isHandoffPending(aapl));
+    EXPECT_EQ(manager->getMigrationCount(), 1);
+}
+
+TEST_F(BookManagerTests, TestMigrationKeepsCommandOrder){
+    int aapl = manager->addSymbol("AAPL");
+    manager->start();
+
+    int orderId = 1;
+    for (int round = 0; round < 20; round++)
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            manager->submit(Command{CommandType::AddLimit, true, orderId, 1, 100, 0, aapl});
+            orderId += 1;
+        }
+        manager->migrate(aapl, 1 - manager->getShard(aapl));
+    }
+    manager->submit(Command{CommandType::Market, false, orderId, 1999, 0, 0, aapl});
+    manager->stop();
+
+    Book* book = manager->getBook(aapl);
+    EXPECT_EQ(book->getHighestBuy()->getSize(), 1);
+    EXPECT_EQ(book->getHighestBuy()->getHeadOrder()->getOrderId(), 2000);
+    EXPECT_EQ(manager->getProcessedCount(0) + manager->getProcessedCount(1), 2001);
+}
+
+TEST_F(BookManagerTests, TestRebalanceMovesColdBooksOffBusyShard){
+    for (int i = 0; i < 4; i++)
+    {
+        manager->addSymbol("SYM" + std::to_string(i));
+    }
+    // Symbols 0 and 2 start on shard 0, symbols 1 and 3 on shard 1
+    for (int i = 0; i < 100; i++)
+    {
+        manager->submit(Command{CommandType::AddLimit, true, i + 1, 1, 100, 0, 0});
+    }
+    for (int i = 0; i < 30; i++)
+    {
+        manager->submit(Command{CommandType::AddLimit, true, i + 1, 1, 100, 0, 2});
+    }
+    manager->submit(Command{CommandType::AddLimit, true, 1, 1, 100, 0, 1});
+
+    EXPECT_EQ(manager->rebalance(), 1);
+    EXPECT_EQ(manager->getShard(0), 0);
+    EXPECT_EQ(manager->getShard(2), 1);
+    EXPECT_EQ(manager->rebalance(), 0);
+
+    manager->start();
+    manager->stop();
+
+    EXPECT_EQ(manager->getBook(0)->getHighestBuy()->getTotalVolume(), 100);
+    EXPECT_EQ(manager->getBook(2)->getHighestBuy()->getTotalVolume(), 30);
+}
@@ -1,9 +1,12 @@
 #include "../Limit_Order_Book/Limit.hpp"
 #include "../Limit_Order_Book/Order.hpp"
 #include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/Command.hpp"
 
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
+#include <cstdio>
 
 struct LimitOrderBookTests: public ::testing::Test
 {
@@ -1359,6 +1362,182 @@ TEST_F(LimitOrderBookTests, TestModifyOrderInvalidOrderId){
     EXPECT_EQ(book->searchOrderMap(110), nullptr);
 }
 
+TEST_F(LimitOrderBookTests, TestModifyOrderReduceKeepsPriority){
+    book->addLimitOrder(111, true, 10, 80);
+    book->addLimitOrder(112, true, 20, 80);
+    book->addLimitOrder(113, true, 7, 80);
+
+    book->modifyLimitOrder(111, 4, 80);
+
+    Limit* limit = book->searchLimitMaps(80, true);
+    EXPECT_EQ(limit->getHeadOrder()->getOrderId(), 111);
+    EXPECT_EQ(limit->getHeadOrder()->getShares(), 4);
+    EXPECT_EQ(limit->getTotalVolume(), 31);
+    EXPECT_EQ(limit->getSize(), 3);
+    EXPECT_TRUE(book->checkConsistency());
+
+    // Growing the order, or keeping its size, sends it to the back
+    book->modifyLimitOrder(111, 12, 80);
+    EXPECT_EQ(limit->getHeadOrder()->getOrderId(), 112);
+    EXPECT_EQ(limit->getHeadOrder()->getNextOrder()->getNextOrder()->getOrderId(), 111);
+    EXPECT_EQ(limit->getTotalVolume(), 39);
+    book->modifyLimitOrder(112, 20, 80);
+    EXPECT_EQ(limit->getHeadOrder()->getOrderId(), 113);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestModifyIcebergReduceKeepsPriority){
+    book->addIcebergOrder(111, false, 50, 90, 10);
+    book->addLimitOrder(112, false, 20, 90);
+
+    // The reserve goes first, then the displayed slice
+    book->modifyLimitOrder(111, 25, 90);
+    Order* order = book->searchOrderMap(111);
+    EXPECT_EQ(order->getShares(), 10);
+    EXPECT_EQ(order->getHiddenShares(), 15);
+    book->modifyLimitOrder(111, 6, 90);
+    EXPECT_EQ(order->getShares(), 6);
+    EXPECT_EQ(order->getHiddenShares(), 0);
+
+    Limit* limit = book->searchLimitMaps(90, false);
+    EXPECT_EQ(limit->getHeadOrder()->getOrderId(), 111);
+    EXPECT_EQ(limit->getTotalVolume(), 26);
+    EXPECT_EQ(limit->getHiddenVolume(), 0);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+// Protected market order tests
+TEST_F(LimitOrderBookTests, TestProtectedMarketOrderStopsAtProtection){
+    book->addLimitOrder(1, false, 10, 100);
+    book->addLimitOrder(2, false, 10, 101);
+    book->addLimitOrder(3, false, 10, 105);
+
+    EXPECT_EQ(book->protectedMarketOrder(4, true, 40, 2), 20);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 105);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->searchOrderMap(4), nullptr);
+    EXPECT_EQ(book->executedOrdersCount, 2);
+
+    // With nothing on the other side there is no price to protect
+    EXPECT_EQ(book->protectedMarketOrder(5, false, 10, 2), 10);
+    EXPECT_EQ(book->protectedMarketOrder(6, true, 5, 0), 0);
+    EXPECT_EQ(book->searchOrderMap(3)->getShares(), 5);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestProtectedMarketOrderRestsRemainder){
+    book->addLimitOrder(1, true, 10, 100);
+    book->addLimitOrder(2, true, 10, 99, 7);
+    book->addLimitOrder(3, true, 10, 90);
+
+    EXPECT_EQ(book->protectedMarketOrder(4, false, 25, 3, true, 8), 5);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 97);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 5);
+    EXPECT_EQ(book->searchOrderMap(4)->getOwnerId(), 8);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 90);
+    EXPECT_EQ(book->cancelOwnerOrders(8), 1);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+// Call auction tests
+TEST_F(LimitOrderBookTests, TestAuctionUncrossesAtMostVolume){
+    book->startAuction();
+    book->addLimitOrder(1, true, 10, 102, 7);
+    book->addLimitOrder(2, true, 20, 101);
+    book->addLimitOrder(3, true, 10, 99, 7);
+    book->addLimitOrder(4, false, 15, 99);
+    book->addLimitOrder(5, false, 10, 100);
+    book->addLimitOrder(6, false, 20, 103);
+    book->marketOrder(7, true, 5);
+
+    EXPECT_TRUE(book->inAuction());
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 102);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 99);
+    EXPECT_EQ(book->searchOrderMap(7), nullptr);
+
+    // 100 and 101 both trade 25 with 5 more bid, so buying pressure picks 101
+    int price, volume;
+    ASSERT_TRUE(book->getAuctionPrice(price, volume));
+    EXPECT_EQ(price, 101);
+    EXPECT_EQ(volume, 25);
+    EXPECT_EQ(book->uncrossAuction(), 25);
+    EXPECT_FALSE(book->inAuction());
+    EXPECT_EQ(book->executedOrdersCount, 4);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 101);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 103);
+    EXPECT_EQ(book->searchOrderMap(1), nullptr);
+    EXPECT_EQ(book->searchOrderMap(4), nullptr);
+    EXPECT_EQ(book->searchOrderMap(5), nullptr);
+    EXPECT_FALSE(book->getAuctionPrice(price, volume));
+    EXPECT_TRUE(book->checkConsistency());
+    EXPECT_EQ(book->cancelOwnerOrders(7), 1);
+}
+
+TEST_F(LimitOrderBookTests, TestAuctionPriceTieBreaks){
+    book->startAuction();
+    book->addLimitOrder(1, true, 10, 103);
+    book->addLimitOrder(2, true, 5, 101);
+    book->addLimitOrder(3, false, 20, 100);
+
+    // 100 and 101 both trade 15 with 5 more offered, so selling pressure picks 100
+    int price, volume;
+    ASSERT_TRUE(book->getAuctionPrice(price, volume));
+    EXPECT_EQ(price, 100);
+    EXPECT_EQ(volume, 15);
+
+    // 100 and 103 both trade 10 with nothing left over, so the reference price decides
+    book->cancelLimitOrder(2);
+    book->modifyLimitOrder(3, 10, 100);
+    ASSERT_TRUE(book->getAuctionPrice(price, volume, 102));
+    EXPECT_EQ(price, 103);
+    ASSERT_TRUE(book->getAuctionPrice(price, volume, 101));
+    EXPECT_EQ(price, 100);
+    EXPECT_EQ(volume, 10);
+    EXPECT_EQ(book->uncrossAuction(102), 10);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestAuctionHoldsStopsAndFillsIcebergs){
+    book->startAuction();
+    book->addIcebergOrder(1, true, 30, 100, 10);
+    book->addLimitOrder(2, false, 25, 99);
+    book->addLimitOrder(3, false, 10, 101);
+    book->addStopOrder(4, true, 5, 99);
+    EXPECT_EQ(book->immediateOrCancelOrder(5, true, 10, 101), 0);
+    EXPECT_FALSE(book->fillOrKillOrder(6, true, 10, 101));
+    EXPECT_NE(book->searchStopMap(99), nullptr);
+
+    // The iceberg's reserve counts, so all 25 offered shares trade at 100
+    EXPECT_EQ(book->uncrossAuction(), 25);
+    EXPECT_EQ(book->searchOrderMap(1)->getShares(), 5);
+    EXPECT_EQ(book->searchOrderMap(1)->getHiddenShares(), 0);
+    EXPECT_EQ(book->searchOrderMap(2), nullptr);
+    // The stop waits for the uncross and then buys from the remaining offer
+    EXPECT_EQ(book->searchStopMap(99), nullptr);
+    EXPECT_EQ(book->searchOrderMap(4), nullptr);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 5);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestAuctionSurvivesSnapshot){
+    book->startAuction();
+    book->addLimitOrder(1, true, 10, 101);
+    book->addLimitOrder(2, false, 10, 100);
+
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_TRUE(restored.inAuction());
+    EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+    restored.addLimitOrder(3, false, 5, 99);
+    EXPECT_EQ(restored.getLowestSell()->getLimitPrice(), 99);
+    EXPECT_EQ(restored.uncrossAuction(), 10);
+    EXPECT_TRUE(restored.checkConsistency());
+}
+
 // Limit order that is a market order tests
 TEST_F(LimitOrderBookTests, TestAddingSellLimitOrderWhichIsAMarketOrder) {
     book->addLimitOrder(357, true, 40, 100);
@@ -2240,4 +2419,1028 @@ TEST_F(LimitOrderBookTests, TestStopOrdersAndStopLimitOrdersMoreComplexCase){
     EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 288);
     EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 43639);
     EXPECT_EQ(book->getHighestStopSell(), nullptr);
-}
\ No newline at end of file
+}
+// Object pool tests
+TEST(ObjectPoolTests, TestFreedSlotsAreReused){
+    ObjectPool<Order> pool(2);
+
+    Order* order1 = pool.create(1, true, 10, 100);
+    Order* order2 = pool.create(2, false, 20, 110);
+    Order* order3 = pool.create(3, true, 30, 90);
+
+    EXPECT_EQ(pool.size(), 3);
+    EXPECT_EQ(order2->getShares(), 20);
+
+    pool.destroy(order2);
+    Order* order4 = pool.create(4, true, 40, 95);
+
+    EXPECT_EQ(order4, order2);
+    EXPECT_EQ(order4->getOrderId(), 4);
+    EXPECT_EQ(order1->getOrderId(), 1);
+    EXPECT_EQ(order3->getOrderId(), 3);
+    EXPECT_EQ(pool.size(), 3);
+}
+
+TEST(ObjectPoolTests, TestArenaBackedPoolStaysInsideArena){
+    std::vector<char> region(1 << 16);
+    Arena arena(region.data(), region.size());
+    ObjectPool<Order> pool(4, &arena);
+
+    Order* order1 = pool.create(1, true, 10, 100);
+    void* block = arena.allocate(100);
+    arena.deallocate(block, 100);
+
+    EXPECT_TRUE(arena.contains(order1));
+    EXPECT_EQ(arena.allocate(100), block);
+    EXPECT_THROW(arena.allocate(1 << 17), std::bad_alloc);
+}
+
+TEST(ObjectPoolTests, TestHeapModeTracksLiveObjects){
+    ObjectPool<Order> pool(2, nullptr, true);
+
+    Order* order1 = pool.create(1, true, 10, 100);
+    Order* order2 = pool.create(2, false, 20, 110);
+    Order* order3 = pool.create(3, true, 30, 90);
+    pool.destroy(order2);
+    pool.destroy(order3);
+
+    EXPECT_EQ(pool.size(), 1);
+    EXPECT_EQ(order1->getShares(), 10);
+    pool.create(4, true, 40, 95);
+    pool.reset();
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(pool.create(5, true, 50, 95)->getOrderId(), 5);
+}
+
+TEST(ObjectPoolTests, TestHeapAllocatedBookMatchesPooledBook){
+    Book pooled;
+    Book heap(nullptr, true);
+    for (Book* target : {&pooled, &heap})
+    {
+        target->addLimitOrder(1, true, 10, 90);
+        target->addLimitOrder(2, false, 10, 110);
+        target->addLimitOrder(3, true, 5, 95);
+        target->marketOrder(4, false, 12);
+        target->cancelLimitOrder(1);
+    }
+    EXPECT_EQ(heap.getStateHash(), pooled.getStateHash());
+    EXPECT_TRUE(heap.checkConsistency());
+}
+
+// Snapshot tests
+TEST_F(LimitOrderBookTests, TestSnapshotRestoresLevelsAndFIFOOrder){
+    book->addLimitOrder(111, true, 10, 80);
+    book->addLimitOrder(112, true, 20, 80);
+    book->addLimitOrder(113, true, 7, 85);
+    book->addLimitOrder(114, false, 14, 90);
+    book->addLimitOrder(115, false, 3, 95);
+    book->addStopOrder(116, false, 5, 70);
+    book->addStopLimitOrder(117, true, 6, 101, 100);
+
+    std::vector<char> snapshot = book->serializeSnapshot(42);
+    Book restored;
+    std::uint64_t sequenceNumber = 0;
+
+    EXPECT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size(), &sequenceNumber));
+
+    EXPECT_EQ(sequenceNumber, 42);
+    EXPECT_EQ(restored.getHighestBuy()->getLimitPrice(), 85);
+    EXPECT_EQ(restored.getLowestSell()->getLimitPrice(), 90);
+    EXPECT_EQ(restored.getHighestStopSell()->getLimitPrice(), 70);
+    EXPECT_EQ(restored.getLowestStopBuy()->getLimitPrice(), 100);
+    EXPECT_EQ(restored.searchLimitMaps(80, true)->getTotalVolume(), 30);
+    EXPECT_EQ(restored.searchLimitMaps(80, true)->getHeadOrder()->getOrderId(), 111);
+    EXPECT_EQ(restored.searchStopMap(100)->getHeadOrder()->getLimit(), 101);
+    EXPECT_EQ(restored.searchOrderMap(112)->getShares(), 20);
+
+    restored.marketOrder(118, false, 12);
+
+    EXPECT_EQ(restored.getHighestBuy()->getLimitPrice(), 80);
+    EXPECT_EQ(restored.getHighestBuy()->getHeadOrder()->getShares(), 5);
+}
+
+TEST_F(LimitOrderBookTests, TestSnapshotBuildsBalancedTree){
+    for (int i = 1; i <= 100; i++)
+    {
+        book->addLimitOrder(i, true, 10, i);
+    }
+
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    restored.restoreSnapshot(snapshot.data(), snapshot.size());
+
+    std::vector<int> prices = restored.inOrderTreeTraversal(restored.getBuyTree());
+    EXPECT_EQ(prices.size(), 100);
+    EXPECT_TRUE(std::is_sorted(prices.begin(), prices.end()));
+    EXPECT_EQ(restored.getLimitHeight(restored.getBuyTree()), 7);
+    EXPECT_EQ(restored.getBuyTree()->getParent(), nullptr);
+    EXPECT_EQ(restored.getHighestBuy()->getLimitPrice(), 100);
+
+    for (int i = 1; i <= 50; i++)
+    {
+        restored.cancelLimitOrder(i);
+    }
+    EXPECT_EQ(restored.inOrderTreeTraversal(restored.getBuyTree()).size(), 50);
+    EXPECT_EQ(restored.getHighestBuy()->getLimitPrice(), 100);
+}
+
+TEST_F(LimitOrderBookTests, TestSnapshotReplacesExistingBook){
+    book->addLimitOrder(111, true, 10, 80);
+    std::vector<char> snapshot = book->serializeSnapshot();
+
+    Book restored;
+    restored.addLimitOrder(200, false, 50, 120);
+    restored.restoreSnapshot(snapshot.data(), snapshot.size());
+
+    EXPECT_EQ(restored.getLowestSell(), nullptr);
+    EXPECT_EQ(restored.searchOrderMap(200), nullptr);
+    EXPECT_EQ(restored.getHighestBuy()->getTotalVolume(), 10);
+}
+
+TEST_F(LimitOrderBookTests, TestSnapshotRejectsInvalidData){
+    book->addLimitOrder(111, true, 10, 80);
+    std::vector<char> snapshot = book->serializeSnapshot();
+
+    Book restored;
+    EXPECT_FALSE(restored.restoreSnapshot(snapshot.data(), 4));
+    EXPECT_FALSE(restored.restoreSnapshot(snapshot.data(), snapshot.size() - 1));
+    snapshot.push_back(0);
+    EXPECT_FALSE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(restored.getHighestBuy(), nullptr);
+}
+
+TEST_F(LimitOrderBookTests, TestSaveAndLoadSnapshotFile){
+    book->addLimitOrder(111, false, 10, 80);
+    book->addLimitOrder(112, false, 15, 80);
+
+    EXPECT_TRUE(book->saveSnapshot("test_snapshot.bin", 7));
+
+    Book restored;
+    std::uint64_t sequenceNumber = 0;
+    EXPECT_TRUE(restored.loadSnapshot("test_snapshot.bin", &sequenceNumber));
+    std::remove("test_snapshot.bin");
+
+    EXPECT_EQ(sequenceNumber, 7);
+    EXPECT_EQ(restored.getLowestSell()->getTotalVolume(), 25);
+    EXPECT_FALSE(restored.loadSnapshot("missing_snapshot.bin"));
+}
+
+// Consistency check tests
+TEST_F(LimitOrderBookTests, TestConsistencyCheckAfterMatchingAndRemoval){
+    for (int i = 1; i <= 50; i++)
+    {
+        book->addLimitOrder(i, i % 2 == 0, 10, i % 2 == 0 ? 100 - i : 100 + i);
+    }
+    book->addStopOrder(51, true, 5, 140);
+    book->addStopLimitOrder(52, false, 5, 55, 60);
+    book->cancelLimitOrder(10);
+    book->modifyLimitOrder(12, 4, 120);
+    book->marketOrder(53, true, 35);
+    book->marketOrder(54, false, 25);
+
+    EXPECT_TRUE(book->checkConsistency());
+
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    restored.restoreSnapshot(snapshot.data(), snapshot.size());
+
+    EXPECT_TRUE(restored.checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestBookInsideArena){
+    std::vector<char> region(1 << 20);
+    Arena arena(region.data(), region.size());
+    Book* arenaBook = new (arena.allocate(sizeof(Book))) Book(&arena);
+
+    arenaBook->addLimitOrder(1, true, 10, 80);
+    arenaBook->addLimitOrder(2, false, 10, 90);
+    arenaBook->marketOrder(3, true, 4);
+
+    EXPECT_TRUE(arena.contains(arenaBook->searchOrderMap(1)));
+    EXPECT_TRUE(arena.contains(arenaBook->getLowestSell()));
+    EXPECT_EQ(arenaBook->getLowestSell()->getTotalVolume(), 6);
+    EXPECT_TRUE(arenaBook->checkConsistency());
+    arenaBook->~Book();
+}
+
+// Immediate or cancel and fill or kill tests
+TEST_F(LimitOrderBookTests, TestImmediateOrCancelDiscardsRemainder){
+    book->addLimitOrder(1, false, 10, 101);
+    book->addLimitOrder(2, false, 20, 102);
+    book->addLimitOrder(3, false, 30, 104);
+
+    EXPECT_EQ(book->immediateOrCancelOrder(9, true, 40, 103), 30);
+
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 104);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->searchLimitMaps(103, true), nullptr);
+    EXPECT_EQ(book->searchOrderMap(9), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+
+    EXPECT_EQ(book->immediateOrCancelOrder(10, false, 5, 90), 0);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->immediateOrCancelOrder(11, true, 5, 105), 5);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 25);
+}
+
+TEST_F(LimitOrderBookTests, TestFillOrKillAllOrNothing){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, true, 20, 98);
+    book->addLimitOrder(3, true, 30, 96);
+    std::uint64_t hashBefore = book->getStateHash();
+
+    EXPECT_FALSE(book->fillOrKillOrder(9, false, 31, 98));
+    EXPECT_FALSE(book->fillOrKillOrder(10, false, 61, 90));
+    EXPECT_EQ(book->getStateHash(), hashBefore);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 10);
+
+    EXPECT_TRUE(book->fillOrKillOrder(11, false, 45, 96));
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 96);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 15);
+    EXPECT_EQ(book->searchOrderMap(11), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestFillOrKillVolumeCheckWalksLevelsInOrder){
+    // Insertion order that leaves the edges deep inside a rebalanced tree
+    std::vector<int> prices = {150, 120, 180, 110, 130, 170, 190, 105, 115, 125, 135, 101, 160, 175, 200};
+    int orderId = 1;
+    for (int price : prices)
+    {
+        book->addLimitOrder(orderId++, false, price - 100, price);
+        book->addLimitOrder(orderId++, true, price - 100, price - 100);
+    }
+    std::vector<int> sorted = prices;
+    std::sort(sorted.begin(), sorted.end());
+    for (int limit : {100, 101, 110, 134, 150, 199, 250})
+    {
+        int available = 0;
+        for (int price : sorted)
+        {
+            available += price <= limit ? price - 100 : 0;
+        }
+        std::uint64_t hashBefore = book->getStateHash();
+        EXPECT_FALSE(book->fillOrKillOrder(orderId++, true, available + 1, limit));
+        EXPECT_EQ(book->getStateHash(), hashBefore);
+
+        int buyAvailable = 0;
+        for (int price : sorted)
+        {
+            buyAvailable += price - 100 >= limit - 100 ? price - 100 : 0;
+        }
+        EXPECT_FALSE(book->fillOrKillOrder(orderId++, false, buyAvailable + 1, limit - 100));
+        EXPECT_EQ(book->getStateHash(), hashBefore);
+    }
+    EXPECT_TRUE(book->fillOrKillOrder(orderId++, true, 1 + 5 + 10 + 15, 115));
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 120);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestFillOrKillCountsPeggedOrders){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, false, 10, 105);
+    // Priced at the midpoint, 102
+    book->addPeggedOrder(3, false, 50, PegType::Midpoint, 0);
+    book->addPeggedOrder(4, false, 50, PegType::Market, 5);
+    std::uint64_t hashBefore = book->getStateHash();
+
+    EXPECT_FALSE(book->fillOrKillOrder(9, true, 51, 103));
+    EXPECT_EQ(book->getStateHash(), hashBefore);
+
+    EXPECT_TRUE(book->fillOrKillOrder(10, true, 40, 103));
+    int price = 0;
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 102);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+
+    // The rest of the midpoint peg, then the market peg at 104 ahead of the level at 105
+    EXPECT_TRUE(book->fillOrKillOrder(11, true, 20, 105));
+    EXPECT_FALSE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+    EXPECT_FALSE(book->fillOrKillOrder(12, true, 51, 110));
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+// Iceberg order tests
+TEST_F(LimitOrderBookTests, TestIcebergShowsOnlyDisplaySize){
+    book->addLimitOrder(1, false, 10, 101);
+    book->addIcebergOrder(2, false, 100, 101, 20);
+
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 30);
+    EXPECT_EQ(book->getLowestSell()->getHiddenVolume(), 80);
+    EXPECT_EQ(book->searchOrderMap(2)->getShares(), 20);
+    EXPECT_EQ(book->searchOrderMap(2)->getHiddenShares(), 80);
+    EXPECT_TRUE(book->checkConsistency());
+
+    book->addIcebergOrder(3, true, 15, 101, 5);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 15);
+    EXPECT_EQ(book->getLowestSell()->getHeadOrder()->getOrderId(), 2);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestIcebergReplenishesAtTailOfSameLevel){
+    book->addIcebergOrder(1, false, 50, 101, 20);
+    book->addLimitOrder(2, false, 10, 101);
+    Limit* level = book->getLowestSell();
+    Order* iceberg = book->searchOrderMap(1);
+
+    book->marketOrder(3, true, 20);
+
+    EXPECT_EQ(book->getLowestSell(), level);
+    EXPECT_EQ(book->searchOrderMap(1), iceberg);
+    EXPECT_EQ(level->getHeadOrder()->getOrderId(), 2);
+    EXPECT_EQ(level->getHeadOrder()->getNextOrder(), iceberg);
+    EXPECT_EQ(iceberg->getShares(), 20);
+    EXPECT_EQ(iceberg->getHiddenShares(), 10);
+    EXPECT_EQ(level->getTotalVolume(), 30);
+    EXPECT_EQ(level->getSize(), 2);
+    EXPECT_TRUE(book->checkConsistency());
+
+    // Last slice is smaller than the display size
+    book->marketOrder(4, true, 30);
+    EXPECT_EQ(level->getHeadOrder(), iceberg);
+    EXPECT_EQ(iceberg->getShares(), 10);
+    EXPECT_EQ(iceberg->getHiddenShares(), 0);
+    EXPECT_EQ(level->getTotalVolume(), 10);
+    EXPECT_TRUE(book->checkConsistency());
+
+    book->marketOrder(5, true, 10);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_EQ(book->searchOrderMap(1), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestIcebergReserveFillsSweepingOrders){
+    book->addIcebergOrder(1, true, 95, 99, 10);
+    book->addLimitOrder(2, true, 7, 99);
+    book->addLimitOrder(3, true, 40, 98);
+
+    // A sweep takes every slice of the reserve before moving to the next level
+    book->addLimitOrder(4, false, 110, 98);
+    EXPECT_EQ(book->searchOrderMap(1), nullptr);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 98);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 32);
+    EXPECT_TRUE(book->checkConsistency());
+
+    book->addIcebergOrder(5, true, 60, 97, 25);
+    EXPECT_FALSE(book->fillOrKillOrder(6, false, 93, 97));
+    EXPECT_TRUE(book->fillOrKillOrder(7, false, 92, 97));
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestIcebergModifyCancelAndSnapshot){
+    book->addIcebergOrder(1, false, 100, 105, 30);
+    book->modifyLimitOrder(1, 50, 104);
+    Order* iceberg = book->searchOrderMap(1);
+    EXPECT_EQ(iceberg->getShares(), 30);
+    EXPECT_EQ(iceberg->getHiddenShares(), 20);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 104);
+    EXPECT_EQ(book->getLowestSell()->getHiddenVolume(), 20);
+    EXPECT_TRUE(book->checkConsistency());
+
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+    EXPECT_EQ(restored.getLowestSell()->getHiddenVolume(), 20);
+    restored.marketOrder(2, true, 45);
+    EXPECT_EQ(restored.getLowestSell()->getTotalVolume(), 5);
+    EXPECT_TRUE(restored.checkConsistency());
+
+    book->cancelLimitOrder(1);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+// Pegged order tests
+TEST_F(LimitOrderBookTests, TestPeggedPricesFollowBookEdges){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, false, 10, 104);
+    book->addPeggedOrder(3, true, 10, PegType::Primary, 0);
+    book->addPeggedOrder(4, true, 10, PegType::Midpoint, 0);
+    book->addPeggedOrder(5, true, 10, PegType::Market, -2);
+    book->addPeggedOrder(6, false, 10, PegType::Midpoint, 0);
+    book->addPeggedOrder(7, true, 10, PegType::Primary, 10);
+
+    int price = 0;
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 99);
+    EXPECT_TRUE(book->getPeggedPrice(4, price));
+    EXPECT_EQ(price, 101);
+    EXPECT_TRUE(book->getPeggedPrice(5, price));
+    EXPECT_EQ(price, 102);
+    EXPECT_TRUE(book->getPeggedPrice(6, price));
+    EXPECT_EQ(price, 102);
+    // Capped one tick below the best sell
+    EXPECT_TRUE(book->getPeggedPrice(7, price));
+    EXPECT_EQ(price, 103);
+    EXPECT_FALSE(book->getPeggedPrice(8, price));
+
+    // Moving the edges reprices every peg without touching them
+    book->addLimitOrder(8, true, 10, 101);
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 101);
+    EXPECT_TRUE(book->getPeggedPrice(4, price));
+    EXPECT_EQ(price, 102);
+    book->cancelLimitOrder(2);
+    EXPECT_FALSE(book->getPeggedPrice(4, price));
+    EXPECT_FALSE(book->getPeggedPrice(5, price));
+    EXPECT_TRUE(book->getPeggedPrice(7, price));
+    EXPECT_EQ(price, 111);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 10);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestPeggedOrdersMatchBestPriceFirst){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, false, 10, 105);
+    book->addPeggedOrder(3, false, 20, PegType::Midpoint, 0);
+    book->addPeggedOrder(4, false, 20, PegType::Market, 4);
+
+    book->marketOrder(5, true, 15);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+    int price = 0;
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 102);
+
+    // A new best sell moves the midpoint below it
+    book->addLimitOrder(6, false, 4, 102);
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 101);
+    book->addLimitOrder(7, true, 6, 102);
+    EXPECT_FALSE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 102);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 3);
+
+    // A limit order at the peg's price trades first
+    book->addLimitOrder(8, false, 5, 103);
+    EXPECT_TRUE(book->getPeggedPrice(4, price));
+    EXPECT_EQ(price, 103);
+    book->addLimitOrder(9, true, 6, 103);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 103);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 2);
+
+    book->addLimitOrder(10, true, 40, 105);
+    EXPECT_FALSE(book->getPeggedPrice(4, price));
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 105);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 8);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestPeggedPricesHoldDuringASweep){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, true, 10, 98);
+    book->addPeggedOrder(3, true, 30, PegType::Primary, 0);
+
+    // The peg keeps the best buy price it had when the sell arrived, so it trades ahead of 98
+    book->addLimitOrder(4, false, 35, 98);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 98);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 10);
+    int price = 0;
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 98);
+
+    book->marketOrder(5, false, 12);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_FALSE(book->getPeggedPrice(3, price));
+    EXPECT_TRUE(book->checkConsistency());
+
+    // Without a best buy to follow the peg does not trade
+    book->marketOrder(6, false, 10);
+    book->addLimitOrder(7, true, 1, 90);
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 90);
+    book->marketOrder(8, false, 4);
+    EXPECT_FALSE(book->getPeggedPrice(3, price));
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestPeggedCancelAndSnapshot){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, false, 10, 104);
+    book->addPeggedOrder(3, true, 10, PegType::Midpoint, -1);
+    book->addPeggedOrder(4, true, 15, PegType::Midpoint, -1);
+    book->addPeggedOrder(5, false, 20, PegType::Market, 3);
+
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+    EXPECT_TRUE(restored.checkConsistency());
+    int price = 0;
+    EXPECT_TRUE(restored.getPeggedPrice(5, price));
+    EXPECT_EQ(price, 102);
+
+    std::uint64_t hashBefore = book->getStateHash();
+    book->addPeggedOrder(6, true, 5, PegType::Midpoint, -1);
+    book->cancelPeggedOrder(6);
+    EXPECT_EQ(book->getStateHash(), hashBefore);
+    book->cancelPeggedOrder(3);
+    book->cancelPeggedOrder(4);
+    book->cancelPeggedOrder(5);
+    book->cancelPeggedOrder(5);
+    EXPECT_FALSE(book->getPeggedPrice(3, price));
+    EXPECT_TRUE(book->checkConsistency());
+
+    restored.marketOrder(7, false, 20);
+    EXPECT_FALSE(restored.getPeggedPrice(3, price));
+    EXPECT_TRUE(restored.getPeggedPrice(4, price));
+    EXPECT_EQ(restored.getHighestBuy()->getTotalVolume(), 10);
+    EXPECT_TRUE(restored.checkConsistency());
+}
+
+// Trailing stop tests
+TEST_F(LimitOrderBookTests, TestTrailingStopFollowsBestBuy){
+    book->addLimitOrder(1, true, 10, 100);
+    book->addLimitOrder(2, false, 10, 110);
+    book->addTrailingStopOrder(3, false, 5, 3);
+    int stopPrice = 0;
+    EXPECT_TRUE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(stopPrice, 97);
+
+    book->addLimitOrder(4, true, 10, 104);
+    EXPECT_TRUE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(stopPrice, 101);
+
+    // Trading the best buy away drops the price below the stop, which sells into the next level
+    book->marketOrder(5, false, 10);
+    EXPECT_FALSE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 100);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestTrailingStopFollowsBestSell){
+    book->addLimitOrder(1, true, 10, 90);
+    book->addLimitOrder(2, false, 10, 100);
+    book->addTrailingStopOrder(3, true, 5, 2);
+    int stopPrice = 0;
+    EXPECT_TRUE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(stopPrice, 102);
+
+    book->addLimitOrder(4, false, 10, 97);
+    EXPECT_TRUE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(stopPrice, 99);
+
+    book->marketOrder(5, true, 10);
+    EXPECT_FALSE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 100);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 5);
+    EXPECT_TRUE(book->checkConsistency());
+
+    book->addTrailingStopOrder(6, true, 5, 0);
+    EXPECT_FALSE(book->getTrailingStopPrice(6, stopPrice));
+}
+
+TEST_F(LimitOrderBookTests, TestTrailingStopEpochsMerge){
+    book->addLimitOrder(1, true, 10, 100);
+    book->addLimitOrder(2, true, 50, 98);
+    book->addLimitOrder(3, true, 100, 95);
+    book->addTrailingStopOrder(4, false, 10, 5);
+
+    // Stops placed after the price fell trail from the lower price
+    book->marketOrder(5, false, 10);
+    book->addTrailingStopOrder(6, false, 10, 5);
+    book->addTrailingStopOrder(7, false, 4, 3);
+    int stopPrice = 0;
+    EXPECT_TRUE(book->getTrailingStopPrice(4, stopPrice));
+    EXPECT_EQ(stopPrice, 95);
+    EXPECT_TRUE(book->getTrailingStopPrice(6, stopPrice));
+    EXPECT_EQ(stopPrice, 93);
+    EXPECT_TRUE(book->checkConsistency());
+
+    // A new high lifts both epochs to the same water mark
+    book->addLimitOrder(8, true, 10, 101);
+    EXPECT_TRUE(book->getTrailingStopPrice(4, stopPrice));
+    EXPECT_EQ(stopPrice, 96);
+    EXPECT_TRUE(book->getTrailingStopPrice(6, stopPrice));
+    EXPECT_EQ(stopPrice, 96);
+    EXPECT_TRUE(book->getTrailingStopPrice(7, stopPrice));
+    EXPECT_EQ(stopPrice, 98);
+    EXPECT_TRUE(book->checkConsistency());
+
+    book->marketOrder(9, false, 10);
+    EXPECT_FALSE(book->getTrailingStopPrice(7, stopPrice));
+    EXPECT_TRUE(book->getTrailingStopPrice(4, stopPrice));
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 46);
+
+    book->marketOrder(10, false, 46);
+    EXPECT_FALSE(book->getTrailingStopPrice(4, stopPrice));
+    EXPECT_FALSE(book->getTrailingStopPrice(6, stopPrice));
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 95);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 80);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestTrailingStopCancelAndSnapshot){
+    book->addLimitOrder(1, true, 10, 100);
+    book->addLimitOrder(2, false, 10, 110);
+    book->addTrailingStopOrder(3, false, 5, 2);
+    book->addTrailingStopOrder(4, false, 5, 4);
+    book->addTrailingStopOrder(5, true, 5, 3);
+    book->addLimitOrder(6, true, 5, 103);
+
+    std::uint64_t hashBefore = book->getStateHash();
+    book->addTrailingStopOrder(7, false, 5, 9);
+    book->cancelTrailingStopOrder(7);
+    EXPECT_EQ(book->getStateHash(), hashBefore);
+    EXPECT_TRUE(book->checkConsistency());
+
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+    EXPECT_TRUE(restored.checkConsistency());
+    int stopPrice = 0;
+    EXPECT_TRUE(restored.getTrailingStopPrice(4, stopPrice));
+    EXPECT_EQ(stopPrice, 99);
+    EXPECT_TRUE(restored.getTrailingStopPrice(5, stopPrice));
+    EXPECT_EQ(stopPrice, 113);
+
+    book->cancelTrailingStopOrder(3);
+    book->cancelTrailingStopOrder(3);
+    EXPECT_FALSE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_TRUE(book->checkConsistency());
+
+    restored.marketOrder(8, false, 5);
+    EXPECT_FALSE(restored.getTrailingStopPrice(3, stopPrice));
+    EXPECT_TRUE(restored.getTrailingStopPrice(4, stopPrice));
+    EXPECT_EQ(restored.getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_TRUE(restored.checkConsistency());
+}
+
+// Good till time tests
+TEST_F(LimitOrderBookTests, TestGoodTillTimeOrdersExpire){
+    book->addGoodTillTimeOrder(1, true, 10, 100, 5);
+    book->addGoodTillTimeOrder(2, true, 10, 99, 8);
+    book->addLimitOrder(3, true, 10, 98);
+    book->addGoodTillTimeOrder(4, false, 10, 105, 3);
+    book->addGoodTillTimeOrder(5, false, 10, 106, 0);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+    EXPECT_TRUE(book->checkConsistency());
+
+    EXPECT_EQ(book->advanceTime(2), 0);
+    EXPECT_EQ(book->advanceTime(3), 1);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+
+    // A filled order leaves its entry behind, and a new order reusing the id does not expire with it
+    book->marketOrder(6, false, 10);
+    book->addLimitOrder(1, true, 5, 97);
+    EXPECT_EQ(book->advanceTime(5), 0);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 99);
+
+    // Modified orders keep their expiry time
+    book->modifyLimitOrder(2, 20, 101);
+    EXPECT_EQ(book->advanceTime(100), 1);
+    EXPECT_EQ(book->advanceTime(50), 0);
+    EXPECT_EQ(book->getTime(), 100);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 98);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestGoodTillTimeExpiryBudget){
+    for (int i = 1; i <= 10; i++)
+    {
+        book->addGoodTillTimeOrder(i, true, 10, 100 - i, 1000);
+    }
+    EXPECT_EQ(book->advanceTime(1000, 3), 3);
+    EXPECT_EQ(book->getPendingExpiryCount(), 7);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 96);
+
+    // Expired orders over the budget still trade until they are cancelled
+    book->marketOrder(11, false, 5);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_TRUE(book->checkConsistency());
+
+    EXPECT_EQ(book->advanceTime(1000, 100), 7);
+    EXPECT_EQ(book->getPendingExpiryCount(), 0);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestGoodTillTimeWheelLevelsAndSnapshot){
+    // Expiry times on either side of each level boundary of the wheel, and one past all levels
+    std::vector<int> expiries = {1, 63, 64, 4095, 4096, 262143, 262144, 16777215, 16777216, 50000000};
+    for (int i = 0; i < static_cast<int>(expiries.size()); i++)
+    {
+        book->addGoodTillTimeOrder(i + 1, true, 10, 1000 - i, expiries[i]);
+    }
+    EXPECT_TRUE(book->checkConsistency());
+
+    for (int i = 0; i < static_cast<int>(expiries.size()); i++)
+    {
+        if (i == 5)
+        {
+            std::vector<char> snapshot = book->serializeSnapshot();
+            Book restored;
+            ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+            EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+            EXPECT_EQ(restored.getTime(), book->getTime());
+            EXPECT_TRUE(restored.checkConsistency());
+            EXPECT_EQ(restored.advanceTime(expiries.back()), 5);
+            EXPECT_EQ(restored.getHighestBuy(), nullptr);
+        }
+        EXPECT_EQ(book->advanceTime(expiries[i] - 1), 0);
+        EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 1000 - i);
+        EXPECT_EQ(book->advanceTime(expiries[i]), 1);
+    }
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+// Mass cancel tests
+TEST_F(LimitOrderBookTests, TestCancelOwnerOrders){
+    book->addLimitOrder(1, true, 10, 100, 7);
+    book->addLimitOrder(2, true, 10, 100, 8);
+    book->addLimitOrder(3, true, 10, 99, 7);
+    book->addLimitOrder(4, true, 10, 98, 7);
+    book->addLimitOrder(5, false, 10, 105, 7);
+    book->addLimitOrder(6, false, 10, 106, 7);
+    book->addLimitOrder(7, false, 10, 106);
+    book->addLimitOrder(8, false, 10, 107, 7);
+
+    // Fills and single cancels take orders out of their owner's list
+    book->marketOrder(9, false, 15);
+    book->cancelLimitOrder(4);
+    EXPECT_TRUE(book->checkConsistency());
+
+    EXPECT_EQ(book->cancelOwnerOrders(7), 4);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 100);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_EQ(book->getBuyTree()->getLeftChild(), nullptr);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 106);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+    EXPECT_EQ(book->inOrderTreeTraversal(book->getSellTree()), std::vector<int>({106}));
+    EXPECT_TRUE(book->checkConsistency());
+    EXPECT_EQ(book->cancelOwnerOrders(7), 0);
+}
+
+TEST_F(LimitOrderBookTests, TestMassCancelByPriceRange){
+    for (int price = 51; price <= 100; price++)
+    {
+        book->addLimitOrder(price, true, 10, price, price % 3);
+        book->addLimitOrder(price + 100, true, 10, price);
+        book->addLimitOrder(price + 200, false, 10, price + 100);
+    }
+
+    EXPECT_EQ(book->massCancel(true, 80, 89), 20);
+    EXPECT_EQ(book->massCancel(true, 95, 200), 12);
+    std::vector<int> expected;
+    for (int price = 51; price <= 94; price++)
+    {
+        if (price < 80 || price > 89)
+        {
+            expected.push_back(price);
+        }
+    }
+    EXPECT_EQ(book->inOrderTreeTraversal(book->getBuyTree()), expected);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 94);
+    EXPECT_LE(book->getLimitHeight(book->getBuyTree()), 6);
+    EXPECT_EQ(book->massCancel(true, 70, 70), 2);
+    EXPECT_EQ(book->massCancel(true, 80, 89), 0);
+    EXPECT_TRUE(book->checkConsistency());
+
+    EXPECT_EQ(book->massCancel(false), 50);
+    EXPECT_EQ(book->getSellTree(), nullptr);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_EQ(book->cancelOwnerOrders(1), 11);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestMassCancelOfFewLevelsKeepsTreeBalanced){
+    for (int price = 1; price <= 255; price++)
+    {
+        book->addLimitOrder(price, true, 10, price);
+    }
+    int rootPrice = book->getBuyTree()->getLimitPrice();
+
+    EXPECT_EQ(book->massCancel(true, rootPrice - 2, rootPrice + 2), 5);
+    EXPECT_EQ(book->massCancel(true, 1, 3), 3);
+    EXPECT_EQ(book->massCancel(true, 253, 255), 3);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 252);
+    EXPECT_EQ(book->inOrderTreeTraversal(book->getBuyTree()).size(), 244);
+    EXPECT_LE(book->getLimitHeight(book->getBuyTree()), 9);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestOwnerListsSurviveSnapshot){
+    for (int i = 1; i <= 20; i++)
+    {
+        book->addLimitOrder(i, i % 2 == 0, 10, i % 2 == 0 ? 90 - i : 110 + i, i % 4);
+    }
+    std::vector<char> snapshot = book->serializeSnapshot();
+    Book restored;
+    ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+    EXPECT_TRUE(restored.checkConsistency());
+
+    EXPECT_EQ(restored.cancelOwnerOrders(2), 5);
+    EXPECT_EQ(book->cancelOwnerOrders(2), 5);
+    EXPECT_EQ(restored.getStateHash(), book->getStateHash());
+    EXPECT_TRUE(restored.checkConsistency());
+}
+
+// Self-trade prevention tests
+static void addSelfTradeLevels(Book* book)
+{
+    book->addLimitOrder(1, false, 5, 100, 2);
+    book->addLimitOrder(2, false, 10, 100, 1);
+    book->addLimitOrder(3, false, 10, 100, 3);
+    book->addLimitOrder(4, false, 10, 101, 1);
+}
+
+TEST_F(LimitOrderBookTests, TestSelfTradeCancelNewest){
+    book->setSelfTradePrevention(SelfTradePrevention::CancelNewest);
+    addSelfTradeLevels(book);
+    book->addLimitOrder(5, true, 30, 101, 1);
+    EXPECT_EQ(book->searchOrderMap(1), nullptr);
+    EXPECT_EQ(book->searchOrderMap(5), nullptr);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 20);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->getPreventedSelfTradeCount(), 1);
+    EXPECT_TRUE(book->checkConsistency());
+
+    // Orders without an owner are never checked
+    book->addLimitOrder(6, true, 10, 100);
+    EXPECT_EQ(book->searchOrderMap(2), nullptr);
+    EXPECT_EQ(book->getPreventedSelfTradeCount(), 1);
+}
+
+TEST_F(LimitOrderBookTests, TestSelfTradeCancelOldest){
+    book->setSelfTradePrevention(SelfTradePrevention::CancelOldest);
+    addSelfTradeLevels(book);
+    book->addLimitOrder(5, true, 20, 100, 1);
+    EXPECT_EQ(book->searchOrderMap(2), nullptr);
+    EXPECT_EQ(book->searchOrderMap(3), nullptr);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 100);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 101);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+
+    // A market order takes the owner's resting orders off every level it reaches
+    book->addLimitOrder(6, false, 10, 102, 3);
+    book->marketOrder(7, true, 8, 1);
+    EXPECT_EQ(book->searchOrderMap(4), nullptr);
+    EXPECT_EQ(book->searchOrderMap(6)->getShares(), 2);
+    EXPECT_EQ(book->getPreventedSelfTradeCount(), 2);
+
+    // Cancelling the last order on a level does not trade past the limit price
+    book->addLimitOrder(8, false, 10, 101, 1);
+    book->addLimitOrder(9, true, 10, 101, 1);
+    EXPECT_EQ(book->searchOrderMap(6)->getShares(), 2);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 101);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 10);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestSelfTradeCancelBoth){
+    book->setSelfTradePrevention(SelfTradePrevention::CancelBoth);
+    addSelfTradeLevels(book);
+    book->addLimitOrder(5, true, 20, 101, 1);
+    EXPECT_EQ(book->searchOrderMap(1), nullptr);
+    EXPECT_EQ(book->searchOrderMap(2), nullptr);
+    EXPECT_EQ(book->searchOrderMap(5), nullptr);
+    EXPECT_EQ(book->searchOrderMap(3)->getShares(), 10);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestSelfTradeDecrement){
+    book->setSelfTradePrevention(SelfTradePrevention::Decrement);
+    addSelfTradeLevels(book);
+    book->addLimitOrder(5, true, 12, 101, 1);
+    EXPECT_EQ(book->searchOrderMap(2)->getShares(), 3);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 13);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    EXPECT_EQ(book->executedOrdersCount, 1);
+
+    EXPECT_TRUE(book->checkConsistency());
+
+    // Taking the whole of a resting order removes it and the rest keeps matching
+    book->marketOrder(6, true, 15, 1);
+    EXPECT_EQ(book->searchOrderMap(2), nullptr);
+    EXPECT_EQ(book->searchOrderMap(3), nullptr);
+    EXPECT_EQ(book->searchOrderMap(4)->getShares(), 8);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 101);
+    EXPECT_EQ(book->getPreventedSelfTradeCount(), 3);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+TEST_F(LimitOrderBookTests, TestSelfTradeWithPeggedOrders){
+    book->setSelfTradePrevention(SelfTradePrevention::CancelOldest);
+    book->addLimitOrder(10, true, 10, 90);
+    addSelfTradeLevels(book);
+    book->addPeggedOrder(11, false, 10, PegType::Primary, 0);
+    book->addLimitOrder(12, true, 30, 100, 1);
+    int price;
+    EXPECT_FALSE(book->getPeggedPrice(11, price));
+    EXPECT_EQ(book->searchOrderMap(2), nullptr);
+    EXPECT_EQ(book->searchOrderMap(3), nullptr);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 101);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 100);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_TRUE(book->checkConsistency());
+}
+
+// Command dispatch tests
+TEST_F(LimitOrderBookTests, TestApplyImmediateOrCancelAndFillOrKillCommands){
+    book->addLimitOrder(1, false, 20, 101);
+    applyCommand(book, Command{CommandType::FillOrKill, true, 2, 25, 101, 0});
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 20);
+    applyCommand(book, Command{CommandType::ImmediateOrCancel, true, 3, 25, 101, 0});
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyIcebergCommand){
+    applyCommand(book, Command{CommandType::AddIceberg, false, 1, 100, 101, 20});
+    applyCommand(book, Command{CommandType::Market, true, 2, 30});
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 10);
+    EXPECT_EQ(book->getLowestSell()->getHiddenVolume(), 60);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyPeggedCommands){
+    book->addLimitOrder(1, true, 10, 99);
+    book->addLimitOrder(2, false, 10, 103);
+    applyCommand(book, Command{CommandType::AddPegged, false, 3, 5, static_cast<int>(PegType::Midpoint), 0});
+    int price = 0;
+    EXPECT_TRUE(book->getPeggedPrice(3, price));
+    EXPECT_EQ(price, 101);
+    applyCommand(book, Command{CommandType::CancelPegged, false, 3});
+    EXPECT_FALSE(book->getPeggedPrice(3, price));
+}
+
+TEST_F(LimitOrderBookTests, TestApplyTrailingStopCommands){
+    book->addLimitOrder(1, true, 10, 99);
+    applyCommand(book, Command{CommandType::AddTrailingStop, false, 3, 5, 0, 4});
+    int stopPrice = 0;
+    EXPECT_TRUE(book->getTrailingStopPrice(3, stopPrice));
+    EXPECT_EQ(stopPrice, 95);
+    applyCommand(book, Command{CommandType::CancelTrailingStop, false, 3});
+    EXPECT_FALSE(book->getTrailingStopPrice(3, stopPrice));
+}
+
+TEST_F(LimitOrderBookTests, TestApplyGoodTillTimeCommands){
+    // A timestamp moves the clock before the command applies
+    applyCommand(book, Command{CommandType::AddGoodTillTime, true, 3, 10, 99, 20});
+    applyCommand(book, Command{CommandType::Market, false, 4, 1, 0, 0, 0, 25});
+    EXPECT_EQ(book->getTime(), 25);
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+    applyCommand(book, Command{CommandType::AddGoodTillTime, true, 5, 10, 99, 30});
+    applyCommand(book, Command{CommandType::ClockTick, false, 0, 0, 30, 0});
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyProtectedMarketCommand){
+    applyCommand(book, Command{CommandType::AddLimit, false, 1, 10, 100});
+    applyCommand(book, Command{CommandType::AddLimit, false, 2, 10, 103});
+    applyCommand(book, Command{CommandType::ProtectedMarket, true, 3, 15, 2, 1});
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 102);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 103);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyOwnedProtectedMarketCommandFromText){
+    book->setSelfTradePrevention(SelfTradePrevention::CancelOldest);
+    applyCommand(book, Command{CommandType::AddLimit, false, 1, 10, 100, 0, 0, 0, 4});
+    applyCommand(book, Command{CommandType::AddLimit, false, 2, 10, 101, 0, 0, 0, 5});
+    Command command;
+    ASSERT_TRUE(parseCommand(formatCommand(Command{CommandType::ProtectedMarket, true, 3, 5, 2, 0, 0, 0, 4}), command));
+    applyCommand(book, command);
+    EXPECT_EQ(book->getPreventedSelfTradeCount(), 1);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 101);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 5);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyAuctionCommands){
+    applyCommand(book, Command{CommandType::AuctionBegin});
+    applyCommand(book, Command{CommandType::AddLimit, true, 1, 10, 101});
+    applyCommand(book, Command{CommandType::AddLimit, false, 2, 4, 100});
+    EXPECT_TRUE(book->inAuction());
+    applyCommand(book, Command{CommandType::AuctionEnd, false, 0, 0, 100});
+    EXPECT_FALSE(book->inAuction());
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 6);
+    EXPECT_EQ(book->getLowestSell(), nullptr);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyOwnedMarketCommand){
+    book->setSelfTradePrevention(SelfTradePrevention::CancelOldest);
+    applyCommand(book, Command{CommandType::AddLimit, true, 1, 10, 100, 0, 0, 0, 4});
+    applyCommand(book, Command{CommandType::AddLimit, true, 2, 10, 99, 0, 0, 0, 5});
+    applyCommand(book, Command{CommandType::Market, false, 3, 5, 0, 0, 0, 0, 4});
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 99);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 5);
+}
+
+TEST_F(LimitOrderBookTests, TestApplyMassCancelCommands){
+    applyCommand(book, Command{CommandType::AddLimit, true, 1, 10, 99, 0, 0, 0, 5});
+    applyCommand(book, Command{CommandType::AddLimit, true, 2, 10, 98});
+    applyCommand(book, Command{CommandType::CancelOwner, false, 0, 0, 0, 0, 0, 0, 5});
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 98);
+    applyCommand(book, Command{CommandType::MassCancel, true, 0, 0, 90, 100});
+    EXPECT_EQ(book->getHighestBuy(), nullptr);
+}
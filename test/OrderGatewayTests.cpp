@@ -0,0 +1,172 @@
+#include "../Limit_Order_Book/Limit.hpp"
+#include "../Limit_Order_Book/Order.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Matching_Engine/MPSCQueue.hpp"
+#include "../Matching_Engine/OrderGateway.hpp"
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+struct OrderGatewayTests: public ::testing::Test
+{
+    Book* book;
+    OrderGateway* gateway;
+
+    virtual void SetUp() override{
+        book = new Book();
+        gateway = new OrderGateway(book, 1024);
+    }
+
+    virtual void TearDown() override{
+        delete gateway;
+        delete book;
+    }
+};
+
+// MPSC queue tests
+TEST(MPSCQueueTests, TestPopFromEmptyQueue){
+    MPSCQueue<int> queue(4);
+    int value;
+
+    EXPECT_FALSE(queue.tryPop(value));
+}
+
+TEST(MPSCQueueTests, TestItemsPoppedInPushOrder){
+    MPSCQueue<int> queue(4);
+    int value;
+
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_TRUE(queue.tryPush(3));
+
+    EXPECT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_FALSE(queue.tryPop(value));
+}
+
+TEST(MPSCQueueTests, TestPushToFullQueue){
+    MPSCQueue<int> queue(4);
+    int value;
+
+    EXPECT_EQ(queue.capacity(), 4);
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_FALSE(queue.tryPush(4));
+
+    EXPECT_TRUE(queue.tryPop(value));
+    EXPECT_TRUE(queue.tryPush(4));
+}
+
+TEST(MPSCQueueTests, TestMultipleProducersKeepPerProducerOrder){
+    MPSCQueue<std::pair<int, int>> queue(64);
+    const int producers = 4;
+    const int itemsPerProducer = 20000;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < itemsPerProducer; i++)
+            {
+                while (!queue.tryPush({p, i}))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> nextExpected(producers, 0);
+    int received = 0;
+    std::pair<int, int> item;
+    while (received < producers * itemsPerProducer)
+    {
+        if (queue.tryPop(item))
+        {
+            EXPECT_EQ(item.second, nextExpected[item.first]);
+            nextExpected[item.first] += 1;
+            received += 1;
+        }
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(received, producers * itemsPerProducer);
+}
+
+// Order gateway tests
+TEST_F(OrderGatewayTests, TestCommandsAppliedOnProcessPending){
+    ClientSession* session = gateway->connect();
+
+    std::uint64_t first = session->submit(Command{CommandType::AddLimit, true, 111, 10, 80, 0});
+    std::uint64_t second = session->submit(Command{CommandType::AddLimit, false, 112, 20, 90, 0});
+
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 2);
+    EXPECT_FALSE(session->isComplete(first));
+
+    EXPECT_EQ(gateway->processPending(), 2);
+
+    EXPECT_TRUE(session->isComplete(second));
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 80);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 90);
+}
+
+TEST_F(OrderGatewayTests, TestCompletionSignalledPerClient){
+    ClientSession* session1 = gateway->connect();
+    ClientSession* session2 = gateway->connect();
+
+    session1->submit(Command{CommandType::AddLimit, true, 111, 10, 80, 0});
+    session2->submit(Command{CommandType::AddLimit, true, 112, 10, 80, 0});
+    session2->submit(Command{CommandType::CancelLimit, true, 112, 0, 0, 0});
+
+    gateway->processPending();
+
+    EXPECT_EQ(session1->getCompletedSequence(), 1);
+    EXPECT_EQ(session2->getCompletedSequence(), 2);
+    EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), 10);
+}
+
+TEST_F(OrderGatewayTests, TestMatchingThreadAppliesCommandsFromManyClients){
+    const int clients = 4;
+    const int ordersPerClient = 500;
+    std::vector<ClientSession*> sessions;
+    for (int i = 0; i < clients; i++)
+    {
+        sessions.push_back(gateway->connect());
+    }
+    gateway->start();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; i++)
+    {
+        threads.emplace_back([&sessions, i]() {
+            std::uint64_t lastSequence = 0;
+            for (int j = 0; j < ordersPerClient; j++)
+            {
+                lastSequence = sessions[i]->submit(Command{CommandType::AddLimit, true, i * ordersPerClient + j + 1, 1, 50 + i, 0});
+            }
+            sessions[i]->waitFor(lastSequence);
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    gateway->stop();
+
+    for (int i = 0; i < clients; i++)
+    {
+        Limit* limit = book->searchLimitMaps(50 + i, true);
+        EXPECT_EQ(limit->getTotalVolume(), ordersPerClient);
+        EXPECT_EQ(limit->getHeadOrder()->getOrderId(), i * ordersPerClient + 1);
+    }
+}
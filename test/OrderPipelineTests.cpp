@@ -0,0 +1,780 @@
+#include "../Limit_Order_Book/Limit.hpp"
+#include "../Limit_Order_Book/Order.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Process_Orders/Command.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+#include "../Process_Orders/ParallelReplay.hpp"
+#include "../Process_Orders/HashTrace.hpp"
+#include "../Process_Orders/SeekableReplay.hpp"
+#include "../Process_Orders/ItchReader.hpp"
+#include "../Process_Orders/CommandTokenizer.hpp"
+#include "../Process_Orders/AsyncFileReader.hpp"
+
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Command parsing tests
+TEST(OrderPipelineTests, TestParseAddLimitCommand){
+    Command command;
+
+    EXPECT_TRUE(parseCommand("AddLimit 357 1 27 100", command));
+
+    EXPECT_EQ(command.type, CommandType::AddLimit);
+    EXPECT_EQ(command.orderId, 357);
+    EXPECT_TRUE(command.buyOrSell);
+    EXPECT_EQ(command.shares, 27);
+    EXPECT_EQ(command.limitPrice, 100);
+}
+
+// One line of each keyword added after the original order types, with the command it parses to
+static const std::vector<std::pair<std::string, Command>> keywordRows = {
+    {"ImmediateOrCancel 7 1 25 101", Command{CommandType::ImmediateOrCancel, true, 7, 25, 101, 0}},
+    {"FillOrKill 8 0 30 99", Command{CommandType::FillOrKill, false, 8, 30, 99, 0}},
+    {"AddIceberg 7 0 100 101 20", Command{CommandType::AddIceberg, false, 7, 100, 101, 20}},
+    {"AddPegged 7 1 100 1 -2", Command{CommandType::AddPegged, true, 7, 100, static_cast<int>(PegType::Midpoint), -2}},
+    {"CancelPegged 7", Command{CommandType::CancelPegged, false, 7, 0, 0, 0}},
+    {"AddTrailing 7 0 100 3", Command{CommandType::AddTrailingStop, false, 7, 100, 0, 3}},
+    {"CancelTrailing 7", Command{CommandType::CancelTrailingStop, false, 7, 0, 0, 0}},
+    {"AddLimitUntil 7 1 100 99 50", Command{CommandType::AddGoodTillTime, true, 7, 100, 99, 50}},
+    {"ClockTick 60 16", Command{CommandType::ClockTick, false, 0, 16, 60, 0}},
+    {"MarketProtected 4 1 40 2 1", Command{CommandType::ProtectedMarket, true, 4, 40, 2, 1}},
+    {"MarketProtectedFor 4 0 40 2 0 12", Command{CommandType::ProtectedMarket, false, 4, 40, 2, 0, 0, 0, 12}},
+    {"AuctionBegin", Command{CommandType::AuctionBegin, false, 0, 0, 0, 0}},
+    {"AuctionEnd 100", Command{CommandType::AuctionEnd, false, 0, 0, 100, 0}},
+    {"MarketFor 9 0 50 3", Command{CommandType::Market, false, 9, 50, 0, 0, 0, 0, 3}},
+    {"AddLimitFor 7 1 100 99 12", Command{CommandType::AddLimit, true, 7, 100, 99, 0, 0, 0, 12}},
+    {"CancelOwner 12", Command{CommandType::CancelOwner, false, 0, 0, 0, 0, 0, 0, 12}},
+    {"MassCancel 0 95 105", Command{CommandType::MassCancel, false, 0, 0, 95, 105}},
+    {"Symbol 2 AddLimitFor 7 1 100 99 12", Command{CommandType::AddLimit, true, 7, 100, 99, 0, 2, 0, 12}}
+};
+
+TEST(OrderPipelineTests, TestParseEveryOrderType){
+    Command command;
+
+    EXPECT_TRUE(parseCommand("Market 5 0 30", command));
+    EXPECT_EQ(command.type, CommandType::Market);
+    EXPECT_FALSE(command.buyOrSell);
+    EXPECT_EQ(command.shares, 30);
+
+    EXPECT_TRUE(parseCommand("AddMarketLimit 6 1 10 301", command));
+    EXPECT_EQ(command.type, CommandType::AddLimit);
+
+    EXPECT_TRUE(parseCommand("CancelStopLimit 7", command));
+    EXPECT_EQ(command.type, CommandType::CancelStopLimit);
+    EXPECT_EQ(command.orderId, 7);
+
+    EXPECT_TRUE(parseCommand("ModifyStopLimit 8 40 97 99", command));
+    EXPECT_EQ(command.type, CommandType::ModifyStopLimit);
+    EXPECT_EQ(command.shares, 40);
+    EXPECT_EQ(command.limitPrice, 97);
+    EXPECT_EQ(command.stopPrice, 99);
+
+    EXPECT_TRUE(parseCommand("AddStop 9 0 12 250", command));
+    EXPECT_EQ(command.type, CommandType::AddStop);
+    EXPECT_EQ(command.stopPrice, 250);
+
+    for (const auto& [line, expected] : keywordRows)
+    {
+        ASSERT_TRUE(parseCommand(line, command)) << line;
+        EXPECT_EQ(command.type, expected.type) << line;
+        EXPECT_EQ(command.buyOrSell, expected.buyOrSell) << line;
+        EXPECT_EQ(command.orderId, expected.orderId) << line;
+        EXPECT_EQ(command.shares, expected.shares) << line;
+        EXPECT_EQ(command.limitPrice, expected.limitPrice) << line;
+        EXPECT_EQ(command.stopPrice, expected.stopPrice) << line;
+        EXPECT_EQ(command.ownerId, expected.ownerId) << line;
+        EXPECT_EQ(command.symbolId, expected.symbolId) << line;
+        EXPECT_EQ(formatCommand(command), line);
+    }
+}
+
+TEST(OrderPipelineTests, TestParseInvalidCommands){
+    Command command;
+
+    EXPECT_FALSE(parseCommand("Unknown 1 2 3", command));
+    EXPECT_FALSE(parseCommand("AddLimit 1 1 10", command));
+    EXPECT_FALSE(parseCommand("", command));
+    EXPECT_FALSE(parseCommand("FillOrKill 8 0 30", command));
+    EXPECT_FALSE(parseCommand("AddIceberg 7 0 100 101", command));
+    EXPECT_FALSE(parseCommand("MarketProtected 4 1 40 2", command));
+    EXPECT_FALSE(parseCommand("MarketProtectedFor 4 1 40 2 1", command));
+    EXPECT_FALSE(parseCommand("AuctionEnd", command));
+    EXPECT_FALSE(parseCommand("AddLimit 1 1 10 2147483648", command));
+    EXPECT_FALSE(parseCommand("Market 9 1 12345678901234567", command));
+    EXPECT_FALSE(parseCommand("MassCancel 1 -2147483649 0", command));
+    EXPECT_FALSE(parseCommand("Symbol -1 CancelLimit 7", command));
+    EXPECT_FALSE(parseCommand("Symbol 3", command));
+
+    EXPECT_TRUE(parseCommand("MassCancel 1 -2147483648 2147483647", command));
+    EXPECT_EQ(command.limitPrice, INT_MIN);
+    EXPECT_EQ(command.stopPrice, INT_MAX);
+}
+
+TEST(OrderPipelineTests, TestLoadCommandsFromFile){
+    const char* filename = "test_load_commands.txt";
+    std::ofstream file(filename);
+    file << "AddLimit 1 1 10 100\n" << "AddLimit 2 0 20 110\r\n" << "CancelLimit 1\n";
+    file.close();
+
+    std::vector<Command> commands = OrderPipeline::loadCommandsFromFile(filename);
+    std::remove(filename);
+
+    ASSERT_EQ(commands.size(), 3);
+    EXPECT_EQ(commands[1].limitPrice, 110);
+    EXPECT_EQ(commands[2].type, CommandType::CancelLimit);
+}
+
+// Parallel replay tests
+TEST(ParallelReplayTests, TestParallelReplayMatchesSequentialReplay){
+    std::vector<std::vector<Command>> streams;
+    for (int i = 0; i < 4; i++)
+    {
+        std::vector<Command> stream;
+        for (int orderId = 1; orderId <= 200; orderId++)
+        {
+            stream.push_back(Command{CommandType::AddLimit, orderId % 2 == 0, orderId, orderId + i, orderId % 2 == 0 ? 90 : 110, 0});
+        }
+        stream.push_back(Command{CommandType::Market, true, 1000, 150 * (i + 1), 0, 0});
+        streams.push_back(stream);
+    }
+
+    ParallelReplay replay;
+    replay.setInitialCommands({Command{CommandType::AddLimit, true, 5000, 7, 50, 0}});
+    for (const std::vector<Command>& stream : streams)
+    {
+        replay.addStream(stream);
+    }
+    ParallelReplay::Report report = replay.run(3);
+
+    EXPECT_EQ(report.commands, 4 * 201);
+    EXPECT_EQ(report.threadReports.size(), 3);
+    int booksReplayed = 0;
+    for (const ParallelReplay::ThreadReport& threadReport : report.threadReports)
+    {
+        booksReplayed += threadReport.booksReplayed;
+    }
+    EXPECT_EQ(booksReplayed, 4);
+
+    for (int i = 0; i < 4; i++)
+    {
+        Book expected;
+        expected.addLimitOrder(5000, true, 7, 50);
+        for (const Command& command : streams[i])
+        {
+            applyCommand(&expected, command);
+        }
+        Book* book = replay.getBook(i);
+        EXPECT_EQ(book->getLowestSell()->getTotalVolume(), expected.getLowestSell()->getTotalVolume());
+        EXPECT_EQ(book->getLowestSell()->getHeadOrder()->getOrderId(), expected.getLowestSell()->getHeadOrder()->getOrderId());
+        EXPECT_EQ(book->getHighestBuy()->getTotalVolume(), expected.getHighestBuy()->getTotalVolume());
+        EXPECT_EQ(book->inOrderTreeTraversal(book->getBuyTree()), std::vector<int>({50, 90}));
+    }
+
+    replay.setHeapAllocation(true);
+    report = replay.run(2);
+    EXPECT_EQ(report.commands, 4 * 201);
+    EXPECT_EQ(replay.getBook(3)->inOrderTreeTraversal(replay.getBook(3)->getBuyTree()), std::vector<int>({50, 90}));
+}
+
+TEST(ParallelReplayTests, TestLatencyHistogramPercentiles){
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 100; i++)
+    {
+        histogram.record(i * 10);
+    }
+
+    EXPECT_EQ(histogram.getCount(), 100);
+    EXPECT_EQ(histogram.percentile(50), 510);
+    EXPECT_EQ(histogram.percentile(100), 1010);
+
+    LatencyHistogram other;
+    other.record(1000000);
+    histogram.merge(other);
+
+    EXPECT_EQ(histogram.getCount(), 101);
+    EXPECT_EQ(histogram.percentile(100), 100000);
+}
+
+// State hash tests
+TEST(HashTraceTests, TestStateHashDependsOnlyOnBookContents){
+    Book first;
+    Book second;
+    first.addLimitOrder(1, true, 10, 80);
+    first.addLimitOrder(2, false, 10, 90);
+    second.addLimitOrder(2, false, 10, 90);
+    second.addLimitOrder(3, true, 5, 85);
+    second.addLimitOrder(1, true, 10, 80);
+    second.cancelLimitOrder(3);
+
+    EXPECT_NE(first.getStateHash(), 0);
+    EXPECT_EQ(first.getStateHash(), second.getStateHash());
+
+    first.marketOrder(4, true, 3);
+
+    EXPECT_NE(first.getStateHash(), second.getStateHash());
+
+    first.cancelLimitOrder(1);
+    first.cancelLimitOrder(2);
+
+    EXPECT_EQ(first.getStateHash(), 0);
+}
+
+TEST(HashTraceTests, TestEqualIcebergReservesDoNotCancel){
+    Book icebergs;
+    Book plain;
+    icebergs.addIcebergOrder(1, true, 30, 80, 10);
+    icebergs.addIcebergOrder(2, true, 30, 80, 10);
+    plain.addLimitOrder(1, true, 10, 80);
+    plain.addLimitOrder(2, true, 10, 80);
+
+    EXPECT_NE(icebergs.getStateHash(), plain.getStateHash());
+}
+
+TEST(HashTraceTests, TestEqualExpiriesDoNotCancel){
+    Book expiring;
+    Book resting;
+    expiring.addGoodTillTimeOrder(1, true, 10, 80, 50);
+    expiring.addGoodTillTimeOrder(2, true, 10, 80, 50);
+    resting.addLimitOrder(1, true, 10, 80);
+    resting.addLimitOrder(2, true, 10, 80);
+
+    EXPECT_NE(expiring.getStateHash(), resting.getStateHash());
+}
+
+TEST(HashTraceTests, TestEqualOwnersDoNotCancel){
+    Book owned;
+    Book anonymous;
+    owned.addLimitOrder(1, true, 10, 80, 7);
+    owned.addLimitOrder(2, true, 10, 80, 7);
+    anonymous.addLimitOrder(1, true, 10, 80);
+    anonymous.addLimitOrder(2, true, 10, 80);
+
+    EXPECT_NE(owned.getStateHash(), anonymous.getStateHash());
+}
+
+TEST(HashTraceTests, TestStateHashSeesQueuePriority){
+    Book first;
+    Book second;
+    first.addLimitOrder(1, true, 10, 80);
+    first.addLimitOrder(2, true, 10, 80);
+    second.addLimitOrder(2, true, 10, 80);
+    second.addLimitOrder(1, true, 10, 80);
+
+    EXPECT_NE(first.getStateHash(), second.getStateHash());
+
+    // Positions survive a snapshot, including the gap left by a cancel
+    first.addLimitOrder(3, true, 10, 80);
+    first.cancelLimitOrder(2);
+    std::vector<char> snapshot = first.serializeSnapshot();
+    Book restored;
+    ASSERT_TRUE(restored.restoreSnapshot(snapshot.data(), snapshot.size()));
+    first.addLimitOrder(4, true, 10, 80);
+    restored.addLimitOrder(4, true, 10, 80);
+
+    EXPECT_EQ(restored.getStateHash(), first.getStateHash());
+    EXPECT_TRUE(restored.checkConsistency());
+}
+
+TEST(HashTraceTests, TestStateHashSurvivesSnapshotAndStopOrders){
+    Book book;
+    book.addLimitOrder(1, true, 10, 80);
+    book.addLimitOrder(2, false, 10, 90);
+    book.addStopOrder(3, true, 4, 95);
+    book.addStopLimitOrder(4, false, 6, 70, 75);
+    book.modifyStopLimitOrder(4, 8, 72, 76);
+
+    std::vector<char> snapshot = book.serializeSnapshot();
+    Book restored;
+    restored.restoreSnapshot(snapshot.data(), snapshot.size());
+
+    EXPECT_EQ(restored.getStateHash(), book.getStateHash());
+    EXPECT_TRUE(book.checkConsistency());
+
+    // Trigger the stop orders and check the hash still matches a full recount
+    book.marketOrder(5, true, 10);
+    book.marketOrder(6, false, 10);
+
+    EXPECT_TRUE(book.checkConsistency());
+}
+
+TEST(HashTraceTests, TestCompareReportsFirstDivergentSequence){
+    std::vector<Command> commands;
+    for (int orderId = 1; orderId <= 100; orderId++)
+    {
+        commands.push_back(Command{CommandType::AddLimit, orderId % 2 == 0, orderId, 10, orderId % 2 == 0 ? 90 : 110, 0});
+    }
+    std::vector<Command> altered = commands;
+    altered[36].shares = 11;
+
+    Book first;
+    Book second;
+    std::vector<HashCheckpoint> firstTrace = recordHashTrace(&first, commands, 1);
+    std::vector<HashCheckpoint> secondTrace = recordHashTrace(&second, altered, 1);
+    HashDivergence divergence = compareHashTraces(firstTrace, secondTrace);
+
+    EXPECT_EQ(firstTrace.size(), 100);
+    EXPECT_TRUE(divergence.diverged);
+    EXPECT_EQ(divergence.firstDivergentSequence, 37);
+    EXPECT_EQ(divergence.lastMatchingSequence, 36);
+    EXPECT_FALSE(compareHashTraces(firstTrace, firstTrace).diverged);
+}
+
+TEST(HashTraceTests, TestIntervalBelowOneIsRejected){
+    std::vector<Command> commands = {Command{CommandType::AddLimit, true, 1, 10, 90, 0}};
+    Book book;
+
+    EXPECT_TRUE(recordHashTrace(&book, commands, 0).empty());
+    EXPECT_TRUE(recordHashTrace(&book, commands, -5).empty());
+    EXPECT_EQ(book.getHighestBuy(), nullptr);
+}
+
+TEST(HashTraceTests, TestSaveAndLoadHashTrace){
+    const std::string filename = "test_hash_trace.txt";
+    std::vector<Command> commands;
+    for (int orderId = 1; orderId <= 25; orderId++)
+    {
+        commands.push_back(Command{CommandType::AddLimit, true, orderId, orderId, 100 - orderId, 0});
+    }
+    Book book;
+    std::vector<HashCheckpoint> trace = recordHashTrace(&book, commands, 10);
+
+    ASSERT_TRUE(saveHashTrace(filename, trace));
+    std::vector<HashCheckpoint> loaded = loadHashTrace(filename);
+    std::remove(filename.c_str());
+
+    ASSERT_EQ(loaded.size(), 3);
+    EXPECT_EQ(loaded[2].sequenceNumber, 25);
+    EXPECT_EQ(loaded[2].stateHash, book.getStateHash());
+    EXPECT_FALSE(compareHashTraces(trace, loaded).diverged);
+}
+
+// Seekable replay tests
+static std::vector<Command> mixedCommands(int count)
+{
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<> typeDist(0, 9);
+    std::uniform_int_distribution<> priceDist(90, 110);
+    std::uniform_int_distribution<> sharesDist(1, 50);
+    std::vector<Command> commands;
+    for (int orderId = 1; orderId <= count; orderId++)
+    {
+        int type = typeDist(gen);
+        bool buyOrSell = orderId % 2 == 0;
+        if (type < 6)
+        {
+            commands.push_back(Command{CommandType::AddLimit, buyOrSell, orderId, sharesDist(gen), priceDist(gen), 0});
+        } else if (type < 8) {
+            commands.push_back(Command{CommandType::Market, buyOrSell, orderId, sharesDist(gen), 0, 0});
+        } else {
+            commands.push_back(Command{CommandType::ModifyLimit, buyOrSell, orderId - 7, sharesDist(gen), priceDist(gen), 0});
+        }
+    }
+    return commands;
+}
+
+static std::uint64_t hashAfter(const std::vector<Command>& commands, std::uint64_t sequenceNumber)
+{
+    Book book;
+    for (std::uint64_t i = 0; i < sequenceNumber; i++)
+    {
+        applyCommand(&book, commands[i]);
+    }
+    return book.getStateHash();
+}
+
+TEST(SeekableReplayTests, TestSeekMatchesReplayFromStart){
+    std::vector<Command> commands = mixedCommands(1000);
+    SeekableReplay replay(commands, 64);
+    replay.buildCheckpoints();
+
+    EXPECT_EQ(replay.getNumberOfCheckpoints(), 16);
+
+    for (std::uint64_t target : {500, 520, 130, 0, 1000, 999, 640, 641})
+    {
+        ASSERT_TRUE(replay.seek(target));
+        EXPECT_EQ(replay.getPosition(), target);
+        EXPECT_EQ(replay.getBook()->getStateHash(), hashAfter(commands, target));
+    }
+    EXPECT_FALSE(replay.seek(1001));
+}
+
+TEST(SeekableReplayTests, TestCheckpointsFromSideFile){
+    const std::string filename = "test_checkpoints.bin";
+    std::vector<Command> commands = mixedCommands(300);
+    SeekableReplay original(commands, 50);
+    original.buildCheckpoints();
+    ASSERT_TRUE(original.saveCheckpoints(filename));
+
+    SeekableReplay loaded(commands, 50);
+    SeekableReplay wrongInterval(commands, 40);
+
+    EXPECT_TRUE(loaded.loadCheckpoints(filename));
+    EXPECT_FALSE(wrongInterval.loadCheckpoints(filename));
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(loaded.getCheckpointBytes(), original.getCheckpointBytes());
+    ASSERT_TRUE(loaded.seek(275));
+    EXPECT_EQ(loaded.getBook()->getStateHash(), hashAfter(commands, 275));
+}
+
+TEST(SeekableReplayTests, TestInvalidCheckpointsAreRejected){
+    std::vector<Command> commands = mixedCommands(300);
+    EXPECT_THROW(SeekableReplay(commands, 0), std::invalid_argument);
+
+    const std::string filename = "test_checkpoints.bin";
+    SeekableReplay original(std::vector<Command>(commands.begin(), commands.begin() + 150), 25);
+    original.buildCheckpoints();
+    ASSERT_TRUE(original.saveCheckpoints(filename));
+
+    // More checkpoints than a shorter stream can have
+    SeekableReplay shorter(std::vector<Command>(commands.begin(), commands.begin() + 100), 25);
+    EXPECT_FALSE(shorter.loadCheckpoints(filename));
+
+    // Checkpoints every 25 commands of a shorter stream passed off as every 50
+    std::uint64_t interval = 50;
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char*>(&interval), sizeof(interval));
+    file.close();
+    SeekableReplay mislabelled(commands, 50);
+    ASSERT_TRUE(mislabelled.loadCheckpoints(filename));
+    std::remove(filename.c_str());
+
+    EXPECT_FALSE(mislabelled.seek(75));
+    EXPECT_EQ(mislabelled.getPosition(), 0);
+    EXPECT_EQ(mislabelled.getBook()->getHighestBuy(), nullptr);
+    EXPECT_EQ(mislabelled.getBook()->getLowestSell(), nullptr);
+    ASSERT_TRUE(mislabelled.seek(25));
+    EXPECT_EQ(mislabelled.getBook()->getStateHash(), hashAfter(commands, 25));
+}
+
+// ITCH replay tests
+static ItchWriter sampleItchMessages()
+{
+    ItchWriter writer;
+    writer.systemEvent('O');
+    writer.stockDirectory(7, "AAPL");
+    writer.stockDirectory(9, "MSFT");
+    writer.addOrder(7, 1001, true, 100, "AAPL", 1500000);
+    writer.addOrder(7, 1002, true, 200, "AAPL", 1500000);
+    writer.addOrder(7, 1003, false, 300, "AAPL", 1501000);
+    writer.addOrder(9, 1004, true, 400, "MSFT", 3000000);
+    writer.orderExecuted(7, 1001, 40);
+    writer.orderCancel(7, 1003, 100);
+    writer.orderReplace(7, 1002, 1005, 150, 1499000);
+    writer.orderExecuted(7, 1001, 60);
+    writer.addOrder(7, 1006, false, 50, "AAPL", 1502000);
+    writer.orderDelete(7, 1006);
+    writer.orderDelete(9, 1004);
+    return writer;
+}
+
+TEST(ItchReaderTests, TestItchMessagesMapToCommands){
+    const std::string filename = "test_itch.bin";
+    ASSERT_TRUE(sampleItchMessages().save(filename));
+
+    ItchReader reader;
+    ASSERT_TRUE(reader.open(filename));
+    reader.selectSymbol("AAPL");
+    std::vector<Command> commands = reader.readCommands();
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(reader.getMessageCount(), 14);
+    EXPECT_EQ(reader.getStockLocate(), 7);
+    ASSERT_EQ(commands.size(), 10);
+    EXPECT_EQ(commands[0].type, CommandType::AddLimit);
+    EXPECT_EQ(commands[0].limitPrice, 1500000);
+    EXPECT_EQ(commands[2].buyOrSell, false);
+    EXPECT_EQ(commands[3].type, CommandType::ModifyLimit);
+    EXPECT_EQ(commands[3].orderId, 1);
+    EXPECT_EQ(commands[3].shares, 60);
+    EXPECT_EQ(commands[5].type, CommandType::CancelLimit);
+    EXPECT_EQ(commands[5].orderId, 2);
+    EXPECT_EQ(commands[6].type, CommandType::AddLimit);
+    EXPECT_EQ(commands[6].orderId, 2);
+    EXPECT_EQ(commands[6].buyOrSell, true);
+    EXPECT_EQ(commands[6].shares, 150);
+    EXPECT_EQ(commands[6].limitPrice, 1499000);
+    EXPECT_EQ(commands[7].type, CommandType::CancelLimit);
+    EXPECT_EQ(commands[7].orderId, 1);
+}
+
+TEST(ItchReaderTests, TestReplayItchFileIntoBook){
+    const std::string filename = "test_itch.bin";
+    ASSERT_TRUE(sampleItchMessages().save(filename));
+
+    Book book;
+    OrderPipeline pipeline(&book);
+    std::size_t applied = pipeline.processItchFile(filename, "AAPL");
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(applied, 10);
+    EXPECT_EQ(book.getHighestBuy()->getLimitPrice(), 1499000);
+    EXPECT_EQ(book.getHighestBuy()->getTotalVolume(), 150);
+    EXPECT_EQ(book.getLowestSell()->getLimitPrice(), 1501000);
+    EXPECT_EQ(book.getLowestSell()->getTotalVolume(), 200);
+    EXPECT_EQ(book.searchLimitMaps(1500000, true), nullptr);
+    EXPECT_EQ(book.searchLimitMaps(1502000, false), nullptr);
+}
+
+TEST(ItchReaderTests, TestReplaceAtSamePriceLosesPriority){
+    ItchWriter writer;
+    writer.addOrder(7, 1, true, 100, "AAPL", 1500000);
+    writer.addOrder(7, 2, true, 100, "AAPL", 1500000);
+    writer.orderReplace(7, 1, 3, 60, 1500000);
+    const std::string filename = "test_itch.bin";
+    ASSERT_TRUE(writer.save(filename));
+
+    ItchReader reader;
+    ASSERT_TRUE(reader.open(filename));
+    reader.selectSymbol("AAPL");
+    Book book;
+    EXPECT_EQ(reader.replay(&book), 4);
+    std::remove(filename.c_str());
+
+    Limit* level = book.getHighestBuy();
+    EXPECT_EQ(level->getTotalVolume(), 160);
+    EXPECT_EQ(level->getHeadOrder()->getOrderId(), 2);
+    EXPECT_EQ(level->getHeadOrder()->getNextOrder()->getOrderId(), 1);
+    EXPECT_EQ(level->getHeadOrder()->getNextOrder()->getShares(), 60);
+
+    Book expected;
+    expected.addLimitOrder(1, true, 100, 1500000);
+    expected.addLimitOrder(2, true, 100, 1500000);
+    expected.cancelLimitOrder(1);
+    expected.addLimitOrder(1, true, 60, 1500000);
+    EXPECT_EQ(book.getStateHash(), expected.getStateHash());
+}
+
+TEST(ItchReaderTests, TestSymbolWithoutStockDirectory){
+    ItchWriter writer;
+    writer.addOrder(3, 1, true, 10, "IBM", 1000);
+    writer.addOrder(4, 2, true, 10, "ORCL", 2000);
+    writer.orderCancel(3, 1, 4);
+    const std::string filename = "test_itch.bin";
+    ASSERT_TRUE(writer.save(filename));
+
+    ItchReader reader;
+    ASSERT_TRUE(reader.open(filename));
+    reader.selectSymbol("IBM");
+    Book book;
+
+    EXPECT_EQ(reader.replay(&book), 2);
+    std::remove(filename.c_str());
+    EXPECT_EQ(reader.getStockLocate(), 3);
+    EXPECT_EQ(book.getHighestBuy()->getTotalVolume(), 6);
+}
+
+// Parallel parsing tests
+TEST(OrderPipelineTests, TestFormatCommandRoundTrip){
+    std::vector<Command> commands = {
+        Command{CommandType::Market, true, 1, 10, 0, 0},
+        Command{CommandType::AddLimit, false, 2, 20, 105, 0},
+        Command{CommandType::ModifyStopLimit, false, 3, 30, 95, 97},
+        Command{CommandType::CancelStop, false, 4, 0, 0, 0}
+    };
+    for (const Command& command : commands)
+    {
+        Command parsed;
+        ASSERT_TRUE(parseCommand(formatCommand(command), parsed));
+        EXPECT_EQ(parsed.type, command.type);
+        EXPECT_EQ(parsed.orderId, command.orderId);
+        EXPECT_EQ(parsed.shares, command.shares);
+        EXPECT_EQ(parsed.limitPrice, command.limitPrice);
+        EXPECT_EQ(parsed.stopPrice, command.stopPrice);
+    }
+}
+
+TEST(OrderPipelineTests, TestParallelProcessingMatchesSequential){
+    const std::string filename = "test_parallel_orders.txt";
+    std::vector<Command> commands = mixedCommands(2000);
+    std::ofstream file(filename);
+    for (std::size_t i = 0; i < commands.size(); i++)
+    {
+        file << formatCommand(commands[i]) << (i % 3 == 0 ? "\r\n" : "\n");
+    }
+    // Last line without a trailing newline
+    file << "AddLimit 5000 1 10 95";
+    file.close();
+
+    Book sequential;
+    for (const Command& command : OrderPipeline::loadCommandsFromFile(filename))
+    {
+        applyCommand(&sequential, command);
+    }
+    for (int workers : {1, 3, 8})
+    {
+        Book parallel;
+        OrderPipeline pipeline(&parallel);
+
+        EXPECT_EQ(pipeline.processOrdersParallel(filename, workers, 100), 2001);
+        EXPECT_EQ(parallel.getStateHash(), sequential.getStateHash());
+    }
+    std::remove(filename.c_str());
+}
+
+// SIMD tokenizer tests
+static void expectSameCommands(const std::vector<Command>& actual, const std::vector<Command>& expected)
+{
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(actual[i].type, expected[i].type) << "command " << i;
+        EXPECT_EQ(actual[i].buyOrSell, expected[i].buyOrSell) << "command " << i;
+        EXPECT_EQ(actual[i].orderId, expected[i].orderId) << "command " << i;
+        EXPECT_EQ(actual[i].shares, expected[i].shares) << "command " << i;
+        EXPECT_EQ(actual[i].limitPrice, expected[i].limitPrice) << "command " << i;
+        EXPECT_EQ(actual[i].stopPrice, expected[i].stopPrice) << "command " << i;
+        EXPECT_EQ(actual[i].ownerId, expected[i].ownerId) << "command " << i;
+        EXPECT_EQ(actual[i].symbolId, expected[i].symbolId) << "command " << i;
+    }
+}
+
+TEST(CommandTokenizerTests, TestEveryKindMatchesParseCommand){
+    std::vector<std::string> lines;
+    std::vector<Command> mixed = mixedCommands(3000);
+    for (std::size_t i = 0; i < mixed.size(); i++)
+    {
+        lines.push_back(formatCommand(mixed[i]));
+        // Mix every keyword in at shifting offsets within the tokenizer blocks
+        if (i % 7 == 0)
+        {
+            lines.push_back(keywordRows[(i / 7) % keywordRows.size()].first);
+        }
+    }
+    std::string text;
+    std::vector<Command> expected;
+    for (const std::string& line : lines)
+    {
+        Command parsed;
+        ASSERT_TRUE(parseCommand(line, parsed)) << line;
+        text += line + "\n";
+        expected.push_back(parsed);
+    }
+    for (TokenizerKind kind : {TokenizerKind::Scalar, TokenizerKind::SSE42, TokenizerKind::AVX2})
+    {
+        if (!isTokenizerSupported(kind))
+        {
+            continue;
+        }
+        std::vector<Command> commands;
+        EXPECT_EQ(tokenizeCommands(text.data(), text.data() + text.size(), commands, kind), 0) << getTokenizerName(kind);
+        expectSameCommands(commands, expected);
+    }
+}
+
+TEST(CommandTokenizerTests, TestIrregularLinesMatchScalar){
+    std::string text =
+        "AddLimit 1 1 100 95\r\n"
+        "AddLimit  2 0   50 105\n"
+        "\n"
+        "\r\n"
+        "AddLimit 3 1 -5 94\n"
+        "Unknown 4 1 10\n"
+        " AddLimit 5 1 10 95\n"
+        "AddLimit 6 1 10\n"
+        "CancelLimit 1 trailing tokens\n"
+        "AddStopLimit 7 0 2147483647 1234567890 123456789012\n"
+        "AddLimit 8 1 10 95abc\n"
+        "Market 9 1 12345678901234567\n"
+        "CancelLimit 10\r\r\n"
+        "ModifyStop 11 25\r99\n"
+        "   \n"
+        "AddMarketLimit 12 0 1 1\n";
+    // The lines for orders 7 and 9 hold numbers that overflow int, so every tokenizer rejects them
+    std::string overflow = "AddStopLimit 7 0 2147483647 1234567890 123456789012\nMarket 9 1 12345678901234567\n";
+    for (TokenizerKind kind : {TokenizerKind::Scalar, TokenizerKind::SSE42, TokenizerKind::AVX2})
+    {
+        if (!isTokenizerSupported(kind))
+        {
+            continue;
+        }
+        std::vector<Command> commands;
+        EXPECT_EQ(tokenizeCommands(overflow.data(), overflow.data() + overflow.size(), commands, kind), 2);
+        EXPECT_TRUE(commands.empty());
+    }
+    // Shift the lines across block boundaries and end with a line that has no newline
+    for (int padding = 0; padding < 70; padding++)
+    {
+        std::string shifted = std::string(padding, '\n') + text + "ModifyStopLimit 13 14 15 16";
+        std::vector<Command> expected;
+        std::size_t expectedInvalid = tokenizeCommands(shifted.data(), shifted.data() + shifted.size(), expected, TokenizerKind::Scalar);
+        ASSERT_GT(expectedInvalid, 0);
+        for (TokenizerKind kind : {TokenizerKind::SSE42, TokenizerKind::AVX2})
+        {
+            if (!isTokenizerSupported(kind))
+            {
+                continue;
+            }
+            std::vector<Command> commands;
+            EXPECT_EQ(tokenizeCommands(shifted.data(), shifted.data() + shifted.size(), commands, kind), expectedInvalid);
+            expectSameCommands(commands, expected);
+        }
+    }
+}
+
+TEST(CommandTokenizerTests, TestBestTokenizerIsSupported){
+    EXPECT_TRUE(isTokenizerSupported(TokenizerKind::Scalar));
+    EXPECT_TRUE(isTokenizerSupported(getBestTokenizer()));
+}
+
+// Asynchronous ingestion tests
+TEST(AsyncFileReaderTests, TestBuffersReturnFileInOrder){
+    const std::string filename = "test_async_reader.bin";
+    std::string contents;
+    for (int i = 0; i < 30000; i++)
+    {
+        contents.push_back(static_cast<char>('a' + i % 26));
+    }
+    std::ofstream(filename, std::ios::binary) << contents;
+
+    for (AsyncFileReader::Backend backend : {AsyncFileReader::Backend::IoUring, AsyncFileReader::Backend::ReadAheadThread})
+    {
+        AsyncFileReader reader(4096, 3);
+        ASSERT_TRUE(reader.open(filename, backend));
+        EXPECT_EQ(reader.getFileSize(), contents.size());
+        std::string read;
+        const char* data;
+        std::size_t size;
+        while (reader.next(data, size))
+        {
+            read.append(data, size);
+        }
+        EXPECT_EQ(read, contents);
+    }
+    std::remove(filename.c_str());
+
+    AsyncFileReader reader;
+    EXPECT_FALSE(reader.open("missing_async_reader.bin"));
+}
+
+TEST(AsyncFileReaderTests, TestAsyncProcessingMatchesSequential){
+    const std::string filename = "test_async_orders.txt";
+    std::vector<Command> commands = mixedCommands(3000);
+    std::ofstream file(filename);
+    for (std::size_t i = 0; i < commands.size(); i++)
+    {
+        file << formatCommand(commands[i]) << (i % 4 == 0 ? "\r\n" : "\n");
+    }
+    file << "AddLimit 5000 1 10 95";
+    file.close();
+
+    Book sequential;
+    for (const Command& command : OrderPipeline::loadCommandsFromFile(filename))
+    {
+        applyCommand(&sequential, command);
+    }
+    for (AsyncFileReader::Backend backend : {AsyncFileReader::Backend::IoUring, AsyncFileReader::Backend::ReadAheadThread})
+    {
+        Book book;
+        OrderPipeline pipeline(&book);
+        // Small buffers so lines are split across buffers many times
+        EXPECT_EQ(pipeline.processOrdersAsync(filename, backend, 4096, 2), 3001);
+        EXPECT_EQ(book.getStateHash(), sequential.getStateHash());
+    }
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,338 @@
+#include "../Limit_Order_Book/Limit.hpp"
+#include "../Limit_Order_Book/Order.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Persistence/CommandJournal.hpp"
+#include "../Persistence/MappedBook.hpp"
+#include "../Persistence/ForkCheckpointer.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct PersistenceTests: public ::testing::Test
+{
+    const std::string journalFile = "test_persistence.journal";
+    const std::string snapshotFile = "test_persistence.snapshot";
+
+    virtual void SetUp() override{
+        std::remove(journalFile.c_str());
+        std::remove(snapshotFile.c_str());
+    }
+
+    virtual void TearDown() override{
+        std::remove(journalFile.c_str());
+        std::remove(snapshotFile.c_str());
+    }
+};
+
+// Command journal tests
+TEST_F(PersistenceTests, TestJournalRecordsAreSequencedAndDurable){
+    CommandJournal journal(8);
+    ASSERT_TRUE(journal.open(journalFile, true));
+
+    for (int orderId = 1; orderId <= 20; orderId++)
+    {
+        EXPECT_EQ(journal.append(Command{CommandType::AddLimit, true, orderId, 10, 80, 0}), orderId);
+    }
+    journal.waitForDurable(20);
+    journal.close();
+
+    EXPECT_EQ(journal.getDurableSequence(), 20);
+    EXPECT_GE(journal.getGroupCommitCount(), 3);
+
+    std::vector<JournalRecord> records = CommandJournal::readJournal(journalFile);
+    ASSERT_EQ(records.size(), 20);
+    EXPECT_EQ(records[0].sequenceNumber, 1);
+    EXPECT_EQ(records[19].sequenceNumber, 20);
+    EXPECT_EQ(records[19].command.orderId, 20);
+}
+
+TEST_F(PersistenceTests, TestReopenedJournalContinuesSequence){
+    CommandJournal journal;
+    journal.open(journalFile, true);
+    journal.append(Command{CommandType::AddLimit, true, 1, 10, 80, 0});
+    journal.append(Command{CommandType::AddLimit, true, 2, 10, 80, 0});
+    journal.close();
+
+    // Simulate a crash part way through writing a record
+    std::ofstream torn(journalFile, std::ios::binary | std::ios::app);
+    torn.write("torn", 4);
+    torn.close();
+
+    journal.open(journalFile);
+    EXPECT_EQ(journal.append(Command{CommandType::CancelLimit, true, 1, 0, 0, 0}), 3);
+    journal.close();
+
+    std::vector<JournalRecord> records = CommandJournal::readJournal(journalFile);
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[2].command.type, CommandType::CancelLimit);
+}
+
+TEST_F(PersistenceTests, TestJournalWithAnotherLayoutIsRejected){
+    JournalHeader header{{'L', 'O', 'B', 'J', 'R', 'N', 'L', '\0'}, 0, sizeof(JournalRecord)};
+    std::ofstream old(journalFile, std::ios::binary);
+    old.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    JournalRecord record{1, Command{CommandType::AddLimit, true, 1, 10, 80, 0}, 0};
+    old.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    old.close();
+
+    CommandJournal journal;
+    EXPECT_FALSE(journal.open(journalFile));
+    EXPECT_TRUE(CommandJournal::readJournal(journalFile).empty());
+    Book book;
+    EXPECT_EQ(recoverBook(&book, snapshotFile, journalFile), 0);
+    EXPECT_EQ(book.getHighestBuy(), nullptr);
+}
+
+TEST_F(PersistenceTests, TestCorruptRecordStopsReplay){
+    CommandJournal journal;
+    journal.open(journalFile, true);
+    journal.append(Command{CommandType::AddLimit, true, 1, 10, 80, 0});
+    journal.append(Command{CommandType::AddLimit, true, 2, 10, 80, 0});
+    journal.append(Command{CommandType::AddLimit, true, 3, 10, 80, 0});
+    journal.close();
+
+    // Flip the order id of the second record
+    std::fstream file(journalFile, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sizeof(JournalHeader) + sizeof(JournalRecord) + offsetof(JournalRecord, command) + offsetof(Command, orderId));
+    file.put(7);
+    file.close();
+
+    EXPECT_EQ(CommandJournal::readJournal(journalFile).size(), 1);
+    Book book;
+    EXPECT_EQ(recoverBook(&book, snapshotFile, journalFile), 1);
+    EXPECT_EQ(book.getHighestBuy()->getSize(), 1);
+}
+
+TEST_F(PersistenceTests, TestReopenedJournalDropsCorruptLastRecord){
+    CommandJournal journal;
+    journal.open(journalFile, true);
+    journal.append(Command{CommandType::AddLimit, true, 1, 10, 80, 0});
+    journal.append(Command{CommandType::AddLimit, true, 2, 10, 80, 0});
+    journal.close();
+
+    // Flip the order id of the last record
+    std::fstream file(journalFile, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sizeof(JournalHeader) + sizeof(JournalRecord) + offsetof(JournalRecord, command) + offsetof(Command, orderId));
+    file.put(7);
+    file.close();
+
+    journal.open(journalFile);
+    EXPECT_EQ(journal.append(Command{CommandType::AddLimit, true, 3, 10, 80, 0}), 2);
+    journal.close();
+
+    std::vector<JournalRecord> records = CommandJournal::readJournal(journalFile);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[1].sequenceNumber, 2);
+    EXPECT_EQ(records[1].command.orderId, 3);
+}
+
+TEST_F(PersistenceTests, TestFailedWriteIsNotDurable){
+    CommandJournal journal;
+    ASSERT_TRUE(journal.open(journalFile, true));
+    ASSERT_EQ(journal.append(Command{CommandType::AddLimit, true, 1, 10, 80, 0}), 1);
+    ASSERT_TRUE(journal.waitForDurable(1));
+
+    // Cap the file size so the next group commit cannot be written in full
+    rlimit previousLimit;
+    getrlimit(RLIMIT_FSIZE, &previousLimit);
+    rlimit limit = previousLimit;
+    limit.rlim_cur = sizeof(JournalHeader) + sizeof(JournalRecord) + sizeof(JournalRecord) / 2;
+    auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+
+    for (int orderId = 2; orderId <= 10; orderId++)
+    {
+        journal.append(Command{CommandType::AddLimit, true, orderId, 10, 80, 0});
+    }
+    EXPECT_FALSE(journal.waitForDurable(10));
+    EXPECT_TRUE(journal.hasFailed());
+    EXPECT_LT(journal.getDurableSequence(), 10);
+    EXPECT_EQ(journal.append(Command{CommandType::AddLimit, true, 11, 10, 80, 0}), 0);
+    journal.close();
+
+    setrlimit(RLIMIT_FSIZE, &previousLimit);
+    std::signal(SIGXFSZ, previousHandler);
+    EXPECT_EQ(CommandJournal::readJournal(journalFile).size(), 1);
+}
+
+// Recovery tests
+TEST_F(PersistenceTests, TestRecoverFromJournalOnly){
+    CommandJournal journal;
+    journal.open(journalFile, true);
+    journal.append(Command{CommandType::AddLimit, true, 1, 10, 80, 0});
+    journal.append(Command{CommandType::AddLimit, false, 2, 20, 90, 0});
+    journal.append(Command{CommandType::Market, true, 3, 5, 0, 0});
+    journal.close();
+
+    Book book;
+    EXPECT_EQ(recoverBook(&book, snapshotFile, journalFile), 3);
+
+    EXPECT_EQ(book.getHighestBuy()->getTotalVolume(), 10);
+    EXPECT_EQ(book.getLowestSell()->getTotalVolume(), 15);
+}
+
+TEST_F(PersistenceTests, TestRecoverFromSnapshotAndJournalTail){
+    Book live;
+    CommandJournal journal;
+    journal.open(journalFile, true);
+    std::vector<Command> commands = {
+        Command{CommandType::AddLimit, true, 1, 10, 80, 0},
+        Command{CommandType::AddLimit, true, 2, 20, 80, 0},
+        Command{CommandType::AddLimit, false, 3, 30, 90, 0},
+        Command{CommandType::CancelLimit, true, 1, 0, 0, 0},
+        Command{CommandType::Market, false, 4, 5, 0, 0}
+    };
+    for (std::size_t i = 0; i < commands.size(); i++)
+    {
+        std::uint64_t sequenceNumber = journal.append(commands[i]);
+        applyCommand(&live, commands[i]);
+        if (i == 2)
+        {
+            live.saveSnapshot(snapshotFile, sequenceNumber);
+        }
+    }
+    journal.close();
+
+    Book recovered;
+    EXPECT_EQ(recoverBook(&recovered, snapshotFile, journalFile), 5);
+
+    EXPECT_EQ(recovered.getHighestBuy()->getTotalVolume(), live.getHighestBuy()->getTotalVolume());
+    EXPECT_EQ(recovered.getHighestBuy()->getHeadOrder()->getOrderId(), 2);
+    EXPECT_EQ(recovered.getHighestBuy()->getHeadOrder()->getShares(), 15);
+    EXPECT_EQ(recovered.searchOrderMap(1), nullptr);
+    EXPECT_EQ(recovered.getLowestSell()->getTotalVolume(), 30);
+}
+
+// Memory-mapped book tests
+TEST_F(PersistenceTests, TestMappedBookSurvivesReopen){
+    const std::string bookFile = "test_persistence.book";
+    {
+        MappedBook mapped;
+        ASSERT_TRUE(mapped.create(bookFile, 1 << 24));
+        Book* book = mapped.getBook();
+        for (int orderId = 1; orderId <= 1000; orderId++)
+        {
+            book->addLimitOrder(orderId, orderId % 2 == 0, 10, orderId % 2 == 0 ? 100 - orderId % 40 : 101 + orderId % 40);
+        }
+        book->marketOrder(1001, true, 25);
+        mapped.setSequenceNumber(1001);
+        mapped.close();
+    }
+
+    MappedBook reopened;
+    ASSERT_TRUE(reopened.open(bookFile, true));
+    Book* book = reopened.getBook();
+
+    EXPECT_EQ(reopened.getSequenceNumber(), 1001);
+    EXPECT_EQ(book->getHighestBuy()->getLimitPrice(), 100);
+    EXPECT_EQ(book->getLowestSell()->getLimitPrice(), 102);
+    EXPECT_EQ(book->getLowestSell()->getTotalVolume(), 225);
+    EXPECT_EQ(book->searchOrderMap(500)->getShares(), 10);
+
+    book->cancelLimitOrder(500);
+    book->addLimitOrder(1002, false, 7, 150);
+
+    EXPECT_EQ(book->searchOrderMap(500), nullptr);
+    EXPECT_EQ(book->searchLimitMaps(150, false)->getTotalVolume(), 7);
+    EXPECT_TRUE(book->checkConsistency());
+    reopened.close();
+    std::remove(bookFile.c_str());
+}
+
+TEST_F(PersistenceTests, TestMappedBookRecoversAfterCrash){
+    const std::string bookFile = "test_persistence.book";
+    pid_t child = fork();
+    if (child == 0)
+    {
+        MappedBook mapped;
+        mapped.create(bookFile, 1 << 24);
+        mapped.getBook()->addLimitOrder(1, true, 10, 80);
+        mapped.getBook()->addLimitOrder(2, false, 10, 90);
+        // Exit without closing, as a crash would
+        _exit(0);
+    }
+    waitpid(child, nullptr, 0);
+
+    MappedBook reopened;
+    ASSERT_TRUE(reopened.open(bookFile));
+
+    EXPECT_EQ(reopened.getBook()->getHighestBuy()->getTotalVolume(), 10);
+    EXPECT_EQ(reopened.getBook()->getLowestSell()->getLimitPrice(), 90);
+    reopened.close();
+    std::remove(bookFile.c_str());
+}
+
+TEST_F(PersistenceTests, TestMappedBookRejectsInvalidFile){
+    std::ofstream file(journalFile, std::ios::binary);
+    file << "not a book";
+    file.close();
+
+    MappedBook mapped;
+
+    EXPECT_FALSE(mapped.open(journalFile));
+    EXPECT_FALSE(mapped.isOpen());
+}
+
+// Fork checkpoint tests
+TEST_F(PersistenceTests, TestCheckpointCapturesBookAtFork){
+    Book book;
+    book.addLimitOrder(1, true, 10, 80);
+    book.addLimitOrder(2, false, 10, 90);
+
+    ForkCheckpointer checkpointer;
+    ASSERT_TRUE(checkpointer.start(&book, snapshotFile, 2));
+    EXPECT_FALSE(checkpointer.start(&book, snapshotFile, 2));
+
+    // Changes made while the child is writing are not part of the checkpoint
+    book.addLimitOrder(3, true, 10, 85);
+    book.cancelLimitOrder(2);
+    checkpointer.wait();
+
+    EXPECT_FALSE(checkpointer.isRunning());
+    EXPECT_TRUE(checkpointer.getLastSucceeded());
+    EXPECT_GT(checkpointer.getLastSize(), 0);
+    EXPECT_EQ(checkpointer.getCheckpointCount(), 1);
+
+    Book restored;
+    std::uint64_t sequenceNumber = 0;
+    ASSERT_TRUE(restored.loadSnapshot(snapshotFile, &sequenceNumber));
+
+    EXPECT_EQ(sequenceNumber, 2);
+    EXPECT_EQ(restored.getHighestBuy()->getLimitPrice(), 80);
+    EXPECT_EQ(restored.getLowestSell()->getLimitPrice(), 90);
+    EXPECT_EQ(restored.searchOrderMap(3), nullptr);
+}
+
+TEST_F(PersistenceTests, TestRecoverFromCheckpointAndJournalTail){
+    Book live;
+    CommandJournal journal;
+    journal.open(journalFile, true);
+    ForkCheckpointer checkpointer;
+    for (int orderId = 1; orderId <= 200; orderId++)
+    {
+        Command command{CommandType::AddLimit, orderId % 2 == 0, orderId, 10, orderId % 2 == 0 ? 90 : 110, 0};
+        std::uint64_t sequenceNumber = journal.append(command);
+        applyCommand(&live, command);
+        if (orderId == 120)
+        {
+            checkpointer.start(&live, snapshotFile, sequenceNumber);
+        }
+        checkpointer.poll();
+    }
+    journal.close();
+    checkpointer.wait();
+
+    Book recovered;
+    EXPECT_EQ(recoverBook(&recovered, snapshotFile, journalFile), 200);
+
+    EXPECT_EQ(checkpointer.getLastSequenceNumber(), 120);
+    EXPECT_EQ(recovered.getHighestBuy()->getTotalVolume(), 1000);
+    EXPECT_EQ(recovered.getLowestSell()->getSize(), 100);
+}
@@ -0,0 +1,143 @@
+#include "../Limit_Order_Book/Limit.hpp"
+#include "../Limit_Order_Book/Order.hpp"
+#include "../Limit_Order_Book/Book.hpp"
+#include "../Matching_Engine/Replication.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct ReplicationTests: public ::testing::Test
+{
+    std::string ringName;
+    ReplicationRing primaryRing;
+    ReplicationRing standbyRing;
+
+    virtual void SetUp() override{
+        ringName = "/lob_replication_test_" + std::to_string(getpid());
+        ASSERT_TRUE(primaryRing.create(ringName, 64));
+        ASSERT_TRUE(standbyRing.attach(ringName));
+    }
+
+    virtual void TearDown() override{
+        standbyRing.close();
+        primaryRing.close();
+    }
+};
+
+static std::vector<Command> replicationCommands()
+{
+    std::vector<Command> commands;
+    for (int orderId = 1; orderId <= 40; orderId++)
+    {
+        commands.push_back(Command{CommandType::AddLimit, orderId % 2 == 0, orderId, 10, orderId % 2 == 0 ? 90 - orderId % 5 : 110 + orderId % 5, 0});
+    }
+    commands.push_back(Command{CommandType::Market, true, 41, 25, 0, 0});
+    commands.push_back(Command{CommandType::CancelLimit, true, 20, 0, 0, 0});
+    commands.push_back(Command{CommandType::ModifyLimit, false, 21, 5, 115, 0});
+    return commands;
+}
+
+TEST_F(ReplicationTests, TestStandbyMatchesPrimary){
+    Book primaryBook;
+    Book standbyBook;
+    ReplicationPrimary primary(&primaryBook, &primaryRing, 8);
+    StandbyReplica standby(&standbyBook, &standbyRing);
+
+    for (const Command& command : replicationCommands())
+    {
+        primary.apply(command);
+    }
+
+    EXPECT_EQ(standby.poll(), 43);
+    EXPECT_EQ(standby.getSequenceNumber(), 43);
+    EXPECT_EQ(standbyBook.getStateHash(), primaryBook.getStateHash());
+    EXPECT_EQ(standbyRing.getHashChecks(), 5);
+    EXPECT_EQ(primaryRing.getHashMismatches(), 0);
+}
+
+TEST_F(ReplicationTests, TestStandbyDetectsDivergence){
+    Book primaryBook;
+    Book standbyBook;
+    ReplicationPrimary primary(&primaryBook, &primaryRing, 4);
+    StandbyReplica standby(&standbyBook, &standbyRing);
+
+    std::vector<Command> commands = replicationCommands();
+    for (int i = 0; i < 10; i++)
+    {
+        primary.apply(commands[i]);
+    }
+    standby.poll();
+    standbyBook.addLimitOrder(1000, true, 1, 50);
+    for (int i = 10; i < 20; i++)
+    {
+        primary.apply(commands[i]);
+    }
+    standby.poll();
+
+    EXPECT_EQ(primaryRing.getHashChecks(), 5);
+    EXPECT_EQ(primaryRing.getHashMismatches(), 3);
+    EXPECT_EQ(primaryRing.getFirstMismatchSequence(), 12);
+}
+
+TEST_F(ReplicationTests, TestZeroHashIntervalIsRejected){
+    Book primaryBook;
+    EXPECT_THROW(ReplicationPrimary(&primaryBook, &primaryRing, 0), std::invalid_argument);
+}
+
+TEST_F(ReplicationTests, TestPromoteDrainsRingAndSwitchesRole){
+    Book primaryBook;
+    Book standbyBook;
+    ReplicationPrimary primary(&primaryBook, &primaryRing);
+    StandbyReplica standby(&standbyBook, &standbyRing);
+
+    for (const Command& command : replicationCommands())
+    {
+        primary.apply(command);
+    }
+    Book* promoted = standby.promote();
+
+    EXPECT_TRUE(standby.isPrimary());
+    EXPECT_EQ(promoted, &standbyBook);
+    EXPECT_EQ(standby.getSequenceNumber(), primary.getSequenceNumber());
+    EXPECT_EQ(promoted->getStateHash(), primaryBook.getStateHash());
+
+    // A promoted replica stops consuming
+    primary.apply(Command{CommandType::AddLimit, true, 100, 1, 80, 0});
+    EXPECT_EQ(standby.poll(), 0);
+}
+
+TEST_F(ReplicationTests, TestStandbyInSeparateProcess){
+    pid_t child = fork();
+    if (child == 0)
+    {
+        // The ring is smaller than the stream, so the primary has to wait for this process
+        ReplicationRing ring;
+        ring.attach(ringName);
+        Book book;
+        StandbyReplica standby(&book, &ring);
+        std::atomic<bool> stop(false);
+        standby.run(stop);
+        _exit(standby.getSequenceNumber() == 1000 ? 0 : 1);
+    }
+
+    Book primaryBook;
+    ReplicationPrimary primary(&primaryBook, &primaryRing, 100);
+    for (int orderId = 1; orderId <= 1000; orderId++)
+    {
+        bool buyOrSell = orderId % 3 != 0;
+        primary.apply(Command{orderId % 7 == 0 ? CommandType::Market : CommandType::AddLimit, buyOrSell, orderId, 5, buyOrSell ? 95 : 105, 0});
+    }
+    primaryRing.finish();
+    int status;
+    waitpid(child, &status, 0);
+
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(primaryRing.getHashChecks(), 10);
+    EXPECT_EQ(primaryRing.getHashMismatches(), 0);
+}